@@ -0,0 +1,69 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Helpers for benchmarks
+//
+
+// Runs fn(i) iterations times after a short warm-up, and prints the
+// per-call cost
+exports.run = function(name, iterations, fn) {
+  var i, warmup = Math.min(1000, iterations);
+  for (i = 0; i < warmup; i++)
+    fn(i);
+
+  var start = process.hrtime();
+  for (i = 0; i < iterations; i++)
+    fn(i);
+  var elapsed = process.hrtime(start);
+
+  var ns = (elapsed[0] * 1e9 + elapsed[1]) / iterations;
+  console.log('  ' + name + ': ' + ns.toFixed(1) + ' ns/call (' +
+              iterations + ' calls)');
+  return ns;
+}
+
+// Like run(), for calls that each process count items. Prints millions of
+// items per second, e.g. unit 'MPix/s'
+exports.throughput = function(name, iterations, count, unit, fn) {
+  var i, warmup = Math.min(10, iterations);
+  for (i = 0; i < warmup; i++)
+    fn(i);
+
+  var start = process.hrtime();
+  for (i = 0; i < iterations; i++)
+    fn(i);
+  var elapsed = process.hrtime(start);
+
+  var ns = (elapsed[0] * 1e9 + elapsed[1]) / iterations;
+  var rate = count / ns * 1e3;
+  console.log('  ' + name + ': ' + rate.toFixed(1) + ' ' + unit + ' (' +
+              iterations + ' calls)');
+  return rate;
+}
@@ -0,0 +1,76 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// qt.compareImages() on a 1920x1080 frame, against the old regression
+// check of comparing encoded PNG bytes
+//
+
+var qt = require('..'),
+    fs = require('fs'),
+    os = require('os'),
+    bench = require('./common');
+
+var app = new qt.QApplication({ headless: true });
+
+var F = qt.ImageFormat;
+var WIDTH = 1920, HEIGHT = 1080;
+var PIXELS = WIDTH * HEIGHT;
+var ITERATIONS = 50;
+
+var a = new qt.QImage(WIDTH, HEIGHT, F.Format_ARGB32);
+a.fill(new qt.QColor(255, 64, 32, 128));
+var b = new qt.QImage(WIDTH, HEIGHT, F.Format_ARGB32);
+b.fill(new qt.QColor(255, 64, 33, 128));
+
+bench.throughput('compareImages', ITERATIONS, PIXELS, 'MPix/s', function() {
+  qt.compareImages(a, b);
+});
+bench.throughput('compareImages, tolerance 1', ITERATIONS, PIXELS, 'MPix/s',
+                 function() {
+  qt.compareImages(a, b, { tolerance: 1 });
+});
+bench.throughput('compareImages with diff', ITERATIONS, PIXELS, 'MPix/s',
+                 function() {
+  qt.compareImages(a, b, { diff: true });
+});
+bench.throughput('compareImages with ssim', 10, PIXELS, 'MPix/s', function() {
+  qt.compareImages(a, b, { ssim: true });
+});
+
+// Baseline: what test/test.js used to do, save both as PNG and compare bytes
+var fileA = os.tmpDir() + '/bench-compare-a.png',
+    fileB = os.tmpDir() + '/bench-compare-b.png';
+bench.throughput('PNG save + byte compare', 5, PIXELS, 'MPix/s', function() {
+  a.save(fileA);
+  b.save(fileB);
+  fs.readFileSync(fileA).toString() === fs.readFileSync(fileB).toString();
+});
+fs.unlinkSync(fileA);
+fs.unlinkSync(fileB);
@@ -0,0 +1,71 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// QImage.convert() fast paths against QImage conversions through Qt, on a
+// 1920x1080 frame
+//
+
+var qt = require('..'),
+    bench = require('./common');
+
+var app = new qt.QApplication({ headless: true });
+
+var F = qt.ImageFormat;
+var WIDTH = 1920, HEIGHT = 1080;
+var PIXELS = WIDTH * HEIGHT;
+var ITERATIONS = 50;
+
+var argb = new qt.QImage(WIDTH, HEIGHT, F.Format_ARGB32);
+argb.fill(new qt.QColor(255, 64, 32, 128));
+var premul = argb.convert(F.Format_ARGB32_Premultiplied);
+
+function measure(name, image, format) {
+  bench.throughput(name, ITERATIONS, PIXELS, 'MPix/s', function() {
+    image.convert(format);
+  });
+}
+
+measure('ARGB32 -> ARGB32_Premultiplied', argb, F.Format_ARGB32_Premultiplied);
+measure('ARGB32_Premultiplied -> ARGB32', premul, F.Format_ARGB32);
+measure('ARGB32 -> RGBA8888 (Buffer)', argb, F.Format_RGBA8888);
+measure('ARGB32_Premultiplied -> RGBA8888 (Buffer)', premul,
+        F.Format_RGBA8888);
+measure('ARGB32_Premultiplied -> RGB16', premul, F.Format_RGB16);
+measure('ARGB32 -> Grayscale8', argb, F.Format_Grayscale8);
+
+bench.throughput('ARGB32 <-> ARGB32_Premultiplied in place', ITERATIONS,
+                 PIXELS, 'MPix/s', function(i) {
+  argb.convert(i & 1 ? F.Format_ARGB32 : F.Format_ARGB32_Premultiplied,
+               { inPlace: true });
+});
+
+// Baseline: Qt's own converters
+measure('Qt: ARGB32_Premultiplied -> RGB888', premul, F.Format_RGB888);
+measure('Qt: ARGB32_Premultiplied -> RGB32', premul, F.Format_RGB32);
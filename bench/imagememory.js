@@ -0,0 +1,61 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Resident memory while churning through 2000x2000 images, left to the
+// garbage collector and disposed explicitly
+//
+
+var qt = require('..');
+
+var app = new qt.QApplication({ headless: true });
+
+var SIZE = 2000;
+var FRAMES = 200;
+
+function rss() {
+  return (process.memoryUsage().rss / (1024 * 1024)).toFixed(0) + ' MB';
+}
+
+function churn(name, dispose) {
+  var peak = 0;
+  for (var i = 0; i < FRAMES; i++) {
+    var image = new qt.QImage(SIZE, SIZE);
+    image.fill();
+    if (dispose)
+      image.dispose();
+    peak = Math.max(peak, process.memoryUsage().rss);
+  }
+  console.log('  ' + name + ': peak rss ' +
+              (peak / (1024 * 1024)).toFixed(0) + ' MB, now ' + rss());
+}
+
+console.log('  start: rss ' + rss());
+churn('left to GC', false);
+churn('dispose()', true);
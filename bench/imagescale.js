@@ -0,0 +1,66 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// QImage.scaled() from a 24 MP source to thumbnail sizes, per filter and
+// thread count
+//
+
+var qt = require('..'),
+    bench = require('./common');
+
+var app = new qt.QApplication({ headless: true });
+
+var WIDTH = 6000, HEIGHT = 4000;
+var ITERATIONS = 5;
+var SIZES = [[1600, 1067], [400, 267], [160, 107]];
+var FILTERS = ['Box', 'Bilinear', 'Lanczos3'];
+
+var source = new qt.QImage(WIDTH, HEIGHT, qt.ImageFormat.Format_RGB32);
+var painter = new qt.QPainter();
+painter.begin(source);
+for (var i = 0; i < 200; i++)
+  painter.fillRect(i * 30, (i * 97) % HEIGHT, 400, 300,
+                   new qt.QColor(i % 256, (i * 7) % 256, (i * 13) % 256));
+painter.end();
+
+var threadCounts = [1, require('os').cpus().length];
+
+SIZES.forEach(function(size) {
+  console.log(WIDTH + 'x' + HEIGHT + ' -> ' + size[0] + 'x' + size[1]);
+  FILTERS.forEach(function(name) {
+    threadCounts.forEach(function(threads) {
+      var options = { filter: qt.ScaleFilter[name], threads: threads };
+      bench.throughput(name + ', ' + threads + ' thread(s)', ITERATIONS,
+                       WIDTH * HEIGHT, 'MPix/s', function() {
+        source.scaled(size[0], size[1], options);
+      });
+    });
+  });
+});
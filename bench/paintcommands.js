@@ -0,0 +1,98 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Per-call painting vs. one PaintCommandBuffer submitted per frame, on the
+// scenes of test/qpainter.js scaled up to many primitives
+//
+
+var qt = require('..'),
+    bench = require('./common');
+
+var app = new qt.QApplication();
+
+var PRIMITIVES = 10000;
+var FRAMES = 50;
+
+var pixmap = new qt.QPixmap(512, 512);
+var image = new qt.QImage(__dirname + '/../test/resources/qimage.png');
+var painter = new qt.QPainter();
+var colors = [new qt.QColor(0, 255, 0), new qt.QColor(0, 0, 255, 125)];
+var argbs = [0xff00ff00, 0x7d0000ff];
+var cmd = new qt.PaintCommandBuffer();
+
+painter.begin(pixmap);
+
+console.log('fillRect x ' + PRIMITIVES);
+
+bench.run('per-call', FRAMES, function() {
+  for (var i = 0; i < PRIMITIVES; i++)
+    painter.fillRect(i % 500, (i >> 4) % 500, 8, 8, colors[i & 1]);
+});
+
+bench.run('submit (encode + run)', FRAMES, function() {
+  cmd.reset();
+  for (var i = 0; i < PRIMITIVES; i++)
+    cmd.fillRect(i % 500, (i >> 4) % 500, 8, 8, argbs[i & 1]);
+  painter.submit(cmd);
+});
+
+bench.run('submit (run only)', FRAMES, function() {
+  painter.submit(cmd);
+});
+
+console.log('drawText x ' + PRIMITIVES);
+
+bench.run('per-call', FRAMES, function() {
+  for (var i = 0; i < PRIMITIVES; i++)
+    painter.drawText(i % 500, (i >> 4) % 500, 'hello');
+});
+
+bench.run('submit (encode + run)', FRAMES, function() {
+  cmd.reset();
+  for (var i = 0; i < PRIMITIVES; i++)
+    cmd.drawText(i % 500, (i >> 4) % 500, 'hello');
+  painter.submit(cmd);
+});
+
+console.log('drawImage x ' + PRIMITIVES / 10);
+
+bench.run('per-call', FRAMES, function() {
+  for (var i = 0; i < PRIMITIVES / 10; i++)
+    painter.drawImage(i % 500, (i >> 4) % 500, image);
+});
+
+bench.run('submit (encode + run)', FRAMES, function() {
+  cmd.reset();
+  for (var i = 0; i < PRIMITIVES / 10; i++)
+    cmd.drawImage(i % 500, (i >> 4) % 500, image);
+  painter.submit(cmd);
+});
+
+painter.end();
@@ -0,0 +1,103 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Per-call overhead of QPainter methods whose overloads are resolved from
+// wrapped argument types
+//
+
+var qt = require('..'),
+    bench = require('./common');
+
+var app = new qt.QApplication();
+
+var N = 200000;
+
+var target = new qt.QPixmap(256, 256);
+var pixmap = new qt.QPixmap(16, 16);
+var color = new qt.QColor(255, 0, 0);
+var brush = new qt.QBrush(qt.GlobalColor.blue);
+var pen = new qt.QPen(color);
+var font = new qt.QFont('Arial', 12);
+
+var painter = new qt.QPainter();
+painter.begin(target);
+
+console.log('QPainter');
+
+bench.run('fillRect(QColor)', N, function(i) {
+  painter.fillRect(i & 255, 0, 1, 1, color);
+});
+
+bench.run('fillRect(QBrush)', N, function(i) {
+  painter.fillRect(i & 255, 0, 1, 1, brush);
+});
+
+bench.run('fillRect(Qt::GlobalColor)', N, function(i) {
+  painter.fillRect(i & 255, 0, 1, 1, qt.GlobalColor.red);
+});
+
+bench.run('fillRect(argb)', N, function(i) {
+  painter.fillRect(i & 255, 0, 1, 1, 0xffff0000);
+});
+
+bench.run('drawPixmap()', N, function(i) {
+  painter.drawPixmap(i & 255, 0, pixmap);
+});
+
+bench.run('setPen()', N, function(i) {
+  painter.setPen(pen);
+});
+
+bench.run('setPen(argb, width)', N, function(i) {
+  painter.setPen(0xffff0000, 1);
+});
+
+bench.run('setFont(QFont)', N, function(i) {
+  painter.setFont(font);
+});
+
+bench.run('setFont(family, px)', N, function(i) {
+  painter.setFont('Arial', 12);
+});
+
+painter.end();
+
+console.log('QPainterPath');
+
+var path = new qt.QPainterPath();
+
+bench.run('lineTo(new QPointF(x, y))', N, function(i) {
+  path.lineTo(new qt.QPointF(i & 255, i & 127));
+});
+
+path = new qt.QPainterPath();
+bench.run('lineTo(x, y)', N, function(i) {
+  path.lineTo(i & 255, i & 127);
+});
@@ -0,0 +1,98 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// qt.renderBatch() on a report's worth of small PNG charts, by thread
+// count, against rendering them one by one on the main thread
+//
+
+var qt = require('..');
+
+var app = new qt.QApplication({ headless: true });
+
+var CHARTS = 300;
+var WIDTH = 320, HEIGHT = 200;
+
+function chart(seed) {
+  var cmd = new qt.PaintCommandBuffer();
+  cmd.setPen(0xff333333, 1);
+  for (var i = 0; i < 40; i++) {
+    var h = (seed * 31 + i * 17) % HEIGHT;
+    cmd.fillRect(i * 8, HEIGHT - h, 6, h, 0xff3366cc);
+  }
+  cmd.drawLine(0, HEIGHT - 1, WIDTH, HEIGHT - 1);
+  return cmd;
+}
+
+var jobs = [];
+for (var i = 0; i < CHARTS; i++)
+  jobs.push({ width: WIDTH, height: HEIGHT, commands: chart(i),
+              background: 0xffffffff });
+
+function report(name, start) {
+  var elapsed = process.hrtime(start);
+  var ms = elapsed[0] * 1e3 + elapsed[1] / 1e6;
+  console.log('  ' + name + ': ' + ms.toFixed(1) + ' ms (' +
+              (CHARTS / ms * 1e3).toFixed(0) + ' charts/s)');
+}
+
+console.log(CHARTS + ' charts, ' + WIDTH + 'x' + HEIGHT + ' PNG');
+
+// Baseline: paint and encode each chart on the main thread
+var start = process.hrtime();
+var painter = new qt.QPainter();
+jobs.forEach(function(job) {
+  var image = new qt.QImage(WIDTH, HEIGHT);
+  image.fill();
+  painter.begin(image);
+  painter.submit(job.commands);
+  painter.end();
+  image.save(__dirname + '/__chart.png', 'PNG');
+});
+require('fs').unlinkSync(__dirname + '/__chart.png');
+report('main thread, one by one', start);
+
+var cpus = require('os').cpus().length;
+var threadCounts = [1, 2, 4, cpus].filter(function(n, i, all) {
+  return n <= cpus && all.indexOf(n) === i;
+});
+
+(function next() {
+  var threads = threadCounts.shift();
+  if (!threads)
+    return;
+
+  var start = process.hrtime();
+  qt.renderBatch(jobs, { threads: threads }, function(err, buffers) {
+    if (err)
+      throw err;
+    report('renderBatch, ' + threads + ' thread(s)', start);
+    next();
+  });
+})();
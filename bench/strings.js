@@ -0,0 +1,68 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Cost of passing strings to and from Qt
+//
+
+var qt = require('..'),
+    bench = require('./common');
+
+var app = new qt.QApplication({ headless: true });
+
+var N = 100000;
+
+var image = new qt.QImage(128, 32, qt.ImageFormat.Format_ARGB32_Premultiplied);
+var painter = new qt.QPainter();
+var labels = [];
+for (var i = 0; i < 16; i++)
+  labels.push('label ' + i);
+
+painter.begin(image);
+
+bench.run('drawText(x, y, label) repeated', N, function(i) {
+  painter.drawText(0, 20, labels[i & 15]);
+});
+
+bench.run('drawText(x, y, label) unique', N, function(i) {
+  painter.drawText(0, 20, 'label ' + i);
+});
+
+painter.end();
+
+var color = new qt.QColor(1, 2, 3);
+var font = new qt.QFont('helvetica');
+
+bench.run('QColor.name()', N, function() {
+  color.name();
+});
+
+bench.run('QFont.family()', N, function() {
+  font.family();
+});
@@ -0,0 +1,66 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// A 1920x1080 offscreen layer per frame: allocated and dropped, against
+// recycled through qt.SurfacePool
+//
+
+var qt = require('..'),
+    bench = require('./common');
+
+var app = new qt.QApplication({ headless: true });
+
+var WIDTH = 1920, HEIGHT = 1080;
+var ITERATIONS = 200;
+
+function frame(image) {
+  var painter = new qt.QPainter();
+  painter.begin(image);
+  painter.fillRect(0, 0, 100, 100, new qt.QColor(255, 0, 0));
+  painter.end();
+}
+
+bench.run('new QImage per frame', ITERATIONS, function() {
+  var image = new qt.QImage(WIDTH, HEIGHT);
+  frame(image);
+  image.dispose();
+});
+
+qt.SurfacePool.clear();
+bench.run('SurfacePool.image() per frame', ITERATIONS, function() {
+  var image = qt.SurfacePool.image(WIDTH, HEIGHT);
+  frame(image);
+  image.dispose();
+});
+
+var stats = qt.SurfacePool.stats();
+console.log('  pool: hit rate ' + (stats.hitRate * 100).toFixed(1) + '%, ' +
+            stats.surfaces + ' surfaces, ' + stats.bytes + ' bytes pooled, ' +
+            stats.evictions + ' evictions');
@@ -0,0 +1,77 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// QPainter.renderTiled() against a single painter on a 4K image, for a
+// fill-heavy and a text-heavy scene, by thread count
+//
+
+var qt = require('..'),
+    bench = require('./common');
+
+var app = new qt.QApplication({ headless: true });
+
+var WIDTH = 3840, HEIGHT = 2160;
+var FRAMES = 10;
+var PRIMITIVES = 20000;
+
+var target = new qt.QImage(WIDTH, HEIGHT);
+var painter = new qt.QPainter();
+
+var fills = new qt.PaintCommandBuffer();
+for (var i = 0; i < PRIMITIVES; i++)
+  fills.fillRect((i * 37) % WIDTH, (i * 91) % HEIGHT, 120, 80,
+                 0x80000000 + ((i * 2654435761) & 0xffffff));
+
+var text = new qt.PaintCommandBuffer();
+text.setFont('Helvetica', 14);
+for (var i = 0; i < PRIMITIVES; i++)
+  text.drawText((i * 37) % WIDTH, (i * 91) % HEIGHT, 'metric ' + (i % 100));
+
+var cpus = require('os').cpus().length;
+var threadCounts = [1, 2, 4, cpus].filter(function(n, i, all) {
+  return n <= cpus && all.indexOf(n) === i;
+});
+
+[['fillRect', fills], ['drawText', text]].forEach(function(scene) {
+  console.log(scene[0] + ' x ' + PRIMITIVES + ', ' + WIDTH + 'x' + HEIGHT);
+
+  bench.run('single painter', FRAMES, function() {
+    painter.begin(target);
+    painter.submit(scene[1]);
+    painter.end();
+  });
+
+  threadCounts.forEach(function(threads) {
+    bench.run('8x8 tiles, ' + threads + ' thread(s)', FRAMES, function() {
+      qt.QPainter.renderTiled(target, scene[1],
+                              { columns: 8, rows: 8, threads: threads });
+    });
+  });
+});
@@ -4,9 +4,11 @@
       'target_name': 'qt',
       'sources': [
         'src/qt.cc', 
+        'src/qt_v8.cc',
 
         'src/QtCore/qsize.cc',
         'src/QtCore/qpointf.cc',
+        'src/QtCore/quveventdispatcher.cc',
 
         'src/QtGui/qapplication.cc',
         'src/QtGui/qwidget.cc',
@@ -24,6 +26,17 @@
         'src/QtGui/qsound.cc',
         'src/QtGui/qscrollarea.cc',
         'src/QtGui/qscrollbar.cc',
+        'src/QtGui/qpicture.cc',
+        'src/QtGui/frameclock.cc',
+        'src/QtGui/paintcommands.cc',
+        'src/QtGui/imageconvert.cc',
+        'src/QtGui/imagescale.cc',
+        'src/QtGui/tiledrender.cc',
+        'src/QtGui/renderthread.cc',
+        'src/QtGui/renderbatch.cc',
+        'src/QtGui/imagecompare.cc',
+        'src/QtGui/tiledimagesource.cc',
+        'src/QtGui/surfacepool.cc',
 
         'src/QtTest/qtesteventlist.cc'
       ],
@@ -44,13 +57,13 @@
         }],
         ['OS=="linux"', {
           'cflags': [
-            '<!@(pkg-config --cflags QtCore QtGui QtTest)'
+            '<!@(pkg-config --cflags QtCore QtGui QtTest x11)'
           ],
           'ldflags': [
-            '<!@(pkg-config --libs-only-L --libs-only-other QtCore QtGui QtTest)'
+            '<!@(pkg-config --libs-only-L --libs-only-other QtCore QtGui QtTest x11)'
           ],
           'libraries': [
-            '<!@(pkg-config --libs-only-l QtCore QtGui QtTest)'
+            '<!@(pkg-config --libs-only-l QtCore QtGui QtTest x11)'
           ]
         }],
         ['OS=="win"', {
@@ -46,4 +46,4 @@ window.resize(300, 150);
 window.show();
 
 // Join Node's event loop
-setInterval(app.processEvents, 0);
+app.exec();
@@ -76,6 +76,5 @@ global.window = window;
 global.area = area;
 global.widget = widget;
 
-setInterval(function() {
-  app.processEvents();
-}, 0);
+// Join Node's event loop
+app.exec();
@@ -35,6 +35,5 @@ var sound = new qt.QSound(__dirname + '/conga1.wav');
 sound.setLoops(3);
 sound.play();
 
-setInterval(function() {
-  app.processEvents();
-}, 0);
+// Join Node's event loop
+app.exec();
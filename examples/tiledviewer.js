@@ -0,0 +1,120 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Viewer for images too large to draw as one pixmap, e.g.:
+//   node tiledviewer.js huge.jpg
+// Tiles are decoded on demand at the current zoom. Press + and - to zoom
+//
+
+var qt = require('..');
+
+var app = new qt.QApplication();
+
+var source = new qt.TiledImageSource(process.argv[2] || 'helloworld.png', {
+  cacheSize: 128 * 1024 * 1024
+});
+if (source.isNull()) {
+  console.log('could not read', process.argv[2]);
+  process.exit(1);
+}
+
+var window = new qt.QWidget;
+var area = new qt.QScrollArea(window);
+var widget = new qt.QWidget(area);
+area.setWidget(widget);
+area.setFrameShape(0); // no frame
+
+window.resize(800, 600);
+area.resize(800, 600);
+
+// Start with the whole image in view
+var scale = Math.min(1, 800 / source.width(), 600 / source.height());
+widget.resize(Math.ceil(source.width() * scale),
+              Math.ceil(source.height() * scale));
+
+widget.setFocusPolicy(11); // Qt::StrongFocus, for the zoom keys
+
+window.show();
+area.show();
+widget.show();
+
+widget.paintEvent(function(region) {
+  // Bounding box of the exposed rects
+  var left = Infinity, top = Infinity, right = 0, bottom = 0;
+  for (var i = 0; i < region.length; i += 4) {
+    left = Math.min(left, region[i]);
+    top = Math.min(top, region[i + 1]);
+    right = Math.max(right, region[i] + region[i + 2]);
+    bottom = Math.max(bottom, region[i + 1] + region[i + 3]);
+  }
+
+  var p = new qt.QPainter();
+  p.begin(widget);
+  source.draw(p, left, top, right - left, bottom - top, scale);
+  p.end();
+});
+
+// Decoded tiles, including prefetched ones, trigger a repaint
+source.tileReady(function() {
+  widget.update();
+});
+
+function zoom(factor) {
+  var h = area.horizontalScrollBar(),
+      v = area.verticalScrollBar();
+
+  // Keep the center of the view in place
+  var cx = (h.value() + 400) / scale,
+      cy = (v.value() + 300) / scale;
+
+  scale = Math.max(1 / 64, Math.min(4, scale * factor));
+  widget.resize(Math.ceil(source.width() * scale),
+                Math.ceil(source.height() * scale));
+
+  h.setValue(Math.round(cx * scale - 400));
+  v.setValue(Math.round(cy * scale - 300));
+  widget.update();
+}
+
+widget.keyPressEvent(function(e) {
+  if (e.text() === '+' || e.text() === '=')
+    zoom(2);
+  else if (e.text() === '-')
+    zoom(0.5);
+});
+
+// Prevent objects from being GC'd
+global.window = window;
+global.area = area;
+global.widget = widget;
+global.source = source;
+
+// Join Node's event loop
+app.exec();
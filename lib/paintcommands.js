@@ -0,0 +1,210 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// PaintCommandBuffer
+// Encodes paint commands into a Float64Array to be run in one native call
+// by QPainter.submit(). Opcodes must match src/QtGui/paintcommands.h
+//
+// Colors are packed 0xAARRGGBB numbers, taken as unsigned 32-bit like
+// QPainter.fillRect() does, so (a << 24 | rgb) works too. Strings, images
+// and pixmaps are stored in side tables and referenced by index.
+//
+
+var Op = {
+  Save       : 1,
+  Restore    : 2,
+  SetPen     : 3,
+  SetBrush   : 4,
+  SetFont    : 5,
+  Translate  : 6,
+  Scale      : 7,
+  FillRect   : 8,
+  DrawRect   : 9,
+  DrawLine   : 10,
+  DrawText   : 11,
+  DrawImage  : 12,
+  DrawPixmap : 13
+}
+Object.freeze(Op);
+
+function PaintCommandBuffer(capacity) {
+  this.commands = new Float64Array(capacity || 1024);
+  this.length = 0;
+  this.strings = [];
+  this.images = [];
+  this._stringIndex = {};
+}
+
+PaintCommandBuffer.Op = Op;
+
+// Empties the buffer, keeping its storage
+PaintCommandBuffer.prototype.reset = function() {
+  this.length = 0;
+  this.strings = [];
+  this.images = [];
+  this._stringIndex = {};
+  return this;
+}
+
+PaintCommandBuffer.prototype._reserve = function(n) {
+  if (this.length + n <= this.commands.length)
+    return;
+
+  var capacity = this.commands.length * 2;
+  while (capacity < this.length + n)
+    capacity *= 2;
+
+  var commands = new Float64Array(capacity);
+  commands.set(this.commands.subarray(0, this.length));
+  this.commands = commands;
+}
+
+PaintCommandBuffer.prototype._string = function(str) {
+  var key = '$' + str;
+  var index = this._stringIndex[key];
+  if (index === undefined) {
+    index = this.strings.length;
+    this.strings.push(str);
+    this._stringIndex[key] = index;
+  }
+  return index;
+}
+
+PaintCommandBuffer.prototype._image = function(image) {
+  var index = this.images.indexOf(image);
+  if (index < 0) {
+    index = this.images.length;
+    this.images.push(image);
+  }
+  return index;
+}
+
+PaintCommandBuffer.prototype.save = function() {
+  this._reserve(1);
+  this.commands[this.length++] = Op.Save;
+  return this;
+}
+
+PaintCommandBuffer.prototype.restore = function() {
+  this._reserve(1);
+  this.commands[this.length++] = Op.Restore;
+  return this;
+}
+
+PaintCommandBuffer.prototype.setPen = function(argb, width) {
+  this._reserve(3);
+  var c = this.commands, i = this.length;
+  c[i] = Op.SetPen; c[i+1] = argb >>> 0; c[i+2] = width || 0;
+  this.length = i + 3;
+  return this;
+}
+
+PaintCommandBuffer.prototype.setBrush = function(argb) {
+  this._reserve(2);
+  var c = this.commands, i = this.length;
+  c[i] = Op.SetBrush; c[i+1] = argb >>> 0;
+  this.length = i + 2;
+  return this;
+}
+
+PaintCommandBuffer.prototype.setFont = function(family, pixelSize) {
+  this._reserve(3);
+  var c = this.commands, i = this.length;
+  c[i] = Op.SetFont; c[i+1] = this._string(family); c[i+2] = pixelSize;
+  this.length = i + 3;
+  return this;
+}
+
+PaintCommandBuffer.prototype.translate = function(dx, dy) {
+  this._reserve(3);
+  var c = this.commands, i = this.length;
+  c[i] = Op.Translate; c[i+1] = dx; c[i+2] = dy;
+  this.length = i + 3;
+  return this;
+}
+
+PaintCommandBuffer.prototype.scale = function(sx, sy) {
+  this._reserve(3);
+  var c = this.commands, i = this.length;
+  c[i] = Op.Scale; c[i+1] = sx; c[i+2] = sy;
+  this.length = i + 3;
+  return this;
+}
+
+PaintCommandBuffer.prototype.fillRect = function(x, y, w, h, argb) {
+  this._reserve(6);
+  var c = this.commands, i = this.length;
+  c[i] = Op.FillRect; c[i+1] = x; c[i+2] = y; c[i+3] = w; c[i+4] = h;
+  c[i+5] = argb >>> 0;
+  this.length = i + 6;
+  return this;
+}
+
+PaintCommandBuffer.prototype.drawRect = function(x, y, w, h) {
+  this._reserve(5);
+  var c = this.commands, i = this.length;
+  c[i] = Op.DrawRect; c[i+1] = x; c[i+2] = y; c[i+3] = w; c[i+4] = h;
+  this.length = i + 5;
+  return this;
+}
+
+PaintCommandBuffer.prototype.drawLine = function(x1, y1, x2, y2) {
+  this._reserve(5);
+  var c = this.commands, i = this.length;
+  c[i] = Op.DrawLine; c[i+1] = x1; c[i+2] = y1; c[i+3] = x2; c[i+4] = y2;
+  this.length = i + 5;
+  return this;
+}
+
+PaintCommandBuffer.prototype.drawText = function(x, y, text) {
+  this._reserve(4);
+  var c = this.commands, i = this.length;
+  c[i] = Op.DrawText; c[i+1] = x; c[i+2] = y; c[i+3] = this._string(text);
+  this.length = i + 4;
+  return this;
+}
+
+PaintCommandBuffer.prototype.drawImage = function(x, y, image) {
+  this._reserve(4);
+  var c = this.commands, i = this.length;
+  c[i] = Op.DrawImage; c[i+1] = x; c[i+2] = y; c[i+3] = this._image(image);
+  this.length = i + 4;
+  return this;
+}
+
+PaintCommandBuffer.prototype.drawPixmap = function(x, y, pixmap) {
+  this._reserve(4);
+  var c = this.commands, i = this.length;
+  c[i] = Op.DrawPixmap; c[i+1] = x; c[i+2] = y; c[i+3] = this._image(pixmap);
+  this.length = i + 4;
+  return this;
+}
+
+module.exports = PaintCommandBuffer;
@@ -55,6 +55,97 @@ qt.MouseButton = {
 }
 Object.freeze(qt.MouseButton);
 
+//
+// QEventLoop::ProcessEventsFlag
+//
+qt.ProcessEventsFlag = {
+  AllEvents                : 0x00,
+  ExcludeUserInputEvents   : 0x01,
+  ExcludeSocketNotifiers   : 0x02,
+  WaitForMoreEvents        : 0x04
+}
+Object.freeze(qt.ProcessEventsFlag);
+
+//
+// QEvent::Type (keys of processEvents() statistics)
+//
+qt.EventType = {
+  None : 0,
+  Timer : 1,
+  MouseButtonPress : 2,
+  MouseButtonRelease : 3,
+  MouseButtonDblClick : 4,
+  MouseMove : 5,
+  KeyPress : 6,
+  KeyRelease : 7,
+  FocusIn : 8,
+  FocusOut : 9,
+  Enter : 10,
+  Leave : 11,
+  Paint : 12,
+  Move : 13,
+  Resize : 14,
+  Show : 17,
+  Hide : 18,
+  Close : 19,
+  WindowActivate : 24,
+  WindowDeactivate : 25,
+  ShowToParent : 26,
+  HideToParent : 27,
+  Wheel : 31,
+  SockAct : 50,
+  DeferredDelete : 52,
+  ChildAdded : 68,
+  ChildPolished : 69,
+  ChildRemoved : 71,
+  PolishRequest : 74,
+  Polish : 75,
+  LayoutRequest : 76,
+  UpdateRequest : 77,
+  UpdateLater : 78,
+  HoverEnter : 127,
+  HoverLeave : 128,
+  HoverMove : 129
+}
+Object.freeze(qt.EventType);
+
+//
+// QImage::Format
+//
+qt.ImageFormat = {
+  Format_Invalid                : 0,
+  Format_Mono                   : 1,
+  Format_MonoLSB                : 2,
+  Format_Indexed8               : 3,
+  Format_RGB32                  : 4,
+  Format_ARGB32                 : 5,
+  Format_ARGB32_Premultiplied   : 6,
+  Format_RGB16                  : 7,
+  Format_ARGB8565_Premultiplied : 8,
+  Format_RGB666                 : 9,
+  Format_ARGB6666_Premultiplied : 10,
+  Format_RGB555                 : 11,
+  Format_ARGB8555_Premultiplied : 12,
+  Format_RGB888                 : 13,
+  Format_RGB444                 : 14,
+  Format_ARGB4444_Premultiplied : 15,
+
+  // Not in Qt 4.8, numbered as in Qt 5. Only for QImage.convert(); see
+  // QImage.toRgbaBuffer() for RGBA bytes
+  Format_Grayscale8             : 24
+}
+Object.freeze(qt.ImageFormat);
+
+//
+// Filters for QImage.scaled() and QPixmap.scaled(). Not in Qt
+//
+qt.ScaleFilter = {
+  Box      : 0,
+  Bilinear : 1,
+  Lanczos3 : 2
+}
+Object.freeze(qt.ScaleFilter);
+
 //
 // Qt::GlobalColor
 //
@@ -505,4 +596,9 @@ qt.Key = {
 };
 Object.freeze(qt.Key);
 
+//
+// JS helpers
+//
+qt.PaintCommandBuffer = require('./paintcommands');
+
 module.exports = qt;
@@ -23,6 +23,22 @@ target.test = function() {
   });
 }
 
+target.bench = function() {
+  cd(root);
+
+  echo('_________________________________________________________________');
+  echo('Running Node-Qt benchmarks');
+  echo();
+
+  cd('bench');
+  ls('*.js').forEach(function(f) {
+    if (f === 'common.js')
+      return;
+    echo('Running benchmark file '+f);
+    exec('node '+f);
+  });
+}
+
 target.ref = function() {
   cd(root);
 
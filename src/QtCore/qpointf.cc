@@ -34,24 +34,22 @@
 using namespace v8;
 
 Persistent<Function> QPointFWrap::constructor;
+Persistent<FunctionTemplate> QPointFWrap::constructor_template;
 
 // Supported implementations:
 //   QPointF (qreal x, qreal y)
-QPointFWrap::QPointFWrap(const Arguments& args) : q_(NULL) {
-  if (args[0]->IsNumber() && args[1]->IsNumber()) {
-    q_ = new QPointF(args[0]->NumberValue(), args[1]->NumberValue());
-  } else {
-    q_ = new QPointF;
-  }
+QPointFWrap::QPointFWrap(const Arguments& args) {
+  if (args[0]->IsNumber() && args[1]->IsNumber())
+    q_ = QPointF(args[0]->NumberValue(), args[1]->NumberValue());
 }
 
 QPointFWrap::~QPointFWrap() {
-  delete q_;
 }
 
 void QPointFWrap::Initialize(Handle<Object> target) {
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
   tpl->SetClassName(String::NewSymbol("QPointF"));
   tpl->InstanceTemplate()->SetInternalFieldCount(1);  
 
@@ -67,6 +65,10 @@ void QPointFWrap::Initialize(Handle<Object> target) {
   target->Set(String::NewSymbol("QPointF"), constructor);
 }
 
+bool QPointFWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
 Handle<Value> QPointFWrap::New(const Arguments& args) {
   HandleScope scope;
 
@@ -76,7 +78,7 @@ Handle<Value> QPointFWrap::New(const Arguments& args) {
   return args.This();
 }
 
-Handle<Value> QPointFWrap::NewInstance(QPointF q) {
+Handle<Value> QPointFWrap::NewInstance(const QPointF& q) {
   HandleScope scope;
   
   Local<Object> instance = constructor->NewInstance(0, NULL);
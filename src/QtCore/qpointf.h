@@ -37,17 +37,16 @@
 class QPointFWrap : public node::ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
-  QPointF* GetWrapped() const { return q_; };
-  void SetWrapped(QPointF q) { 
-    if (q_) delete q_; 
-    q_ = new QPointF(q); 
-  };
-  static v8::Handle<v8::Value> NewInstance(QPointF q);
+  static bool HasInstance(v8::Handle<v8::Value> value);
+  QPointF* GetWrapped() { return &q_; };
+  void SetWrapped(const QPointF& q) { q_ = q; };
+  static v8::Handle<v8::Value> NewInstance(const QPointF& q);
 
  private:
   QPointFWrap(const v8::Arguments& args);
   ~QPointFWrap();
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> constructor_template;
   static v8::Handle<v8::Value> New(const v8::Arguments& args);
 
   // Wrapped methods
@@ -55,8 +54,9 @@ class QPointFWrap : public node::ObjectWrap {
   static v8::Handle<v8::Value> X(const v8::Arguments& args);
   static v8::Handle<v8::Value> Y(const v8::Arguments& args);
 
-  // Wrapped object
-  QPointF* q_;
+  // Wrapped object, held by value: points are created by the million and
+  // need no allocation besides the wrapper's own
+  QPointF q_;
 };
 
 #endif
@@ -34,19 +34,20 @@
 using namespace v8;
 
 Persistent<Function> QSizeWrap::constructor;
+Persistent<FunctionTemplate> QSizeWrap::constructor_template;
 
-QSizeWrap::QSizeWrap() : q_(NULL) {
+QSizeWrap::QSizeWrap() {
   // Standalone constructor not implemented
   // Use SetWrapped()  
 }
 
 QSizeWrap::~QSizeWrap() {
-  delete q_;
 }
 
 void QSizeWrap::Initialize(Handle<Object> target) {
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
   tpl->SetClassName(String::NewSymbol("QSize"));
   tpl->InstanceTemplate()->SetInternalFieldCount(1);  
 
@@ -60,6 +61,10 @@ void QSizeWrap::Initialize(Handle<Object> target) {
   target->Set(String::NewSymbol("QSize"), constructor);
 }
 
+bool QSizeWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
 Handle<Value> QSizeWrap::New(const Arguments& args) {
   HandleScope scope;
 
@@ -69,7 +74,7 @@ Handle<Value> QSizeWrap::New(const Arguments& args) {
   return args.This();
 }
 
-Handle<Value> QSizeWrap::NewInstance(QSize q) {
+Handle<Value> QSizeWrap::NewInstance(const QSize& q) {
   HandleScope scope;
   
   Local<Object> instance = constructor->NewInstance(0, NULL);
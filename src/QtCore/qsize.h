@@ -37,17 +37,16 @@
 class QSizeWrap : public node::ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
-  static v8::Handle<v8::Value> NewInstance(QSize q);
-  QSize* GetWrapped() const { return q_; };
-  void SetWrapped(QSize q) { 
-    if (q_) delete q_; 
-    q_ = new QSize(q); 
-  };
+  static bool HasInstance(v8::Handle<v8::Value> value);
+  static v8::Handle<v8::Value> NewInstance(const QSize& q);
+  QSize* GetWrapped() { return &q_; };
+  void SetWrapped(const QSize& q) { q_ = q; };
 
  private:
   QSizeWrap();
   ~QSizeWrap();
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> constructor_template;
   static v8::Handle<v8::Value> New(const v8::Arguments& args);
 
   // Wrapped methods
@@ -55,7 +54,7 @@ class QSizeWrap : public node::ObjectWrap {
   static v8::Handle<v8::Value> Height(const v8::Arguments& args);
 
   // Wrapped object
-  QSize* q_;
+  QSize q_;
 };
 
 #endif
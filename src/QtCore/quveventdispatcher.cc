@@ -0,0 +1,473 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#define BUILDING_NODE_EXTENSION
+#include <node.h>
+#include <stdlib.h>
+#include <QCoreApplication>
+#include <QSocketNotifier>
+#include <QTimerEvent>
+#include "quveventdispatcher.h"
+
+#ifdef Q_WS_X11
+#include <QApplication>
+#include <QX11Info>
+#include <X11/Xlib.h>
+#endif
+
+using namespace v8;
+
+// Exported by QtCore, but only declared in its private headers
+Q_CORE_EXPORT uint qGlobalPostedEventsCount();
+
+//
+// Events are delivered from libuv callbacks, i.e. with no JS on the stack.
+// Exceptions thrown by JS event handlers must be reported here or they would
+// be silently dropped
+//
+#define QUV_BEGIN_CALLBACK() \
+  HandleScope scope; \
+  TryCatch try_catch; \
+  callback_depth++;
+
+#define QUV_END_CALLBACK() \
+  callback_depth--; \
+  if (try_catch.HasCaught()) \
+    node::FatalException(try_catch);
+
+// Dispatcher callbacks currently on the stack
+static int callback_depth = 0;
+
+QUvEventDispatcher::QUvEventDispatcher(QObject* parent)
+    : QAbstractEventDispatcher(parent), display_(NULL), ref_(false),
+      interrupted_(false), started_(false) {
+  loop_ = uv_default_loop();
+
+  check_ = static_cast<uv_check_t*>(malloc(sizeof(uv_check_t)));
+  uv_check_init(loop_, check_);
+  check_->data = this;
+  uv_check_start(check_, OnCheck);
+  ApplyRef(reinterpret_cast<uv_handle_t*>(check_));
+
+  prepare_ = static_cast<uv_prepare_t*>(malloc(sizeof(uv_prepare_t)));
+  uv_prepare_init(loop_, prepare_);
+  prepare_->data = this;
+  uv_prepare_start(prepare_, OnPrepare);
+  ApplyRef(reinterpret_cast<uv_handle_t*>(prepare_));
+
+  wake_ = static_cast<uv_async_t*>(malloc(sizeof(uv_async_t)));
+  uv_async_init(loop_, wake_, OnWakeUp);
+  wake_->data = this;
+  ApplyRef(reinterpret_cast<uv_handle_t*>(wake_));
+}
+
+QUvEventDispatcher::~QUvEventDispatcher() {
+  foreach (Timer* timer, timers_) {
+    uv_timer_stop(&timer->handle);
+    uv_close(reinterpret_cast<uv_handle_t*>(&timer->handle), OnCloseTimer);
+  }
+  timers_.clear();
+
+  foreach (SocketWatcher* watcher, sockets_) {
+    uv_poll_stop(&watcher->handle);
+    uv_close(reinterpret_cast<uv_handle_t*>(&watcher->handle), OnCloseSocket);
+  }
+  sockets_.clear();
+
+  if (display_) {
+    uv_poll_stop(display_);
+    uv_close(reinterpret_cast<uv_handle_t*>(display_), OnCloseHandle);
+  }
+  uv_check_stop(check_);
+  uv_close(reinterpret_cast<uv_handle_t*>(check_), OnCloseHandle);
+  uv_prepare_stop(prepare_);
+  uv_close(reinterpret_cast<uv_handle_t*>(prepare_), OnCloseHandle);
+  uv_close(reinterpret_cast<uv_handle_t*>(wake_), OnCloseHandle);
+}
+
+void QUvEventDispatcher::AttachDisplay() {
+#ifdef Q_WS_X11
+  if (display_ || !QX11Info::display())
+    return;
+
+  display_ = static_cast<uv_poll_t*>(malloc(sizeof(uv_poll_t)));
+  uv_poll_init(loop_, display_, ConnectionNumber(QX11Info::display()));
+  display_->data = this;
+  uv_poll_start(display_, UV_READABLE, OnDisplay);
+  ApplyRef(reinterpret_cast<uv_handle_t*>(display_));
+
+  // Events may already be queued client-side from QApplication's setup
+  ProcessWindowSystemEvents();
+#endif
+}
+
+//
+// SetRef()
+// By default no handle keeps Node alive, so scripts that never call exec()
+// (e.g. unit tests) exit as before
+//
+void QUvEventDispatcher::SetRef(bool ref) {
+  if (ref == ref_)
+    return;
+  ref_ = ref;
+
+  ApplyRef(reinterpret_cast<uv_handle_t*>(check_));
+  ApplyRef(reinterpret_cast<uv_handle_t*>(prepare_));
+  ApplyRef(reinterpret_cast<uv_handle_t*>(wake_));
+  if (display_)
+    ApplyRef(reinterpret_cast<uv_handle_t*>(display_));
+  foreach (Timer* timer, timers_)
+    ApplyRef(reinterpret_cast<uv_handle_t*>(&timer->handle));
+  foreach (SocketWatcher* watcher, sockets_)
+    ApplyRef(reinterpret_cast<uv_handle_t*>(&watcher->handle));
+}
+
+void QUvEventDispatcher::ApplyRef(uv_handle_t* handle) {
+  if (ref_)
+    uv_ref(handle);
+  else
+    uv_unref(handle);
+}
+
+//
+// processEvents()
+// Called by QCoreApplication::processEvents() and by nested QEventLoops.
+// Flushes posted and window system events without blocking; with
+// WaitForMoreEvents it runs a single iteration of Node's loop instead.
+// libuv can't run its loop from one of its own callbacks, so once Node's
+// loop is running WaitForMoreEvents doesn't block: nested QEventLoops
+// poll, and Qt timers only fire once they return to Node
+//
+bool QUvEventDispatcher::processEvents(QEventLoop::ProcessEventsFlags flags) {
+  interrupted_ = false;
+  emit awake();
+
+  bool handled = false;
+
+  if (qGlobalPostedEventsCount() > 0) {
+    QCoreApplication::sendPostedEvents();
+    handled = true;
+  }
+
+  if (!(flags & QEventLoop::ExcludeUserInputEvents))
+    handled = ProcessWindowSystemEvents() || handled;
+
+  if (!handled && !interrupted_ && (flags & QEventLoop::WaitForMoreEvents) &&
+      !InLoop()) {
+    emit aboutToBlock();
+    uv_run_once(loop_);
+    handled = true;
+  }
+
+  return handled;
+}
+
+//
+// InLoop()
+// True when called from within Node's loop. Callbacks of other modules
+// can't be seen, but all JS after the main script runs from the loop, so
+// once it has made a pass every call counts as nested
+//
+bool QUvEventDispatcher::InLoop() const {
+  return started_ || callback_depth > 0;
+}
+
+bool QUvEventDispatcher::hasPendingEvents() {
+#ifdef Q_WS_X11
+  if (QX11Info::display() && XPending(QX11Info::display()))
+    return true;
+#endif
+  return qGlobalPostedEventsCount() > 0;
+}
+
+bool QUvEventDispatcher::ProcessWindowSystemEvents() {
+  bool handled = false;
+
+#ifdef Q_WS_X11
+  Display* dpy = QX11Info::display();
+  if (!dpy)
+    return false;
+
+  while (!interrupted_ && XPending(dpy)) {
+    XEvent event;
+    XNextEvent(dpy, &event);
+
+    if (filterEvent(&event))
+      continue;
+
+    qApp->x11ProcessEvent(&event);
+    handled = true;
+  }
+#endif
+
+  return handled;
+}
+
+//
+// Socket notifiers
+// libuv allows a single poll handle per fd, so read/write/exception
+// notifiers on the same socket share one watcher
+//
+
+void QUvEventDispatcher::registerSocketNotifier(QSocketNotifier* notifier) {
+  int fd = notifier->socket();
+
+  SocketWatcher* watcher = sockets_.value(fd, NULL);
+  if (!watcher) {
+    watcher = new SocketWatcher;
+    watcher->fd = fd;
+    watcher->notifiers[0] = watcher->notifiers[1] = watcher->notifiers[2] = NULL;
+    watcher->dispatcher = this;
+    uv_poll_init(loop_, &watcher->handle, fd);
+    watcher->handle.data = watcher;
+    ApplyRef(reinterpret_cast<uv_handle_t*>(&watcher->handle));
+    sockets_.insert(fd, watcher);
+  }
+
+  watcher->notifiers[notifier->type()] = notifier;
+  UpdateSocketWatcher(watcher);
+}
+
+void QUvEventDispatcher::unregisterSocketNotifier(QSocketNotifier* notifier) {
+  SocketWatcher* watcher = sockets_.value(notifier->socket(), NULL);
+  if (!watcher || watcher->notifiers[notifier->type()] != notifier)
+    return;
+
+  watcher->notifiers[notifier->type()] = NULL;
+
+  if (!watcher->notifiers[0] && !watcher->notifiers[1] &&
+      !watcher->notifiers[2]) {
+    sockets_.remove(watcher->fd);
+    uv_poll_stop(&watcher->handle);
+    uv_close(reinterpret_cast<uv_handle_t*>(&watcher->handle), OnCloseSocket);
+    return;
+  }
+
+  UpdateSocketWatcher(watcher);
+}
+
+void QUvEventDispatcher::UpdateSocketWatcher(SocketWatcher* watcher) {
+  int events = 0;
+  if (watcher->notifiers[QSocketNotifier::Read] ||
+      watcher->notifiers[QSocketNotifier::Exception])
+    events |= UV_READABLE;
+  if (watcher->notifiers[QSocketNotifier::Write])
+    events |= UV_WRITABLE;
+
+  uv_poll_start(&watcher->handle, events, OnSocket);
+}
+
+void QUvEventDispatcher::OnSocket(uv_poll_t* handle, int status, int events) {
+  QUV_BEGIN_CALLBACK();
+
+  SocketWatcher* watcher = static_cast<SocketWatcher*>(handle->data);
+
+  // Copy the notifiers: a handler may unregister (and free) the watcher
+  QSocketNotifier* notifiers[3] = {
+    watcher->notifiers[0], watcher->notifiers[1], watcher->notifiers[2]
+  };
+  QUvEventDispatcher* dispatcher = watcher->dispatcher;
+  int fd = watcher->fd;
+
+  for (int type = 0; type < 3; type++) {
+    if (!notifiers[type])
+      continue;
+
+    bool ready = (type == QSocketNotifier::Write)
+        ? (status < 0 || (events & UV_WRITABLE))
+        : (status < 0 || (events & UV_READABLE));
+    if (!ready)
+      continue;
+
+    // Skip notifiers unregistered by a previous handler
+    SocketWatcher* current = dispatcher->sockets_.value(fd, NULL);
+    if (!current || current->notifiers[type] != notifiers[type])
+      continue;
+
+    QEvent event(QEvent::SockAct);
+    QCoreApplication::sendEvent(notifiers[type], &event);
+  }
+
+  QUV_END_CALLBACK();
+}
+
+//
+// Timers
+//
+
+void QUvEventDispatcher::registerTimer(int timerId, int interval,
+                                       QObject* object) {
+  Timer* timer = new Timer;
+  timer->id = timerId;
+  timer->interval = interval;
+  timer->object = object;
+  timer->dispatcher = this;
+  uv_timer_init(loop_, &timer->handle);
+  timer->handle.data = timer;
+  ApplyRef(reinterpret_cast<uv_handle_t*>(&timer->handle));
+
+  // Qt's zero timers fire on every loop pass, whereas a zero repeat makes a
+  // uv timer one-shot
+  uv_timer_start(&timer->handle, OnTimer, interval,
+                 interval > 0 ? interval : 1);
+
+  timers_.insert(timerId, timer);
+}
+
+bool QUvEventDispatcher::unregisterTimer(int timerId) {
+  Timer* timer = timers_.take(timerId);
+  if (!timer)
+    return false;
+
+  uv_timer_stop(&timer->handle);
+  uv_close(reinterpret_cast<uv_handle_t*>(&timer->handle), OnCloseTimer);
+  return true;
+}
+
+bool QUvEventDispatcher::unregisterTimers(QObject* object) {
+  QList<int> ids;
+  foreach (Timer* timer, timers_) {
+    if (timer->object == object)
+      ids.append(timer->id);
+  }
+
+  foreach (int id, ids)
+    unregisterTimer(id);
+
+  return !ids.isEmpty();
+}
+
+QList<QAbstractEventDispatcher::TimerInfo>
+QUvEventDispatcher::registeredTimers(QObject* object) const {
+  QList<TimerInfo> list;
+  foreach (Timer* timer, timers_) {
+    if (timer->object == object)
+      list.append(TimerInfo(timer->id, timer->interval));
+  }
+  return list;
+}
+
+void QUvEventDispatcher::OnTimer(uv_timer_t* handle, int status) {
+  QUV_BEGIN_CALLBACK();
+
+  Timer* timer = static_cast<Timer*>(handle->data);
+
+  QTimerEvent event(timer->id);
+  QCoreApplication::sendEvent(timer->object, &event);
+
+  QUV_END_CALLBACK();
+}
+
+//
+// Loop hooks
+//
+
+void QUvEventDispatcher::OnDisplay(uv_poll_t* handle, int status, int events) {
+  QUV_BEGIN_CALLBACK();
+
+  QUvEventDispatcher* d = static_cast<QUvEventDispatcher*>(handle->data);
+  d->interrupted_ = false;
+  d->ProcessWindowSystemEvents();
+
+  QUV_END_CALLBACK();
+}
+
+void QUvEventDispatcher::OnCheck(uv_check_t* handle, int status) {
+  QUV_BEGIN_CALLBACK();
+
+  QUvEventDispatcher* d = static_cast<QUvEventDispatcher*>(handle->data);
+  d->started_ = true;
+  d->interrupted_ = false;
+  if (qGlobalPostedEventsCount() > 0)
+    QCoreApplication::sendPostedEvents();
+
+  QUV_END_CALLBACK();
+}
+
+//
+// OnPrepare()
+// Runs right before Node blocks for I/O: Xlib may hold events that were read
+// off the socket as a side effect of other requests, and the poll handle
+// would never see those
+//
+void QUvEventDispatcher::OnPrepare(uv_prepare_t* handle, int status) {
+  QUV_BEGIN_CALLBACK();
+
+  QUvEventDispatcher* d = static_cast<QUvEventDispatcher*>(handle->data);
+  d->started_ = true;
+
+#ifdef Q_WS_X11
+  Display* dpy = QX11Info::display();
+  if (dpy && XEventsQueued(dpy, QueuedAlready))
+    d->ProcessWindowSystemEvents();
+#endif
+
+  emit d->aboutToBlock();
+  d->flush();
+
+  QUV_END_CALLBACK();
+}
+
+void QUvEventDispatcher::OnWakeUp(uv_async_t* handle, int status) {
+  QUV_BEGIN_CALLBACK();
+
+  if (qGlobalPostedEventsCount() > 0)
+    QCoreApplication::sendPostedEvents();
+
+  QUV_END_CALLBACK();
+}
+
+// Thread-safe: may be called from any thread posting events
+void QUvEventDispatcher::wakeUp() {
+  uv_async_send(wake_);
+}
+
+void QUvEventDispatcher::interrupt() {
+  interrupted_ = true;
+  wakeUp();
+}
+
+void QUvEventDispatcher::flush() {
+#ifdef Q_WS_X11
+  if (QX11Info::display())
+    XFlush(QX11Info::display());
+#endif
+}
+
+void QUvEventDispatcher::OnCloseTimer(uv_handle_t* handle) {
+  delete static_cast<Timer*>(handle->data);
+}
+
+void QUvEventDispatcher::OnCloseSocket(uv_handle_t* handle) {
+  delete static_cast<SocketWatcher*>(handle->data);
+}
+
+void QUvEventDispatcher::OnCloseHandle(uv_handle_t* handle) {
+  free(handle);
+}
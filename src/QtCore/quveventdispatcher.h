@@ -0,0 +1,119 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef QUVEVENTDISPATCHER_H
+#define QUVEVENTDISPATCHER_H
+
+#define BUILDING_NODE_EXTENSION
+#include <node.h>
+#include <uv.h>
+#include <QAbstractEventDispatcher>
+#include <QHash>
+
+//
+// QUvEventDispatcher
+// Drives Qt from Node's libuv loop: timers and socket notifiers map onto uv
+// handles, the X11 connection is watched with uv_poll, and posted events are
+// flushed from uv_check. Must be created before QApplication.
+//
+class QUvEventDispatcher : public QAbstractEventDispatcher {
+ public:
+  QUvEventDispatcher(QObject* parent = 0);
+  ~QUvEventDispatcher();
+
+  // Starts watching the window system connection (if any). Call after
+  // QApplication has been constructed
+  void AttachDisplay();
+
+  // Referenced handles keep Node's event loop alive
+  void SetRef(bool ref);
+  bool HasRef() const { return ref_; };
+
+  bool processEvents(QEventLoop::ProcessEventsFlags flags);
+  bool hasPendingEvents();
+
+  void registerSocketNotifier(QSocketNotifier* notifier);
+  void unregisterSocketNotifier(QSocketNotifier* notifier);
+
+  void registerTimer(int timerId, int interval, QObject* object);
+  bool unregisterTimer(int timerId);
+  bool unregisterTimers(QObject* object);
+  QList<TimerInfo> registeredTimers(QObject* object) const;
+
+  void wakeUp();
+  void interrupt();
+  void flush();
+
+ private:
+  struct Timer {
+    uv_timer_t handle;
+    int id;
+    int interval;
+    QObject* object;
+    QUvEventDispatcher* dispatcher;
+  };
+
+  struct SocketWatcher {
+    uv_poll_t handle;
+    int fd;
+    QSocketNotifier* notifiers[3]; // indexed by QSocketNotifier::Type
+    QUvEventDispatcher* dispatcher;
+  };
+
+  bool ProcessWindowSystemEvents();
+  bool InLoop() const;
+  void UpdateSocketWatcher(SocketWatcher* watcher);
+  void ApplyRef(uv_handle_t* handle);
+
+  static void OnTimer(uv_timer_t* handle, int status);
+  static void OnSocket(uv_poll_t* handle, int status, int events);
+  static void OnDisplay(uv_poll_t* handle, int status, int events);
+  static void OnCheck(uv_check_t* handle, int status);
+  static void OnPrepare(uv_prepare_t* handle, int status);
+  static void OnWakeUp(uv_async_t* handle, int status);
+  static void OnCloseTimer(uv_handle_t* handle);
+  static void OnCloseSocket(uv_handle_t* handle);
+  static void OnCloseHandle(uv_handle_t* handle);
+
+  // Loop handles are heap allocated since uv_close() completes only after
+  // the dispatcher is gone
+  uv_loop_t* loop_;
+  uv_check_t* check_;
+  uv_prepare_t* prepare_;
+  uv_async_t* wake_;
+  uv_poll_t* display_;
+  bool ref_;
+  bool interrupted_;
+  bool started_; // Node's loop has made a pass
+
+  QHash<int, Timer*> timers_;
+  QHash<int, SocketWatcher*> sockets_;
+};
+
+#endif
@@ -0,0 +1,195 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#define BUILDING_NODE_EXTENSION
+#include <node.h>
+#include <math.h>
+#include "frameclock.h"
+
+using namespace v8;
+
+// 60 Hz, in ns
+static const double kDefaultInterval = 1e9 / 60;
+
+FrameClock* FrameClock::Instance() {
+  static FrameClock* instance = new FrameClock;
+  return instance;
+}
+
+FrameClock::FrameClock() : scheduled_(false), inFrame_(false),
+    interval_(kDefaultInterval), origin_(uv_hrtime()), targetFrame_(0),
+    frames_(0), missed_(0), lastWork_(0) {
+  uv_timer_init(uv_default_loop(), &timer_);
+  timer_.data = this;
+}
+
+void FrameClock::RequestFrame(Handle<Function> cb, QWidget* widget) {
+  FrameRequest request;
+  request.callback = Persistent<Function>::New(cb);
+  request.widget = widget;
+  requests_.append(request);
+
+  Schedule();
+}
+
+void FrameClock::ScheduleRepaint(QWidget* widget, const QRegion& region) {
+  DirtyWidget& dirty = dirty_[widget];
+  if (dirty.widget.isNull()) {
+    dirty.widget = widget;
+    dirty.region = QRegion();
+    dirty.all = false;
+  }
+
+  if (region.isEmpty())
+    dirty.all = true;
+  else
+    dirty.region += region;
+
+  // Requests made while running a frame are served by that frame
+  if (!inFrame_)
+    Schedule();
+}
+
+void FrameClock::SetInterval(double ms) {
+  interval_ = ms * 1e6;
+  origin_ = uv_hrtime();
+  targetFrame_ = 0;
+
+  if (scheduled_) {
+    uv_timer_stop(&timer_);
+    scheduled_ = false;
+    Schedule();
+  }
+}
+
+Handle<Object> FrameClock::Stats() const {
+  HandleScope scope;
+
+  Local<Object> stats = Object::New();
+  stats->Set(String::NewSymbol("frames"), Number::New(frames_));
+  stats->Set(String::NewSymbol("missed"), Number::New(missed_));
+  stats->Set(String::NewSymbol("interval"), Number::New(interval_ / 1e6));
+  stats->Set(String::NewSymbol("lastFrameTime"), Number::New(lastWork_));
+  stats->Set(String::NewSymbol("pending"), Integer::New(requests_.size()));
+
+  return scope.Close(stats);
+}
+
+//
+// Schedule()
+// Arms the timer for the first frame deadline after now
+//
+void FrameClock::Schedule() {
+  if (scheduled_)
+    return;
+
+  uint64_t now = uv_hrtime();
+  uint64_t frame = (uint64_t) floor((now - origin_) / interval_) + 1;
+  if (frame <= targetFrame_)
+    frame = targetFrame_ + 1;
+
+  double deadline = origin_ + frame * interval_;
+  uint64_t delay = (uint64_t) ceil((deadline - now) / 1e6);
+
+  targetFrame_ = frame;
+  scheduled_ = true;
+
+  // Timers are relative to the loop's cached time, which may be stale
+  uv_update_time(uv_default_loop());
+  uv_timer_start(&timer_, OnTimer, delay, 0);
+}
+
+void FrameClock::Tick() {
+  HandleScope scope;
+
+  scheduled_ = false;
+
+  uint64_t start = uv_hrtime();
+  uint64_t frame = (uint64_t) floor((start - origin_) / interval_);
+
+  // Woke up past the following deadline: those frames were skipped
+  if (frame > targetFrame_) {
+    missed_ += frame - targetFrame_;
+    targetFrame_ = frame;
+  }
+  frames_++;
+
+  QList<FrameRequest> requests;
+  requests.swap(requests_);
+
+  Local<Value> timestamp = Number::New(start / 1e6);
+  inFrame_ = true;
+
+  for (int i = 0; i < requests.size(); i++) {
+    TryCatch try_catch;
+
+    Handle<Value> argv[1] = { timestamp };
+    requests[i].callback->Call(Context::GetCurrent()->Global(), 1, argv);
+    requests[i].callback.Dispose();
+
+    if (!requests[i].widget.isNull())
+      ScheduleRepaint(requests[i].widget);
+
+    if (try_catch.HasCaught())
+      node::FatalException(try_catch);
+  }
+
+  inFrame_ = false;
+
+  // One paint pass for everything that was invalidated since last frame
+  QHash<QWidget*, DirtyWidget> dirty;
+  dirty.swap(dirty_);
+
+  QHash<QWidget*, DirtyWidget>::const_iterator i;
+  for (i = dirty.constBegin(); i != dirty.constEnd(); ++i) {
+    QWidget* widget = i.value().widget;
+    if (!widget)
+      continue;
+
+    // Runs the JS paint callback
+    TryCatch try_catch;
+
+    if (i.value().all)
+      widget->repaint();
+    else
+      widget->repaint(i.value().region);
+
+    if (try_catch.HasCaught())
+      node::FatalException(try_catch);
+  }
+
+  lastWork_ = (uv_hrtime() - start) / 1e6;
+
+  if (!requests_.isEmpty() || !dirty_.isEmpty())
+    Schedule();
+}
+
+void FrameClock::OnTimer(uv_timer_t* handle, int status) {
+  static_cast<FrameClock*>(handle->data)->Tick();
+}
@@ -0,0 +1,106 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef FRAMECLOCK_H
+#define FRAMECLOCK_H
+
+#define BUILDING_NODE_EXTENSION
+#include <node.h>
+#include <uv.h>
+#include <QHash>
+#include <QList>
+#include <QPointer>
+#include <QRegion>
+#include <QWidget>
+
+//
+// FrameClock
+// Process-wide frame scheduler. Frame callbacks and widget repaints
+// requested between two ticks are run together, once per frame interval,
+// on deadlines aligned to a fixed origin. When a tick runs late the frames
+// in between are skipped and counted as missed. The uv timer only runs
+// while something is pending
+//
+class FrameClock {
+ public:
+  static FrameClock* Instance();
+
+  // Runs cb(timestamp) on the next frame. If widget is given it is
+  // repainted in the same frame, after all callbacks
+  void RequestFrame(v8::Handle<v8::Function> cb, QWidget* widget = 0);
+
+  // Repaints region of widget (all of it if region is empty) on the next
+  // frame, or the current one if called from a frame callback
+  void ScheduleRepaint(QWidget* widget, const QRegion& region = QRegion());
+
+  // True while frames are pending or being run; update() calls are routed
+  // through the clock only then
+  bool IsActive() const { return scheduled_ || inFrame_; };
+
+  void SetInterval(double ms);
+  double Interval() const { return interval_ / 1e6; };
+
+  v8::Handle<v8::Object> Stats() const;
+
+ private:
+  struct FrameRequest {
+    v8::Persistent<v8::Function> callback;
+    QPointer<QWidget> widget;
+  };
+
+  struct DirtyWidget {
+    QPointer<QWidget> widget;
+    QRegion region;
+    bool all;
+  };
+
+  FrameClock();
+  void Schedule();
+  void Tick();
+  static void OnTimer(uv_timer_t* handle, int status);
+
+  uv_timer_t timer_;
+  bool scheduled_;
+  bool inFrame_;
+
+  // Timing, in ns
+  double interval_;
+  uint64_t origin_;
+  uint64_t targetFrame_;
+
+  QList<FrameRequest> requests_;
+  QHash<QWidget*, DirtyWidget> dirty_;
+
+  // Statistics
+  double frames_;
+  double missed_;
+  double lastWork_;
+};
+
+#endif
@@ -0,0 +1,280 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "imagecompare.h"
+#include "../qt_v8.h"
+#include "qimage.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace v8;
+
+namespace ImageCompare {
+
+// Largest channel delta of two pixels, under mask
+static inline int PixelDelta(quint32 a, quint32 b, quint32 mask) {
+  int delta = 0;
+  for (int shift = 0; shift < 32; shift += 8) {
+    if (!((mask >> shift) & 0xff))
+      continue;
+    int d = qAbs(int((a >> shift) & 0xff) - int((b >> shift) & 0xff));
+    delta = qMax(delta, d);
+  }
+  return delta;
+}
+
+// Pixels of a row whose delta is above tolerance are flagged in
+// mismatch. Returns the largest delta of the row
+static int CompareRow(const quint32* a, const quint32* b, int width,
+                      quint32 mask, int tolerance, uchar* mismatch) {
+  int maxDelta = 0;
+  int x = 0;
+#ifdef __SSE2__
+  const __m128i channels = _mm_set1_epi32(mask);
+  const __m128i low = _mm_set1_epi32(0xff);
+  const __m128i limit = _mm_set1_epi32(tolerance);
+  __m128i rowMax = _mm_setzero_si128();
+
+  for (; x + 4 <= width; x += 4) {
+    __m128i pa = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + x));
+    __m128i pb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + x));
+
+    // |a - b| per channel, then the largest channel into the low byte
+    __m128i d = _mm_or_si128(_mm_subs_epu8(pa, pb), _mm_subs_epu8(pb, pa));
+    d = _mm_and_si128(d, channels);
+    d = _mm_max_epu8(d, _mm_srli_epi32(d, 16));
+    d = _mm_max_epu8(d, _mm_srli_epi32(d, 8));
+    d = _mm_and_si128(d, low);
+
+    rowMax = _mm_max_epu8(rowMax, d);
+    int bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(d, limit)));
+    for (int i = 0; i < 4; i++)
+      mismatch[x + i] = (bits >> i) & 1;
+  }
+
+  uchar lanes[16];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), rowMax);
+  for (int i = 0; i < 16; i += 4)
+    maxDelta = qMax(maxDelta, int(lanes[i]));
+#endif
+  for (; x < width; x++) {
+    int d = PixelDelta(a[x], b[x], mask);
+    maxDelta = qMax(maxDelta, d);
+    mismatch[x] = d > tolerance;
+  }
+  return maxDelta;
+}
+
+static inline double Luma(quint32 p) {
+  return 0.299 * qRed(p) + 0.587 * qGreen(p) + 0.114 * qBlue(p);
+}
+
+// Mean SSIM over 8x8 blocks, partial blocks at the edges included
+static double Ssim(const QImage& a, const QImage& b) {
+  const double c1 = (0.01 * 255) * (0.01 * 255);
+  const double c2 = (0.03 * 255) * (0.03 * 255);
+  const int block = 8;
+
+  double total = 0.0;
+  int blocks = 0;
+
+  for (int by = 0; by < a.height(); by += block) {
+    for (int bx = 0; bx < a.width(); bx += block) {
+      int w = qMin(block, a.width() - bx);
+      int h = qMin(block, a.height() - by);
+      double sa = 0, sb = 0, saa = 0, sbb = 0, sab = 0;
+
+      for (int y = by; y < by + h; y++) {
+        const quint32* ra = reinterpret_cast<const quint32*>(
+            a.constScanLine(y));
+        const quint32* rb = reinterpret_cast<const quint32*>(
+            b.constScanLine(y));
+        for (int x = bx; x < bx + w; x++) {
+          double la = Luma(ra[x]);
+          double lb = Luma(rb[x]);
+          sa += la;
+          sb += lb;
+          saa += la * la;
+          sbb += lb * lb;
+          sab += la * lb;
+        }
+      }
+
+      double n = w * h;
+      double ma = sa / n, mb = sb / n;
+      double va = saa / n - ma * ma;
+      double vb = sbb / n - mb * mb;
+      double cov = sab / n - ma * mb;
+
+      total += ((2 * ma * mb + c1) * (2 * cov + c2)) /
+               ((ma * ma + mb * mb + c1) * (va + vb + c2));
+      blocks++;
+    }
+  }
+
+  return blocks ? total / blocks : 1.0;
+}
+
+Result Compare(const QImage& first, const QImage& second,
+               const Options& options) {
+  QImage a = first.convertToFormat(QImage::Format_ARGB32);
+  QImage b = second.convertToFormat(QImage::Format_ARGB32);
+  int width = a.width();
+  int height = a.height();
+  quint32 mask = options.ignoreAlpha ? 0x00ffffff : 0xffffffff;
+
+  Result result;
+  result.mismatched = 0;
+  result.maxDelta = 0;
+  result.ssim = 1.0;
+  if (options.diff)
+    result.diff = QImage(width, height, QImage::Format_ARGB32);
+
+  QVector<uchar> mismatch(width);
+  int left = width, right = -1, top = height, bottom = -1;
+
+  for (int y = 0; y < height; y++) {
+    const quint32* ra = reinterpret_cast<const quint32*>(a.constScanLine(y));
+    const quint32* rb = reinterpret_cast<const quint32*>(b.constScanLine(y));
+    result.maxDelta = qMax(result.maxDelta, CompareRow(ra, rb, width, mask,
+        options.tolerance, mismatch.data()));
+
+    int count = 0;
+    for (int x = 0; x < width; x++) {
+      if (mismatch[x]) {
+        left = qMin(left, x);
+        right = qMax(right, x);
+        count++;
+      }
+    }
+    if (count) {
+      top = qMin(top, y);
+      bottom = y;
+      result.mismatched += count;
+    }
+
+    if (options.diff) {
+      quint32* out = reinterpret_cast<quint32*>(result.diff.scanLine(y));
+      for (int x = 0; x < width; x++) {
+        int gray = 192 + qGray(ra[x]) / 4;
+        out[x] = mismatch[x] ? 0xffff0000 : qRgb(gray, gray, gray);
+      }
+    }
+  }
+
+  if (right >= 0)
+    result.bounds = QRect(QPoint(left, top), QPoint(right, bottom));
+
+  if (options.ssim && result.maxDelta > 0)
+    result.ssim = Ssim(a, b);
+
+  return result;
+}
+
+//
+// QUIRK:
+// CompareImages()
+// qt.compareImages(QImage a, QImage b, [Object options])
+// Not in Qt. Compares the decoded pixels of two images of the same size.
+// Options:
+//   tolerance: largest channel delta counted as equal, 0 by default
+//   ignoreAlpha: compare color channels only
+//   diff: also return a diff image, mismatches in red over a faded a
+//   ssim: also return the mean SSIM of luma over 8x8 blocks
+// Returns { mismatched, maxDelta, bounds: {x, y, width, height} or null,
+// [diff], [ssim] }
+//
+static Handle<Value> CompareImages(const Arguments& args) {
+  HandleScope scope;
+
+  if (!QImageWrap::HasInstance(args[0]) || !QImageWrap::HasInstance(args[1]))
+    return ThrowException(Exception::TypeError(
+        String::New("qt.compareImages: arguments must be QImages")));
+
+  QImage* a = node::ObjectWrap::Unwrap<QImageWrap>(
+      args[0]->ToObject())->GetWrapped();
+  QImage* b = node::ObjectWrap::Unwrap<QImageWrap>(
+      args[1]->ToObject())->GetWrapped();
+
+  if (a->size() != b->size())
+    return ThrowException(Exception::RangeError(
+        String::New("qt.compareImages: images differ in size")));
+
+  Options options;
+  options.tolerance = 0;
+  options.ignoreAlpha = false;
+  options.diff = false;
+  options.ssim = false;
+
+  if (args[2]->IsObject()) {
+    Local<Object> o = args[2]->ToObject();
+    Local<Value> tolerance = o->Get(String::NewSymbol("tolerance"));
+    if (tolerance->IsNumber())
+      options.tolerance = tolerance->IntegerValue();
+    options.ignoreAlpha = o->Get(String::NewSymbol("ignoreAlpha"))
+        ->BooleanValue();
+    options.diff = o->Get(String::NewSymbol("diff"))->BooleanValue();
+    options.ssim = o->Get(String::NewSymbol("ssim"))->BooleanValue();
+  }
+
+  Result result = Compare(*a, *b, options);
+
+  Local<Object> out = Object::New();
+  out->Set(String::NewSymbol("mismatched"), Integer::New(result.mismatched));
+  out->Set(String::NewSymbol("maxDelta"), Integer::New(result.maxDelta));
+
+  if (result.bounds.isNull()) {
+    out->Set(String::NewSymbol("bounds"), Null());
+  } else {
+    Local<Object> bounds = Object::New();
+    bounds->Set(String::NewSymbol("x"), Integer::New(result.bounds.x()));
+    bounds->Set(String::NewSymbol("y"), Integer::New(result.bounds.y()));
+    bounds->Set(String::NewSymbol("width"),
+                Integer::New(result.bounds.width()));
+    bounds->Set(String::NewSymbol("height"),
+                Integer::New(result.bounds.height()));
+    out->Set(String::NewSymbol("bounds"), bounds);
+  }
+
+  if (options.diff)
+    out->Set(String::NewSymbol("diff"), QImageWrap::NewInstance(result.diff));
+  if (options.ssim)
+    out->Set(String::NewSymbol("ssim"), Number::New(result.ssim));
+
+  return scope.Close(out);
+}
+
+void Initialize(Handle<Object> target) {
+  target->Set(String::NewSymbol("compareImages"),
+      FunctionTemplate::New(CompareImages)->GetFunction());
+}
+
+} // namespace ImageCompare
@@ -0,0 +1,67 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IMAGECOMPARE_H
+#define IMAGECOMPARE_H
+
+#define BUILDING_NODE_EXTENSION
+#include <node.h>
+#include <QImage>
+#include <QRect>
+
+//
+// ImageCompare
+// Pixel comparison of two images of the same size, vectorized with SSE2
+// where available. Exposed to JS as qt.compareImages()
+//
+namespace ImageCompare {
+
+struct Options {
+  int tolerance;    // largest channel delta still counted as equal
+  bool ignoreAlpha;
+  bool diff;        // build a diff image
+  bool ssim;        // compute SSIM
+};
+
+struct Result {
+  int mismatched;   // pixels with a channel delta above tolerance
+  int maxDelta;     // largest channel delta over all pixels
+  QRect bounds;     // bounding box of mismatched pixels, null if none
+  QImage diff;      // mismatches in red over a faded a
+  double ssim;      // mean SSIM of luma over 8x8 blocks, 1 if identical
+};
+
+// Compares a and b, which must have the same size. Any format is accepted
+Result Compare(const QImage& a, const QImage& b, const Options& options);
+
+void Initialize(v8::Handle<v8::Object> target);
+
+} // namespace ImageCompare
+
+#endif
@@ -0,0 +1,257 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "imageconvert.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace ImageConvert {
+
+//
+// Scalar kernels, also used for the tail of vectorized rows
+//
+
+// x / 255, rounded, for x in [0, 255 * 255]
+static inline uint Div255(uint x) {
+  return (x + (x >> 8) + 0x80) >> 8;
+}
+
+static inline quint32 PremultiplyPixel(quint32 p) {
+  uint a = p >> 24;
+  uint r = Div255(((p >> 16) & 0xff) * a);
+  uint g = Div255(((p >> 8) & 0xff) * a);
+  uint b = Div255((p & 0xff) * a);
+  return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+static inline uint UnpremultiplyChannel(uint c, uint a) {
+  uint v = (c * 255 + (a >> 1)) / a;
+  return v > 255 ? 255 : v;
+}
+
+static inline quint32 UnpremultiplyPixel(quint32 p) {
+  uint a = p >> 24;
+  if (a == 0)
+    return 0;
+  if (a == 255)
+    return p;
+  uint r = UnpremultiplyChannel((p >> 16) & 0xff, a);
+  uint g = UnpremultiplyChannel((p >> 8) & 0xff, a);
+  uint b = UnpremultiplyChannel(p & 0xff, a);
+  return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+// Swaps R and B: stored little-endian, 0xAABBGGRR is R, G, B, A in memory
+static inline quint32 SwizzlePixel(quint32 p) {
+  return (p & 0xff00ff00) | ((p >> 16) & 0xff) | ((p & 0xff) << 16);
+}
+
+static inline quint16 Rgb565Pixel(quint32 p) {
+  return ((p >> 8) & 0xf800) | ((p >> 5) & 0x07e0) | ((p >> 3) & 0x001f);
+}
+
+static inline uchar GrayPixel(quint32 p) {
+  return (((p >> 16) & 0xff) * 77 + ((p >> 8) & 0xff) * 150 +
+          (p & 0xff) * 29) >> 8;
+}
+
+static inline void StoreLE32(uchar* dst, quint32 p) {
+  dst[0] = p;
+  dst[1] = p >> 8;
+  dst[2] = p >> 16;
+  dst[3] = p >> 24;
+}
+
+//
+// Vectorized kernels, 4 pixels per iteration
+//
+
+void Premultiply(const quint32* src, quint32* dst, int n) {
+  int i = 0;
+#ifdef __SSE2__
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i half = _mm_set1_epi16(0x80);
+  const __m128i alphaMask = _mm_set1_epi32(0xff000000);
+
+  for (; i + 4 <= n; i += 4) {
+    __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+    // Two pixels per register, one channel per 16-bit lane
+    __m128i lo = _mm_unpacklo_epi8(p, zero);
+    __m128i hi = _mm_unpackhi_epi8(p, zero);
+
+    // Broadcast each pixel's alpha to its lanes
+    __m128i alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, 0xff), 0xff);
+    __m128i ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, 0xff), 0xff);
+
+    // Div255(c * a)
+    lo = _mm_mullo_epi16(lo, alo);
+    hi = _mm_mullo_epi16(hi, ahi);
+    lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)),
+                                      half), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)),
+                                      half), 8);
+
+    // Keep the original alpha
+    __m128i result = _mm_packus_epi16(lo, hi);
+    result = _mm_or_si128(_mm_andnot_si128(alphaMask, result),
+                          _mm_and_si128(alphaMask, p));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), result);
+  }
+#endif
+  for (; i < n; i++)
+    dst[i] = PremultiplyPixel(src[i]);
+}
+
+void Unpremultiply(const quint32* src, quint32* dst, int n) {
+  int i = 0;
+#ifdef __SSE2__
+  const __m128i mask = _mm_set1_epi32(0xff);
+  const __m128 max = _mm_set1_ps(255.0f);
+  const __m128 one = _mm_set1_ps(1.0f);
+
+  for (; i + 4 <= n; i += 4) {
+    __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+    __m128i ai = _mm_srli_epi32(p, 24);
+    __m128 a = _mm_cvtepi32_ps(ai);
+    __m128 halfA = _mm_cvtepi32_ps(_mm_srli_epi32(ai, 1));
+    __m128 divisor = _mm_max_ps(a, one);
+
+    // (c * 255 + a / 2) / a, exact in single precision for 8-bit inputs
+    __m128 r = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 16), mask));
+    __m128 g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 8), mask));
+    __m128 b = _mm_cvtepi32_ps(_mm_and_si128(p, mask));
+    r = _mm_min_ps(_mm_div_ps(_mm_add_ps(_mm_mul_ps(r, max), halfA), divisor),
+                   max);
+    g = _mm_min_ps(_mm_div_ps(_mm_add_ps(_mm_mul_ps(g, max), halfA), divisor),
+                   max);
+    b = _mm_min_ps(_mm_div_ps(_mm_add_ps(_mm_mul_ps(b, max), halfA), divisor),
+                   max);
+
+    __m128i result = _mm_or_si128(
+        _mm_or_si128(_mm_slli_epi32(ai, 24),
+                     _mm_slli_epi32(_mm_cvttps_epi32(r), 16)),
+        _mm_or_si128(_mm_slli_epi32(_mm_cvttps_epi32(g), 8),
+                     _mm_cvttps_epi32(b)));
+
+    // Fully transparent pixels become 0
+    __m128i transparent = _mm_cmpeq_epi32(ai, _mm_setzero_si128());
+    result = _mm_andnot_si128(transparent, result);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), result);
+  }
+#endif
+  for (; i < n; i++)
+    dst[i] = UnpremultiplyPixel(src[i]);
+}
+
+void SwizzleToRgba(const quint32* src, uchar* dst, int n) {
+  int i = 0;
+#ifdef __SSE2__
+  const __m128i keep = _mm_set1_epi32(0xff00ff00);
+  const __m128i low = _mm_set1_epi32(0xff);
+
+  for (; i + 4 <= n; i += 4) {
+    __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    __m128i result = _mm_or_si128(
+        _mm_and_si128(p, keep),
+        _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 16), low),
+                     _mm_slli_epi32(_mm_and_si128(p, low), 16)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), result);
+  }
+#endif
+  for (; i < n; i++)
+    StoreLE32(dst + i * 4, SwizzlePixel(src[i]));
+}
+
+void ToRgb565(const quint32* src, quint16* dst, int n) {
+  int i = 0;
+#ifdef __SSE2__
+  const __m128i red = _mm_set1_epi32(0xf800);
+  const __m128i green = _mm_set1_epi32(0x07e0);
+  const __m128i blue = _mm_set1_epi32(0x001f);
+  const __m128i bias = _mm_set1_epi32(0x8000);
+  const __m128i unbias = _mm_set1_epi16((short)0x8000);
+
+  for (; i + 8 <= n; i += 8) {
+    __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    __m128i p1 = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(src + i + 4));
+
+    __m128i r0 = _mm_or_si128(
+        _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p0, 8), red),
+                     _mm_and_si128(_mm_srli_epi32(p0, 5), green)),
+        _mm_and_si128(_mm_srli_epi32(p0, 3), blue));
+    __m128i r1 = _mm_or_si128(
+        _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p1, 8), red),
+                     _mm_and_si128(_mm_srli_epi32(p1, 5), green)),
+        _mm_and_si128(_mm_srli_epi32(p1, 3), blue));
+
+    // Signed saturating pack: move to signed range and back
+    __m128i result = _mm_xor_si128(
+        _mm_packs_epi32(_mm_sub_epi32(r0, bias), _mm_sub_epi32(r1, bias)),
+        unbias);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), result);
+  }
+#endif
+  for (; i < n; i++)
+    dst[i] = Rgb565Pixel(src[i]);
+}
+
+void ToGray8(const quint32* src, uchar* dst, int n) {
+  int i = 0;
+#ifdef __SSE2__
+  const __m128i mask = _mm_set1_epi32(0xff);
+  const __m128i kr = _mm_set1_epi32(77);
+  const __m128i kg = _mm_set1_epi32(150);
+  const __m128i kb = _mm_set1_epi32(29);
+
+  for (; i + 4 <= n; i += 4) {
+    __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+    // Products fit in the low 16 bits of each 32-bit lane
+    __m128i r = _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(p, 16), mask), kr);
+    __m128i g = _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(p, 8), mask), kg);
+    __m128i b = _mm_mullo_epi16(_mm_and_si128(p, mask), kb);
+    __m128i y = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(r, g), b), 8);
+
+    y = _mm_packs_epi32(y, y);
+    y = _mm_packus_epi16(y, y);
+    StoreLE32(dst + i, _mm_cvtsi128_si32(y));
+  }
+#endif
+  for (; i < n; i++)
+    dst[i] = GrayPixel(src[i]);
+}
+
+} // namespace ImageConvert
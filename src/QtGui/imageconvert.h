@@ -0,0 +1,60 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IMAGECONVERT_H
+#define IMAGECONVERT_H
+
+#include <QImage>
+
+//
+// ImageConvert
+// Row kernels for common 32-bit pixel format conversions, vectorized with
+// SSE2 where available and scalar otherwise. Sources are 0xAARRGGBB pixels
+// (QImage::Format_RGB32/ARGB32/ARGB32_Premultiplied)
+//
+namespace ImageConvert {
+
+// ARGB32 -> ARGB32_Premultiplied. src and dst may be the same
+void Premultiply(const quint32* src, quint32* dst, int n);
+
+// ARGB32_Premultiplied -> ARGB32. src and dst may be the same
+void Unpremultiply(const quint32* src, quint32* dst, int n);
+
+// ARGB32 -> R, G, B, A bytes. src and dst may be the same
+void SwizzleToRgba(const quint32* src, uchar* dst, int n);
+
+// RGB32/ARGB32 -> RGB565, alpha ignored
+void ToRgb565(const quint32* src, quint16* dst, int n);
+
+// RGB32/ARGB32 -> 8-bit luma (0.30 R + 0.59 G + 0.11 B), alpha ignored
+void ToGray8(const quint32* src, uchar* dst, int n);
+
+} // namespace ImageConvert
+
+#endif
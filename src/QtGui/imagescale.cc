@@ -0,0 +1,339 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "imagescale.h"
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QVector>
+#include <math.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace ImageScale {
+
+//
+// Filter kernels, in units of source pixels at 1:1
+//
+
+static double BoxKernel(double x) {
+  return x >= -0.5 && x < 0.5 ? 1.0 : 0.0;
+}
+
+static double TriangleKernel(double x) {
+  x = fabs(x);
+  return x < 1.0 ? 1.0 - x : 0.0;
+}
+
+static double Sinc(double x) {
+  if (x == 0.0)
+    return 1.0;
+  x *= M_PI;
+  return sin(x) / x;
+}
+
+static double LanczosKernel(double x) {
+  return x > -3.0 && x < 3.0 ? Sinc(x) * Sinc(x / 3.0) : 0.0;
+}
+
+//
+// Contributions
+// Source pixels and normalized weights for each destination pixel along
+// one axis. Weights are stored taps per destination pixel, zero padded
+//
+struct Contributions {
+  int taps;
+  QVector<int> start;
+  QVector<int> count;
+  QVector<float> weights;
+};
+
+static void ComputeContributions(int srcSize, int dstSize, Filter filter,
+                                 Contributions* c) {
+  double (*kernel)(double);
+  double support;
+  switch (filter) {
+    case Box:
+      kernel = BoxKernel;
+      support = 0.5;
+      break;
+    case Lanczos3:
+      kernel = LanczosKernel;
+      support = 3.0;
+      break;
+    default:
+      kernel = TriangleKernel;
+      support = 1.0;
+      break;
+  }
+
+  // When downscaling the kernel is stretched over the source, so every
+  // source pixel contributes
+  double scale = (double) srcSize / dstSize;
+  double filterScale = qMax(scale, 1.0);
+  support *= filterScale;
+
+  c->taps = (int) ceil(support) * 2 + 1;
+  c->start.resize(dstSize);
+  c->count.resize(dstSize);
+  c->weights.fill(0.0f, dstSize * c->taps);
+
+  for (int i = 0; i < dstSize; i++) {
+    double center = (i + 0.5) * scale;
+    int lo = qMax(0, (int) floor(center - support + 0.5));
+    int hi = qMin(srcSize, (int) floor(center + support + 0.5));
+    float* w = c->weights.data() + i * c->taps;
+
+    double total = 0.0;
+    for (int j = lo; j < hi; j++) {
+      w[j - lo] = kernel((j + 0.5 - center) / filterScale);
+      total += w[j - lo];
+    }
+
+    if (total == 0.0) {
+      // Rounding left no source pixel under a box: take the nearest
+      lo = qBound(0, (int) center, srcSize - 1);
+      hi = lo + 1;
+      w[0] = 1.0f;
+      total = 1.0;
+    }
+
+    for (int j = 0; j < hi - lo; j++)
+      w[j] /= total;
+
+    c->start[i] = lo;
+    c->count[i] = hi - lo;
+  }
+}
+
+//
+// Pixel
+// The four 8-bit channels of a pixel as floats, in memory order
+//
+#ifdef __SSE2__
+
+typedef __m128 Pixel;
+
+static inline Pixel Zero() {
+  return _mm_setzero_ps();
+}
+
+static inline Pixel Load(quint32 p) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i v = _mm_cvtsi32_si128(p);
+  v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(v, zero), zero);
+  return _mm_cvtepi32_ps(v);
+}
+
+static inline Pixel LoadF(const float* f) {
+  return _mm_loadu_ps(f);
+}
+
+static inline void StoreF(float* f, Pixel p) {
+  _mm_storeu_ps(f, p);
+}
+
+static inline Pixel MulAdd(Pixel acc, Pixel p, float w) {
+  return _mm_add_ps(acc, _mm_mul_ps(p, _mm_set1_ps(w)));
+}
+
+// Clamps to [0, alpha], as filters with negative lobes overshoot
+static inline quint32 Store(Pixel p) {
+  p = _mm_min_ps(_mm_max_ps(p, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+  p = _mm_min_ps(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3)));
+  __m128i v = _mm_cvtps_epi32(p);
+  v = _mm_packs_epi32(v, v);
+  v = _mm_packus_epi16(v, v);
+  return _mm_cvtsi128_si32(v);
+}
+
+#else
+
+struct Pixel {
+  float v[4];
+};
+
+static inline Pixel Zero() {
+  Pixel p = { { 0.0f, 0.0f, 0.0f, 0.0f } };
+  return p;
+}
+
+static inline Pixel Load(quint32 p) {
+  Pixel r = { { (float) (p & 0xff), (float) ((p >> 8) & 0xff),
+                (float) ((p >> 16) & 0xff), (float) (p >> 24) } };
+  return r;
+}
+
+static inline Pixel LoadF(const float* f) {
+  Pixel r = { { f[0], f[1], f[2], f[3] } };
+  return r;
+}
+
+static inline void StoreF(float* f, Pixel p) {
+  for (int i = 0; i < 4; i++)
+    f[i] = p.v[i];
+}
+
+static inline Pixel MulAdd(Pixel acc, Pixel p, float w) {
+  for (int i = 0; i < 4; i++)
+    acc.v[i] += p.v[i] * w;
+  return acc;
+}
+
+static inline quint32 Store(Pixel p) {
+  float alpha = qBound(0.0f, p.v[3], 255.0f);
+  quint32 r = 0;
+  for (int i = 0; i < 4; i++) {
+    float c = qBound(0.0f, p.v[i], alpha);
+    r |= (quint32) floor(c + 0.5f) << (i * 8);
+  }
+  return r;
+}
+
+#endif
+
+//
+// Job
+// Read-only description of a scale, shared by all bands
+//
+struct Job {
+  const uchar* src;
+  int srcStride;
+  uchar* dst;
+  int dstStride;
+  int dstWidth;
+  const Contributions* horizontal;
+  const Contributions* vertical;
+};
+
+// Scales destination rows [y0, y1): filters the source rows they need
+// horizontally, then those intermediate rows vertically
+static void ScaleBand(const Job& job, int y0, int y1) {
+  const Contributions& h = *job.horizontal;
+  const Contributions& v = *job.vertical;
+  int width = job.dstWidth;
+
+  int first = v.start[y0];
+  int last = first;
+  for (int y = y0; y < y1; y++)
+    last = qMax(last, v.start[y] + v.count[y]);
+
+  QVector<float> rows((last - first) * width * 4);
+
+  for (int r = first; r < last; r++) {
+    const quint32* in = reinterpret_cast<const quint32*>(
+        job.src + r * job.srcStride);
+    float* out = rows.data() + (r - first) * width * 4;
+    for (int x = 0; x < width; x++) {
+      const quint32* s = in + h.start[x];
+      const float* w = h.weights.constData() + x * h.taps;
+      Pixel acc = Zero();
+      for (int k = 0; k < h.count[x]; k++)
+        acc = MulAdd(acc, Load(s[k]), w[k]);
+      StoreF(out + x * 4, acc);
+    }
+  }
+
+  for (int y = y0; y < y1; y++) {
+    quint32* out = reinterpret_cast<quint32*>(job.dst + y * job.dstStride);
+    const float* in = rows.constData() + (v.start[y] - first) * width * 4;
+    const float* w = v.weights.constData() + y * v.taps;
+    for (int x = 0; x < width; x++) {
+      Pixel acc = Zero();
+      for (int k = 0; k < v.count[y]; k++)
+        acc = MulAdd(acc, LoadF(in + (k * width + x) * 4), w[k]);
+      out[x] = Store(acc);
+    }
+  }
+}
+
+//
+// BandTask
+// Runs one band on the thread pool and signals the caller
+//
+class BandTask : public QRunnable {
+ public:
+  BandTask(const Job& job, int y0, int y1, QSemaphore* done)
+    : job_(job), y0_(y0), y1_(y1), done_(done) {}
+
+  void run() {
+    ScaleBand(job_, y0_, y1_);
+    done_->release();
+  }
+
+ private:
+  Job job_;
+  int y0_;
+  int y1_;
+  QSemaphore* done_;
+};
+
+QImage Scale(const QImage& image, int width, int height, Filter filter,
+             int threads) {
+  QImage src = image;
+  if (src.format() != QImage::Format_RGB32 &&
+      src.format() != QImage::Format_ARGB32_Premultiplied)
+    src = src.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+  QImage dst(width, height, src.format());
+  if (src.isNull() || dst.isNull())
+    return QImage();
+
+  Contributions horizontal, vertical;
+  ComputeContributions(src.width(), width, filter, &horizontal);
+  ComputeContributions(src.height(), height, filter, &vertical);
+
+  // Pointers are taken here: scanLine() may detach, bands must not
+  Job job;
+  job.src = src.constBits();
+  job.srcStride = src.bytesPerLine();
+  job.dst = dst.bits();
+  job.dstStride = dst.bytesPerLine();
+  job.dstWidth = width;
+  job.horizontal = &horizontal;
+  job.vertical = &vertical;
+
+  threads = qBound(1, threads, height);
+  int band = (height + threads - 1) / threads;
+  int bands = (height + band - 1) / band;
+
+  // The calling thread runs the first band itself
+  QSemaphore done;
+  for (int i = 1; i < bands; i++)
+    QThreadPool::globalInstance()->start(
+        new BandTask(job, i * band, qMin(height, (i + 1) * band), &done));
+  ScaleBand(job, 0, qMin(height, band));
+  done.acquire(bands - 1);
+
+  return dst;
+}
+
+} // namespace ImageScale
@@ -0,0 +1,263 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "paintcommands.h"
+#include <math.h>
+
+namespace PaintCommands {
+
+// Number of operands of each opcode, -1 for unknown opcodes
+static int OperandCount(int opcode) {
+  switch (opcode) {
+    case Save: return 0;
+    case Restore: return 0;
+    case SetPen: return 2;
+    case SetBrush: return 1;
+    case SetFont: return 2;
+    case Translate: return 2;
+    case Scale: return 2;
+    case FillRect: return 5;
+    case DrawRect: return 4;
+    case DrawLine: return 4;
+    case DrawText: return 3;
+    case DrawImage: return 3;
+    case DrawPixmap: return 3;
+  }
+  return -1;
+}
+
+// argb is validated by Check() first: casting NaN or out of range doubles
+// is undefined
+static inline QColor ToColor(double argb) {
+  return QColor::fromRgba(static_cast<QRgb>(argb));
+}
+
+// Validates a side table index. NaN fails both comparisons
+static inline bool InRange(double index, int size) {
+  return index >= 0 && index < size;
+}
+
+static inline bool IsColor(double argb) {
+  return argb >= 0 && argb <= 4294967295.0;
+}
+
+void ConvertPixmaps(Resources* resources) {
+  for (int i = 0; i < resources->pixmaps.size(); i++) {
+    if (!resources->pixmaps[i].isNull()) {
+      resources->images[i] = resources->pixmaps[i].toImage();
+      resources->pixmaps[i] = QPixmap();
+    }
+  }
+}
+
+//
+// Check()
+// Validates the command at pc: a known opcode, all of its operands, side
+// table indices in range, and colors and font sizes that fit the integers
+// they are cast to. Returns its operand count, or -1 with error set.
+// Execute() relies on it for every command it runs
+//
+static int Check(const double* commands, int pc, int length,
+                 const Resources& resources, QString* error) {
+  // Opcodes are small integers; anything else can't be cast safely
+  double code = commands[pc];
+  if (!(code >= 0 && code < 256) || code != floor(code)) {
+    *error = QString("unknown opcode %1 at %2").arg(code).arg(pc);
+    return -1;
+  }
+
+  int opcode = static_cast<int>(code);
+  int operands = OperandCount(opcode);
+
+  if (operands < 0) {
+    *error = QString("unknown opcode %1 at %2").arg(opcode).arg(pc);
+    return -1;
+  }
+  if (pc + operands >= length) {
+    *error = QString("truncated command at %1").arg(pc);
+    return -1;
+  }
+
+  const double* a = commands + pc + 1;
+
+  bool operand = true;
+  switch (opcode) {
+    case SetPen:
+    case SetBrush:
+      operand = IsColor(a[0]);
+      break;
+
+    case SetFont:
+      operand = a[1] >= 1 && a[1] < (1 << 16);
+      break;
+
+    case FillRect:
+      operand = IsColor(a[4]);
+      break;
+  }
+
+  if (!operand) {
+    *error = QString("invalid operand at %1").arg(pc);
+    return -1;
+  }
+
+  bool valid = true;
+  const char* table = "";
+
+  switch (opcode) {
+    case SetFont:
+      valid = InRange(a[0], resources.strings.size());
+      table = "string";
+      break;
+
+    case DrawText:
+      valid = InRange(a[2], resources.strings.size());
+      table = "string";
+      break;
+
+    case DrawImage:
+      valid = InRange(a[2], resources.images.size());
+      table = "image";
+      break;
+
+    case DrawPixmap:
+      valid = InRange(a[2], resources.pixmaps.size());
+      table = "pixmap";
+      break;
+  }
+
+  if (!valid) {
+    *error = QString("bad %1 index at %2").arg(table).arg(pc);
+    return -1;
+  }
+
+  return operands;
+}
+
+bool Validate(const double* commands, int length, const Resources& resources,
+              QString* error) {
+  int pc = 0;
+
+  while (pc < length) {
+    int operands = Check(commands, pc, length, resources, error);
+    if (operands < 0)
+      return false;
+
+    pc += 1 + operands;
+  }
+
+  return true;
+}
+
+bool Execute(QPainter* painter, const double* commands, int length,
+             const Resources& resources, QString* error) {
+  int pc = 0;
+
+  while (pc < length) {
+    int operands = Check(commands, pc, length, resources, error);
+    if (operands < 0)
+      return false;
+
+    int opcode = static_cast<int>(commands[pc]);
+    const double* a = commands + pc + 1;
+
+    switch (opcode) {
+      case Save:
+        painter->save();
+        break;
+
+      case Restore:
+        painter->restore();
+        break;
+
+      case SetPen:
+        painter->setPen(QPen(QBrush(ToColor(a[0])), a[1]));
+        break;
+
+      case SetBrush:
+        painter->setBrush(QBrush(ToColor(a[0])));
+        break;
+
+      case SetFont: {
+        QFont font(resources.strings[static_cast<int>(a[0])]);
+        font.setPixelSize(static_cast<int>(a[1]));
+        painter->setFont(font);
+        break;
+      }
+
+      case Translate:
+        painter->translate(a[0], a[1]);
+        break;
+
+      case Scale:
+        painter->scale(a[0], a[1]);
+        break;
+
+      case FillRect:
+        painter->fillRect(QRectF(a[0], a[1], a[2], a[3]), ToColor(a[4]));
+        break;
+
+      case DrawRect:
+        painter->drawRect(QRectF(a[0], a[1], a[2], a[3]));
+        break;
+
+      case DrawLine:
+        painter->drawLine(QPointF(a[0], a[1]), QPointF(a[2], a[3]));
+        break;
+
+      case DrawText:
+        painter->drawText(QPointF(a[0], a[1]),
+                          resources.strings[static_cast<int>(a[2])]);
+        break;
+
+      case DrawImage:
+        painter->drawImage(QPointF(a[0], a[1]),
+                           resources.images[static_cast<int>(a[2])]);
+        break;
+
+      case DrawPixmap:
+        if (resources.pixmaps[static_cast<int>(a[2])].isNull() &&
+            InRange(a[2], resources.images.size())) {
+          // Converted to an image to paint outside the GUI thread
+          painter->drawImage(QPointF(a[0], a[1]),
+                             resources.images[static_cast<int>(a[2])]);
+          break;
+        }
+        painter->drawPixmap(QPointF(a[0], a[1]),
+                            resources.pixmaps[static_cast<int>(a[2])]);
+        break;
+    }
+
+    pc += 1 + operands;
+  }
+
+  return true;
+}
+
+} // namespace PaintCommands
@@ -0,0 +1,91 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef PAINTCOMMANDS_H
+#define PAINTCOMMANDS_H
+
+#include <QPainter>
+#include <QImage>
+#include <QPixmap>
+#include <QString>
+#include <QVector>
+
+//
+// PaintCommands
+// Executes a display list encoded as an array of doubles: an opcode
+// followed by its operands. Colors are packed 0xAARRGGBB values. Strings
+// and images are referenced by index into side tables, so that a whole
+// batch can be run with a single call from JS (see lib/paintcommands.js,
+// which must be kept in sync with the opcodes below)
+//
+namespace PaintCommands {
+
+enum Opcode {
+  Save = 1,
+  Restore = 2,
+  SetPen = 3,       // argb, width
+  SetBrush = 4,     // argb
+  SetFont = 5,      // family (string index), pixel size
+  Translate = 6,    // dx, dy
+  Scale = 7,        // sx, sy
+  FillRect = 8,     // x, y, w, h, argb
+  DrawRect = 9,     // x, y, w, h
+  DrawLine = 10,    // x1, y1, x2, y2
+  DrawText = 11,    // x, y, text (string index)
+  DrawImage = 12,   // x, y, image (image index)
+  DrawPixmap = 13   // x, y, pixmap (image index)
+};
+
+// Side tables referenced by commands. images and pixmaps are indexed alike;
+// entries of the other type are null and draw nothing. DrawPixmap falls
+// back to the image at its index if the pixmap is null (see TiledRender)
+struct Resources {
+  QVector<QString> strings;
+  QVector<QImage> images;
+  QVector<QPixmap> pixmaps;
+};
+
+// Replaces pixmaps by images, which unlike pixmaps can be painted outside
+// the GUI thread. Call from the GUI thread
+void ConvertPixmaps(Resources* resources);
+
+// Checks length doubles of commands against resources without painting,
+// for batches run later or elsewhere. Returns false and sets error on
+// malformed input, as Execute() would
+bool Validate(const double* commands, int length, const Resources& resources,
+              QString* error);
+
+// Runs length doubles of commands on painter. Returns false and sets error
+// (commands before the faulty one have been executed) on malformed input
+bool Execute(QPainter* painter, const double* commands, int length,
+             const Resources& resources, QString* error);
+
+} // namespace PaintCommands
+
+#endif
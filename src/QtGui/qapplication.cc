@@ -29,26 +29,75 @@
 
 #define BUILDING_NODE_EXTENSION
 #include <node.h>
+#include <stdlib.h>
+#include <QElapsedTimer>
+#include <QHash>
 #include "qapplication.h"
+#include "frameclock.h"
+#include "../qt_v8.h"
+#include "../QtCore/quveventdispatcher.h"
 
 using namespace v8;
 
 Persistent<Function> QApplicationWrap::constructor;
+Persistent<FunctionTemplate> QApplicationWrap::constructor_template;
 
 int QApplicationWrap::argc_ = 0;
 char** QApplicationWrap::argv_ = NULL;
 
-QApplicationWrap::QApplicationWrap() {
-  q_ = new QApplication(argc_, argv_);
+// Interval of the polling fallback, in ms
+static const int kPollInterval = 10;
+
+//
+// EventCounter
+// Application-wide event filter tallying delivered events by type
+//
+class EventCounter : public QObject {
+ public:
+  EventCounter() : total_(0) {}
+  bool eventFilter(QObject* obj, QEvent* e) {
+    counts_[e->type()]++;
+    total_++;
+    return false;
+  }
+  QHash<int, int> counts_;
+  int total_;
+};
+
+QApplicationWrap::QApplicationWrap(bool headless,
+                                   const QString& graphicsSystem)
+    : dispatcher_(NULL), poll_timer_(NULL) {
+#ifdef Q_WS_X11
+  // Must exist before QApplication, which would otherwise install its own
+  dispatcher_ = new QUvEventDispatcher;
+#endif
+
+  if (!graphicsSystem.isEmpty())
+    QApplication::setGraphicsSystem(graphicsSystem);
+
+  // Tty applications never connect to the window system. Painting is done
+  // on QImage in client memory; widgets and pixmaps are unavailable
+  q_ = new QApplication(argc_, argv_,
+      headless ? QApplication::Tty : QApplication::GuiClient);
+
+  if (dispatcher_)
+    dispatcher_->AttachDisplay();
 }
 
 QApplicationWrap::~QApplicationWrap() {
+  if (poll_timer_) {
+    uv_timer_stop(poll_timer_);
+    uv_close(reinterpret_cast<uv_handle_t*>(poll_timer_), OnClosePollTimer);
+  }
+
   delete q_;
+  delete dispatcher_;
 }
 
 void QApplicationWrap::Initialize(Handle<Object> target) {
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
   tpl->SetClassName(String::NewSymbol("QApplication"));
   tpl->InstanceTemplate()->SetInternalFieldCount(1);  
 
@@ -57,39 +106,226 @@ void QApplicationWrap::Initialize(Handle<Object> target) {
       FunctionTemplate::New(ProcessEvents)->GetFunction());
   tpl->PrototypeTemplate()->Set(String::NewSymbol("exec"),
       FunctionTemplate::New(Exec)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("quit"),
+      FunctionTemplate::New(Quit)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("isHeadless"),
+      FunctionTemplate::New(IsHeadless)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("requestFrame"),
+      FunctionTemplate::New(RequestFrame)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setFrameInterval"),
+      FunctionTemplate::New(SetFrameInterval)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("frameInterval"),
+      FunctionTemplate::New(FrameInterval)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("frameStats"),
+      FunctionTemplate::New(FrameStats)->GetFunction());
 
   constructor = Persistent<Function>::New(
       tpl->GetFunction());
   target->Set(String::NewSymbol("QApplication"), constructor);
 }
 
+bool QApplicationWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
+// Supported versions:
+//   QApplication()
+//   QApplication({ headless: <bool>, graphicsSystem: <string> })
+//
+// QUIRK:
+// Options replace Qt's QApplication(argc, argv, type) and
+// setGraphicsSystem(). headless creates a Tty application that needs no
+// display; graphicsSystem ('raster', 'native', ...) selects the paint
+// backend, e.g. 'raster' keeps pixmaps in client memory on X11
 Handle<Value> QApplicationWrap::New(const Arguments& args) {
   HandleScope scope;
 
-  QApplicationWrap* w = new QApplicationWrap();
+  bool headless = false;
+  QString graphicsSystem;
+
+  if (args[0]->IsObject()) {
+    Local<Object> options = args[0]->ToObject();
+    headless = options->Get(String::NewSymbol("headless"))->BooleanValue();
+
+    Local<Value> system = options->Get(String::NewSymbol("graphicsSystem"));
+    if (system->IsString())
+      graphicsSystem = qt_v8::ToQString(system->ToString());
+  }
+
+  QApplicationWrap* w = new QApplicationWrap(headless, graphicsSystem);
   w->Wrap(args.This());
 
   return args.This();
 }
 
+// Supported versions:
+//   processEvents()
+//   processEvents(int maxtime, QEventLoop::ProcessEventsFlags flags = 0)
+//
+// The second form processes events for at most maxtime ms and returns the
+// pass statistics:
+//   { delivered: <int>, elapsed: <ms>, pending: <bool>,
+//     events: { <QEvent::Type>: <count>, ... } }
 Handle<Value> QApplicationWrap::ProcessEvents(const Arguments& args) {
   HandleScope scope;
 
   QApplicationWrap* w = ObjectWrap::Unwrap<QApplicationWrap>(args.This());
   QApplication* q = w->GetWrapped();
 
-  q->processEvents();
+  if (!args[0]->IsNumber()) {
+    q->processEvents();
+    return scope.Close(Undefined());
+  }
 
-  return scope.Close(Undefined());
+  QEventLoop::ProcessEventsFlags flags(
+      args[1]->IsNumber() ? args[1]->IntegerValue() : 0);
+
+  EventCounter counter;
+  QElapsedTimer timer;
+
+  q->installEventFilter(&counter);
+  timer.start();
+  q->processEvents(flags, args[0]->IntegerValue());
+  qint64 elapsed = timer.nsecsElapsed();
+  q->removeEventFilter(&counter);
+
+  Local<Object> events = Object::New();
+  QHash<int, int>::const_iterator i;
+  for (i = counter.counts_.constBegin(); i != counter.counts_.constEnd(); ++i)
+    events->Set(Integer::New(i.key()), Integer::New(i.value()));
+
+  Local<Object> stats = Object::New();
+  stats->Set(String::NewSymbol("delivered"), Integer::New(counter.total_));
+  stats->Set(String::NewSymbol("elapsed"), Number::New(elapsed / 1e6));
+  stats->Set(String::NewSymbol("pending"), Boolean::New(q->hasPendingEvents()));
+  stats->Set(String::NewSymbol("events"), events);
+
+  return scope.Close(stats);
 }
 
+//
+// QUIRK:
+// Here: exec() joins Node's event loop and returns immediately. Qt sleeps
+//   with Node and is woken up by window system input, timers and sockets.
+//   Node stays alive until quit() is called
+// Qt: exec() blocks until quit()
+// On platforms without the native dispatcher Qt is polled from a libuv timer
+//
 Handle<Value> QApplicationWrap::Exec(const Arguments& args) {
   HandleScope scope;
 
   QApplicationWrap* w = ObjectWrap::Unwrap<QApplicationWrap>(args.This());
-  QApplication* q = w->GetWrapped();
 
-  q->exec();
+  if (w->dispatcher_) {
+    w->dispatcher_->SetRef(true);
+  } else if (!w->poll_timer_) {
+    w->poll_timer_ = static_cast<uv_timer_t*>(malloc(sizeof(uv_timer_t)));
+    uv_timer_init(uv_default_loop(), w->poll_timer_);
+    w->poll_timer_->data = w;
+    uv_timer_start(w->poll_timer_, OnPollTimer, 0, kPollInterval);
+  }
+
+  return scope.Close(Undefined());
+}
+
+//
+// QUIRK:
+// Here: quit() detaches from Node's event loop, letting Node exit once it
+//   has nothing else to do
+// Qt: quit() makes exec() return
+//
+Handle<Value> QApplicationWrap::Quit(const Arguments& args) {
+  HandleScope scope;
+
+  QApplicationWrap* w = ObjectWrap::Unwrap<QApplicationWrap>(args.This());
+
+  if (w->dispatcher_) {
+    w->dispatcher_->SetRef(false);
+  } else if (w->poll_timer_) {
+    uv_timer_stop(w->poll_timer_);
+    uv_close(reinterpret_cast<uv_handle_t*>(w->poll_timer_), OnClosePollTimer);
+    w->poll_timer_ = NULL;
+  }
 
   return scope.Close(Undefined());
 }
+
+Handle<Value> QApplicationWrap::IsHeadless(const Arguments& args) {
+  HandleScope scope;
+
+  return scope.Close(Boolean::New(
+      QApplication::type() == QApplication::Tty));
+}
+
+//
+// QUIRK:
+// RequestFrame()
+// Not in Qt. Calls callback(timestamp) once, on the next tick of the frame
+// clock. All callbacks and widget repaints pending for a frame are run
+// together; while frames are pending, QWidget update() calls are deferred
+// to the next frame and merged into a single repaint() per widget
+//
+Handle<Value> QApplicationWrap::RequestFrame(const Arguments& args) {
+  HandleScope scope;
+
+  if (!args[0]->IsFunction())
+    return ThrowException(Exception::TypeError(
+        String::New("QApplicationWrap::RequestFrame: argument not a function")));
+
+  FrameClock::Instance()->RequestFrame(Local<Function>::Cast(args[0]));
+
+  return scope.Close(Undefined());
+}
+
+//
+// QUIRK:
+// SetFrameInterval()
+// Not in Qt. Sets the frame clock period in ms (default 1000/60)
+//
+Handle<Value> QApplicationWrap::SetFrameInterval(const Arguments& args) {
+  HandleScope scope;
+
+  double interval = args[0]->NumberValue();
+  if (!(interval > 0))
+    return ThrowException(Exception::RangeError(
+        String::New("QApplicationWrap::SetFrameInterval: bad interval")));
+
+  FrameClock::Instance()->SetInterval(interval);
+
+  return scope.Close(Undefined());
+}
+
+Handle<Value> QApplicationWrap::FrameInterval(const Arguments& args) {
+  HandleScope scope;
+
+  return scope.Close(Number::New(FrameClock::Instance()->Interval()));
+}
+
+//
+// QUIRK:
+// FrameStats()
+// Not in Qt. Returns frame clock statistics:
+//   { frames: <int>, missed: <int>, interval: <ms>, lastFrameTime: <ms>,
+//     pending: <int> }
+// 'missed' counts frame deadlines skipped because a tick ran late
+//
+Handle<Value> QApplicationWrap::FrameStats(const Arguments& args) {
+  HandleScope scope;
+
+  return scope.Close(FrameClock::Instance()->Stats());
+}
+
+void QApplicationWrap::OnPollTimer(uv_timer_t* handle, int status) {
+  HandleScope scope;
+  TryCatch try_catch;
+
+  QApplicationWrap* w = static_cast<QApplicationWrap*>(handle->data);
+  w->GetWrapped()->processEvents();
+
+  if (try_catch.HasCaught())
+    node::FatalException(try_catch);
+}
+
+void QApplicationWrap::OnClosePollTimer(uv_handle_t* handle) {
+  free(handle);
+}
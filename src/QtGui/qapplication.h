@@ -31,25 +31,48 @@
 #define QAPPLICATIONWRAP_H
 
 #include <node.h>
+#include <uv.h>
 #include <QApplication>
 
+class QUvEventDispatcher;
+
 class QApplicationWrap : public node::ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
+  static bool HasInstance(v8::Handle<v8::Value> value);
   QApplication* GetWrapped() const { return q_; };
 
  private:
-  QApplicationWrap();
+  QApplicationWrap(bool headless, const QString& graphicsSystem);
   ~QApplicationWrap();
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> constructor_template;
   static v8::Handle<v8::Value> New(const v8::Arguments& args);
 
   // Wrapped methods
   static v8::Handle<v8::Value> ProcessEvents(const v8::Arguments& args);
   static v8::Handle<v8::Value> Exec(const v8::Arguments& args);
+  static v8::Handle<v8::Value> Quit(const v8::Arguments& args);
+  static v8::Handle<v8::Value> IsHeadless(const v8::Arguments& args);
+
+  // Frame clock
+  static v8::Handle<v8::Value> RequestFrame(const v8::Arguments& args);
+  static v8::Handle<v8::Value> SetFrameInterval(const v8::Arguments& args);
+  static v8::Handle<v8::Value> FrameInterval(const v8::Arguments& args);
+  static v8::Handle<v8::Value> FrameStats(const v8::Arguments& args);
+
+  // Fallback for platforms without a native dispatcher: polls Qt from a
+  // libuv timer while exec() is in effect
+  static void OnPollTimer(uv_timer_t* handle, int status);
+  static void OnClosePollTimer(uv_handle_t* handle);
 
   // Wrapped object
   QApplication* q_;
+
+  // Owned here: Qt 4 doesn't delete dispatchers installed before the
+  // application. Outlives q_, which unregisters from it when destroyed
+  QUvEventDispatcher* dispatcher_;
+  uv_timer_t* poll_timer_;
   static int argc_;
   static char** argv_;
 };
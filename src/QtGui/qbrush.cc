@@ -30,29 +30,36 @@
 #define BUILDING_NODE_EXTENSION
 #include <node.h>
 #include "qbrush.h"
+#include "qpixmap.h"
 
 using namespace v8;
 
 Persistent<Function> QBrushWrap::constructor;
+Persistent<FunctionTemplate> QBrushWrap::constructor_template;
 
 // Supported constructors
 // QBrush(Qt::GlobalColor)  
+// QBrush(QPixmap)
 QBrushWrap::QBrushWrap(const Arguments& args) {
-  if (args.Length() > 0) {
-    q_ = new QBrush((Qt::GlobalColor)args[0]->IntegerValue());
+  if (QPixmapWrap::HasInstance(args[0])) {
+    // QBrush(QPixmap)
+    q_ = QBrush(*ObjectWrap::Unwrap<QPixmapWrap>(
+        args[0]->ToObject())->GetWrapped());
+  } else if (args.Length() > 0) {
+    q_ = QBrush((Qt::GlobalColor)args[0]->IntegerValue());
   } else {
     // QBrush()
-    q_ = new QBrush();
+    q_ = QBrush();
   }
 }
 
 QBrushWrap::~QBrushWrap() {
-  delete q_;
 }
 
 void QBrushWrap::Initialize(Handle<Object> target) {
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
   tpl->SetClassName(String::NewSymbol("QBrush"));
   tpl->InstanceTemplate()->SetInternalFieldCount(1);  
 
@@ -62,6 +69,10 @@ void QBrushWrap::Initialize(Handle<Object> target) {
   target->Set(String::NewSymbol("QBrush"), constructor);
 }
 
+bool QBrushWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
 Handle<Value> QBrushWrap::New(const Arguments& args) {
   HandleScope scope;
 
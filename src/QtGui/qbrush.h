@@ -37,18 +37,20 @@
 class QBrushWrap : public node::ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
-  QBrush* GetWrapped() const { return q_; };
+  static bool HasInstance(v8::Handle<v8::Value> value);
+  QBrush* GetWrapped() { return &q_; };
 
  private:
   QBrushWrap(const v8::Arguments& args);
   ~QBrushWrap();
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> constructor_template;
   static v8::Handle<v8::Value> New(const v8::Arguments& args);
 
   // Wrapped methods
 
   // Wrapped object
-  QBrush* q_;
+  QBrush q_;
 };
 
 #endif
@@ -35,6 +35,7 @@
 using namespace v8;
 
 Persistent<Function> QColorWrap::constructor;
+Persistent<FunctionTemplate> QColorWrap::constructor_template;
 
 // Supported implementations:
 //   QColor ( int r, int g, int b, int a = 255 )
@@ -43,7 +44,7 @@ Persistent<Function> QColorWrap::constructor;
 QColorWrap::QColorWrap(const Arguments& args) {
   if (args.Length() >= 3) {
     // QColor ( int r, int g, int b, int a = 255 )
-    q_ = new QColor(
+    q_ = QColor(
         args[0]->IntegerValue(), 
         args[1]->IntegerValue(),
         args[2]->IntegerValue(), 
@@ -51,13 +52,10 @@ QColorWrap::QColorWrap(const Arguments& args) {
     );
   } else if (args[0]->IsString()) {
     // QColor ( QString color )
-    q_ = new QColor( qt_v8::ToQString(args[0]->ToString()) );
+    q_ = QColor( qt_v8::ToQString(args[0]->ToString()) );
   } else if (args[0]->IsObject()) {
     // QColor ( QColor color )
-    QString arg0_constructor = 
-        qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
-
-    if (arg0_constructor != "QColor")
+    if (!QColorWrap::HasInstance(args[0]))
       ThrowException(Exception::TypeError(
         String::New("QColor::QColor: bad argument")));
 
@@ -66,17 +64,17 @@ QColorWrap::QColorWrap(const Arguments& args) {
         args[0]->ToObject());
     QColor* q = q_wrap->GetWrapped();
 
-    q_ = new QColor(*q);
+    q_ = QColor(*q);
   }
 }
 
 QColorWrap::~QColorWrap() {
-  delete q_;
 }
 
 void QColorWrap::Initialize(Handle<Object> target) {
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
   tpl->SetClassName(String::NewSymbol("QColor"));
   tpl->InstanceTemplate()->SetInternalFieldCount(1);  
 
@@ -96,6 +94,10 @@ void QColorWrap::Initialize(Handle<Object> target) {
   target->Set(String::NewSymbol("QColor"), constructor);
 }
 
+bool QColorWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
 Handle<Value> QColorWrap::New(const Arguments& args) {
   HandleScope scope;
 
@@ -37,12 +37,14 @@
 class QColorWrap : public node::ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
-  QColor* GetWrapped() const { return q_; };
+  static bool HasInstance(v8::Handle<v8::Value> value);
+  QColor* GetWrapped() { return &q_; };
 
  private:
   QColorWrap(const v8::Arguments& args);
   ~QColorWrap();
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> constructor_template;
   static v8::Handle<v8::Value> New(const v8::Arguments& args);
 
   // Wrapped methods
@@ -53,7 +55,7 @@ class QColorWrap : public node::ObjectWrap {
   static v8::Handle<v8::Value> Name(const v8::Arguments& args);
 
   // Wrapped object
-  QColor* q_;
+  QColor q_;
 };
 
 #endif
@@ -35,6 +35,7 @@
 using namespace v8;
 
 Persistent<Function> QFontWrap::constructor;
+Persistent<FunctionTemplate> QFontWrap::constructor_template;
 
 // Supported implementations:
 //   QFont ( )
@@ -52,10 +53,7 @@ QFontWrap::QFontWrap(const Arguments& args) : q_(NULL) {
   // QFont ( QFont font )
 
   if (args.Length() == 1 && args[0]->IsObject()) {
-    QString arg0_constructor = 
-        qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
-
-    if (arg0_constructor != "QFont")
+    if (!QFontWrap::HasInstance(args[0]))
       ThrowException(Exception::TypeError(
         String::New("QFont::QFont: bad argument")));
 
@@ -102,6 +100,7 @@ QFontWrap::~QFontWrap() {
 void QFontWrap::Initialize(Handle<Object> target) {
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
   tpl->SetClassName(String::NewSymbol("QFont"));
   tpl->InstanceTemplate()->SetInternalFieldCount(1);  
 
@@ -127,6 +126,10 @@ void QFontWrap::Initialize(Handle<Object> target) {
   target->Set(String::NewSymbol("QFont"), constructor);
 }
 
+bool QFontWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
 Handle<Value> QFontWrap::New(const Arguments& args) {
   HandleScope scope;
 
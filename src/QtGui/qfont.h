@@ -37,6 +37,7 @@
 class QFontWrap : public node::ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
+  static bool HasInstance(v8::Handle<v8::Value> value);
   QFont* GetWrapped() const { return q_; };
   void SetWrapped(QFont q) { 
     if (q_) delete q_; 
@@ -48,6 +49,7 @@ class QFontWrap : public node::ObjectWrap {
   QFontWrap(const v8::Arguments& args);
   ~QFontWrap();
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> constructor_template;
   static v8::Handle<v8::Value> New(const v8::Arguments& args);
 
   // Wrapped methods
@@ -29,45 +29,184 @@
 
 #define BUILDING_NODE_EXTENSION
 #include <node.h>
+#include <node_buffer.h>
 #include "qimage.h"
+#include <QBuffer>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QThread>
 #include "../qt_v8.h"
+#include "qcolor.h"
+#include "imageconvert.h"
+#include "imagescale.h"
+#include "surfacepool.h"
 
 using namespace v8;
 
 Persistent<Function> QImageWrap::constructor;
+Persistent<FunctionTemplate> QImageWrap::constructor_template;
 
 // Supported implementations:
 //   QImage ( )
 //   QImage ( QString filename )
-QImageWrap::QImageWrap(const Arguments& args) {
-  if (args[0]->IsString()) {
+//   QImage ( int width, int height, Format format = Format_ARGB32_Premultiplied )
+QImageWrap::QImageWrap(const Arguments& args)
+    : q_(NULL), bits_(NULL), memory_(0), disposed_(false), pooled_(false),
+      busy_(false) {
+  if (args[0]->IsNumber()) {
+    // QImage ( int width, int height, Format format )
+    QImage::Format format = args[2]->IsNumber()
+        ? (QImage::Format)args[2]->IntegerValue()
+        : QImage::Format_ARGB32_Premultiplied;
+    q_ = new QImage(args[0]->IntegerValue(), args[1]->IntegerValue(), format);
+  } else if (args[0]->IsString()) {
     // QImage ( QString filename ) 
     q_ = new QImage(qt_v8::ToQString(args[0]->ToString()));
-    return;
+  } else {
+    // QImage ( )
+    q_ = new QImage();
   }
 
-  // QImage ( )
-  q_ = new QImage(qt_v8::ToQString(args[0]->ToString()));  
+  UpdateMemory();
 }
 
 QImageWrap::~QImageWrap() {
+  ReleaseToPool();
   delete q_;
+  q_ = NULL;
+
+  // Pixels may belong to the buffer, release it after the image
+  if (!buffer_.IsEmpty())
+    buffer_.Dispose();
+
+  // Buffers from bits() keep the wrapper alive, so any left are being
+  // collected along with it
+  if (bits_) {
+    if (bits_->buffers > 0)
+      bits_->orphaned = true;
+    else
+      delete bits_;
+  }
+
+  UpdateMemory();
+}
+
+//
+// UpdateMemory()
+// Tells V8 how many bytes of pixels the wrapper holds, so that large images
+// weigh on garbage collection as much as they do on memory. Called
+// whenever q_ is replaced. Pixels shared between wrappers are counted by
+// each; those of a Node buffer (fromBuffer()) are counted by the buffer
+//
+void QImageWrap::UpdateMemory() {
+  int memory = (q_ && buffer_.IsEmpty()) ? q_->byteCount() : 0;
+  if (memory != memory_)
+    V8::AdjustAmountOfExternalAllocatedMemory(memory - memory_);
+  memory_ = memory;
+}
+
+QImage QImageWrap::PixelOwner() const {
+  if (!storage_.isNull() && storage_.constBits() == q_->constBits())
+    return storage_;
+  return *q_;
+}
+
+// Sharing q_ would make the next paint detach it from buffers from bits()
+QImage QImageWrap::WorkerCopy() const {
+  if (buffer_.IsEmpty() && storage_.isNull() && !HasLiveBits())
+    return *q_;
+  return q_->copy();
+}
+
+// Hands the pixels of a pooled image back to SurfacePool. Not once they
+// are viewed with another format by an in-place Convert(). Returns whether
+// the pool took them
+bool QImageWrap::ReleaseToPool() {
+  if (pooled_ && storage_.isNull() && buffer_.IsEmpty())
+    return SurfacePool::Release(*q_);
+  return false;
+}
+
+// Hands q_'s pixels to live buffers from bits() before q_ drops them
+void QImageWrap::RetainBits() {
+  if (HasLiveBits())
+    bits_->pixels = PixelOwner();
+}
+
+void QImageWrap::OnBitsFreed(char* data, void* hint) {
+  BitsRef* ref = static_cast<BitsRef*>(hint);
+  if (--ref->buffers > 0)
+    return;
+  ref->pixels = QImage();
+  if (ref->orphaned)
+    delete ref;
+}
+
+// Methods called after dispose()
+static Handle<Value> ThrowDisposed() {
+  return ThrowException(Exception::Error(
+      String::New("QImageWrap: image was disposed")));
+}
+
+// Methods using the pixels while SetBusy()
+static Handle<Value> ThrowBusy() {
+  return ThrowException(Exception::Error(
+      String::New("QImageWrap: image is being rendered")));
 }
 
 void QImageWrap::Initialize(Handle<Object> target) {
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
   tpl->SetClassName(String::NewSymbol("QImage"));
   tpl->InstanceTemplate()->SetInternalFieldCount(1);  
 
   // Prototype
   tpl->PrototypeTemplate()->Set(String::NewSymbol("isNull"),
       FunctionTemplate::New(IsNull)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("width"),
+      FunctionTemplate::New(Width)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("height"),
+      FunctionTemplate::New(Height)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("format"),
+      FunctionTemplate::New(Format)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("fill"),
+      FunctionTemplate::New(Fill)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("save"),
+      FunctionTemplate::New(Save)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("bytesPerLine"),
+      FunctionTemplate::New(BytesPerLine)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("byteCount"),
+      FunctionTemplate::New(ByteCount)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("bits"),
+      FunctionTemplate::New(Bits)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("encode"),
+      FunctionTemplate::New(Encode)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("saveAsync"),
+      FunctionTemplate::New(SaveAsync)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("convert"),
+      FunctionTemplate::New(Convert)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("toRgbaBuffer"),
+      FunctionTemplate::New(ToRgbaBuffer)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("scaled"),
+      FunctionTemplate::New(Scaled)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("dispose"),
+      FunctionTemplate::New(Dispose)->GetFunction());
+
+  // Static methods
+  tpl->Set(String::NewSymbol("fromBuffer"),
+      FunctionTemplate::New(FromBuffer)->GetFunction());
+  tpl->Set(String::NewSymbol("load"),
+      FunctionTemplate::New(Load)->GetFunction());
 
   constructor = Persistent<Function>::New(tpl->GetFunction());
   target->Set(String::NewSymbol("QImage"), constructor);
 }
 
+bool QImageWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
 Handle<Value> QImageWrap::New(const Arguments& args) {
   HandleScope scope;
 
@@ -77,11 +216,913 @@ Handle<Value> QImageWrap::New(const Arguments& args) {
   return args.This();
 }
 
+Handle<Value> QImageWrap::NewInstance(QImage q) {
+  HandleScope scope;
+  
+  Local<Object> instance = constructor->NewInstance(0, NULL);
+  QImageWrap* w = node::ObjectWrap::Unwrap<QImageWrap>(instance);
+  w->SetWrapped(q);
+
+  return scope.Close(instance);
+}
+
 Handle<Value> QImageWrap::IsNull(const Arguments& args) {
   HandleScope scope;
 
   QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  if (w->disposed_)
+    return ThrowDisposed();
   QImage* q = w->GetWrapped();
 
   return scope.Close(Boolean::New(q->isNull()));
 }
+
+Handle<Value> QImageWrap::Width(const Arguments& args) {
+  HandleScope scope;
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  if (w->disposed_)
+    return ThrowDisposed();
+  QImage* q = w->GetWrapped();
+
+  return scope.Close(Integer::New(q->width()));
+}
+
+Handle<Value> QImageWrap::Height(const Arguments& args) {
+  HandleScope scope;
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  if (w->disposed_)
+    return ThrowDisposed();
+  QImage* q = w->GetWrapped();
+
+  return scope.Close(Integer::New(q->height()));
+}
+
+Handle<Value> QImageWrap::Format(const Arguments& args) {
+  HandleScope scope;
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  if (w->disposed_)
+    return ThrowDisposed();
+  QImage* q = w->GetWrapped();
+
+  return scope.Close(Integer::New(q->format()));
+}
+
+// Supports:
+//    fill()
+//    fill(QColor color)
+//    fill(Qt::GlobalColor color)
+//
+// QUIRK:
+// Here: fill() fills with white, like QPixmap::fill()
+// Qt: fill(uint pixel) is not exposed; a number is a Qt::GlobalColor
+Handle<Value> QImageWrap::Fill(const Arguments& args) {
+  HandleScope scope;
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  if (w->disposed_)
+    return ThrowDisposed();
+  if (w->busy_)
+    return ThrowBusy();
+  QImage* q = w->GetWrapped();
+
+  if (QColorWrap::HasInstance(args[0])) {
+    QColorWrap* color_wrap = ObjectWrap::Unwrap<QColorWrap>(
+        args[0]->ToObject());
+    q->fill(*color_wrap->GetWrapped());
+  } else if (args[0]->IsNumber()) {
+    q->fill((Qt::GlobalColor)args[0]->IntegerValue());
+  } else {
+    q->fill(Qt::white);
+  }
+
+  return scope.Close(Undefined());
+}
+
+// Supported versions:
+//   save(QString fileName, QString format = null, int quality = -1)
+Handle<Value> QImageWrap::Save(const Arguments& args) {
+  HandleScope scope;
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  if (w->disposed_)
+    return ThrowDisposed();
+  if (w->busy_)
+    return ThrowBusy();
+  QImage* q = w->GetWrapped();
+
+  QString file(qt_v8::ToQString(args[0]->ToString()));
+  QByteArray format;
+  if (args[1]->IsString())
+    format = qt_v8::ToQString(args[1]->ToString()).toLatin1();
+  int quality = args[2]->IsNumber() ? args[2]->IntegerValue() : -1;
+
+  return scope.Close(Boolean::New( 
+      q->save(file, format.isEmpty() ? 0 : format.constData(), quality) ));
+}
+
+Handle<Value> QImageWrap::BytesPerLine(const Arguments& args) {
+  HandleScope scope;
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  if (w->disposed_)
+    return ThrowDisposed();
+  QImage* q = w->GetWrapped();
+
+  return scope.Close(Integer::New(q->bytesPerLine()));
+}
+
+Handle<Value> QImageWrap::ByteCount(const Arguments& args) {
+  HandleScope scope;
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  if (w->disposed_)
+    return ThrowDisposed();
+  QImage* q = w->GetWrapped();
+
+  return scope.Close(Integer::New(q->byteCount()));
+}
+
+//
+// QUIRK:
+// Dispose()
+// Not in Qt. Frees the pixels now instead of at garbage collection, or
+// returns them to the pool for images from qt.SurfacePool. Any
+// later call on the image throws; passed to other methods it acts as a
+// null image. Buffers from bits() stay valid: they keep the pixels alive
+// until they are collected. Except for pixels taken back by the pool,
+// which may be handed out again: Buffers from bits() of pooled images
+// must not be used after dispose(). Pending encode(), saveAsync() and
+// scaled() work on a copy of the pixels, so they are not affected. Throws
+// while renderTiled() is rendering into the image. Calling dispose()
+// again does nothing
+//
+Handle<Value> QImageWrap::Dispose(const Arguments& args) {
+  HandleScope scope;
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  if (w->disposed_)
+    return scope.Close(Undefined());
+  if (w->busy_)
+    return ThrowBusy();
+
+  // The paint engine of an active painter refers to the pixels
+  if (w->q_->paintingActive())
+    return ThrowException(Exception::Error(
+        String::New("QImageWrap::Dispose: image is being painted on")));
+
+  if (!w->ReleaseToPool())
+    w->RetainBits();
+  *w->q_ = QImage();
+  w->storage_ = QImage();
+  if (!w->buffer_.IsEmpty()) {
+    w->buffer_.Dispose();
+    w->buffer_.Clear();
+  }
+  w->disposed_ = true;
+  w->UpdateMemory();
+
+  return scope.Close(Undefined());
+}
+
+// The pixels of fromBuffer() images belong to that buffer
+static void NoFree(char* data, void* hint) {
+}
+
+//
+// QUIRK:
+// Bits()
+// Returns a Buffer over the image's pixels, without copying. Writes go
+// straight to the image, and the Buffer sees later fills, paints and
+// in-place conversions. The Buffer keeps the image alive; after dispose(),
+// the pixels (see Dispose()). For fromBuffer() images it keeps the
+// original buffer alive too
+//
+Handle<Value> QImageWrap::Bits(const Arguments& args) {
+  HandleScope scope;
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  if (w->disposed_)
+    return ThrowDisposed();
+  if (w->busy_)
+    return ThrowBusy();
+  QImage* q = w->GetWrapped();
+
+  if (q->isNull())
+    return ThrowException(Exception::Error(
+        String::New("QImageWrap::Bits: image is null")));
+
+  // Detaches from shared copies, e.g. one being encoded. Holds no
+  // reference itself: q_ stays unshared, so painting doesn't detach it
+  char* bits = reinterpret_cast<char*>(q->bits());
+  node::Buffer* buffer;
+
+  if (!w->buffer_.IsEmpty() && bits == node::Buffer::Data(w->buffer_)) {
+    buffer = node::Buffer::New(bits, q->byteCount(), NoFree, NULL);
+    buffer->handle_->SetHiddenValue(String::NewSymbol("buffer"), w->buffer_);
+  } else {
+    if (!w->bits_) {
+      w->bits_ = new BitsRef;
+      w->bits_->buffers = 0;
+      w->bits_->orphaned = false;
+    }
+    w->bits_->buffers++;
+    buffer = node::Buffer::New(bits, q->byteCount(), OnBitsFreed, w->bits_);
+  }
+  buffer->handle_->SetHiddenValue(String::NewSymbol("image"), args.This());
+
+  return scope.Close(buffer->handle_);
+}
+
+//
+// QUIRK:
+// FromBuffer()
+// Static. fromBuffer(Buffer buffer, int width, int height, int bytesPerLine,
+//   Format format)
+// Creates an image using the buffer's memory as pixels, without copying.
+// The image keeps the buffer alive
+//
+Handle<Value> QImageWrap::FromBuffer(const Arguments& args) {
+  HandleScope scope;
+
+  if (!node::Buffer::HasInstance(args[0]) || !args[1]->IsNumber() ||
+      !args[2]->IsNumber() || !args[3]->IsNumber() || !args[4]->IsNumber())
+    return ThrowException(Exception::TypeError(
+        String::New("QImageWrap::FromBuffer: bad arguments")));
+
+  Local<Object> buffer = args[0]->ToObject();
+  int width = args[1]->IntegerValue();
+  int height = args[2]->IntegerValue();
+  int stride = args[3]->IntegerValue();
+  QImage::Format format = (QImage::Format)args[4]->IntegerValue();
+
+  if (format <= QImage::Format_Invalid || format >= QImage::NImageFormats ||
+      format == QImage::Format_Indexed8 || format == QImage::Format_Mono ||
+      format == QImage::Format_MonoLSB)
+    return ThrowException(Exception::RangeError(
+        String::New("QImageWrap::FromBuffer: unsupported format")));
+
+  // Bits per pixel of the format, rounded up to whole bytes per line
+  int depth = QImage(1, 1, format).depth();
+
+  if (width <= 0 || height <= 0 || stride < (width * depth + 7) / 8 ||
+      (size_t) stride * height > node::Buffer::Length(buffer))
+    return ThrowException(Exception::RangeError(
+        String::New("QImageWrap::FromBuffer: buffer too small for image")));
+
+  QImage image(reinterpret_cast<uchar*>(node::Buffer::Data(buffer)),
+               width, height, stride, format);
+
+  Local<Object> instance = NewInstance(image)->ToObject();
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(instance);
+  w->buffer_ = Persistent<Object>::New(buffer);
+  w->UpdateMemory();
+
+  return scope.Close(instance);
+}
+
+//
+// LoadRequest
+// State of an asynchronous load, shared between the main thread and a
+// threadpool worker. The worker only touches the Qt members
+//
+struct LoadRequest {
+  uv_work_t req;
+
+  // Input: either a file path or encoded bytes
+  QString path;
+  QByteArray data;
+  QSize scaledSize;
+  QRect clipRect;
+
+  // Output
+  QImage image;
+  QString error;
+
+  v8::Persistent<v8::Object> buffer;
+  v8::Persistent<v8::Function> callback;
+};
+
+//
+// QUIRK:
+// Load()
+// Static. load(String path | Buffer data, [Object options], Function cb)
+// Decodes an image with QImageReader on the libuv threadpool and calls
+// cb(err, image). Options:
+//   scaledSize: { width, height } - decode at this size. Readers that
+//     support it (e.g. JPEG) downscale while decoding
+//   clipRect: { x, y, width, height } - only decode this region of the
+//     original image
+// Buffers must not be modified until cb is called
+//
+Handle<Value> QImageWrap::Load(const Arguments& args) {
+  HandleScope scope;
+
+  bool isBuffer = node::Buffer::HasInstance(args[0]);
+  Local<Value> options = args[2]->IsFunction() ? args[1] : Local<Value>();
+  Local<Value> callback = args[2]->IsFunction() ? args[2] : args[1];
+
+  if ((!args[0]->IsString() && !isBuffer) || !callback->IsFunction())
+    return ThrowException(Exception::TypeError(
+        String::New("QImageWrap::Load: bad arguments")));
+
+  LoadRequest* request = new LoadRequest;
+  request->req.data = request;
+  request->callback = Persistent<Function>::New(
+      Local<Function>::Cast(callback));
+
+  if (isBuffer) {
+    // Read in place; the buffer is kept alive until done
+    Local<Object> buffer = args[0]->ToObject();
+    request->buffer = Persistent<Object>::New(buffer);
+    request->data = QByteArray::fromRawData(node::Buffer::Data(buffer),
+                                            node::Buffer::Length(buffer));
+  } else {
+    request->path = qt_v8::ToQString(args[0]->ToString());
+  }
+
+  if (!options.IsEmpty() && options->IsObject()) {
+    Local<Object> o = options->ToObject();
+
+    Local<Value> size = o->Get(String::NewSymbol("scaledSize"));
+    if (size->IsObject()) {
+      Local<Object> s = size->ToObject();
+      request->scaledSize = QSize(
+          s->Get(String::NewSymbol("width"))->IntegerValue(),
+          s->Get(String::NewSymbol("height"))->IntegerValue());
+    }
+
+    Local<Value> clip = o->Get(String::NewSymbol("clipRect"));
+    if (clip->IsObject()) {
+      Local<Object> c = clip->ToObject();
+      request->clipRect = QRect(
+          c->Get(String::NewSymbol("x"))->IntegerValue(),
+          c->Get(String::NewSymbol("y"))->IntegerValue(),
+          c->Get(String::NewSymbol("width"))->IntegerValue(),
+          c->Get(String::NewSymbol("height"))->IntegerValue());
+    }
+  }
+
+  uv_queue_work(uv_default_loop(), &request->req, OnLoadWork, OnLoadDone);
+
+  return scope.Close(Undefined());
+}
+
+// Runs on a threadpool thread: no V8 here
+void QImageWrap::OnLoadWork(uv_work_t* req) {
+  LoadRequest* request = static_cast<LoadRequest*>(req->data);
+
+  QBuffer device(&request->data);
+  QImageReader reader;
+  if (request->path.isEmpty())
+    reader.setDevice(&device);
+  else
+    reader.setFileName(request->path);
+
+  if (request->clipRect.isValid())
+    reader.setClipRect(request->clipRect);
+  if (request->scaledSize.isValid())
+    reader.setScaledSize(request->scaledSize);
+
+  if (!reader.read(&request->image))
+    request->error = reader.errorString();
+}
+
+void QImageWrap::OnLoadDone(uv_work_t* req) {
+  HandleScope scope;
+  TryCatch try_catch;
+
+  LoadRequest* request = static_cast<LoadRequest*>(req->data);
+
+  Handle<Value> argv[2];
+  if (request->image.isNull()) {
+    argv[0] = Exception::Error(qt_v8::FromQString(
+        "QImage.load: " + request->error));
+    argv[1] = Undefined();
+  } else {
+    argv[0] = Null();
+    argv[1] = NewInstance(request->image);
+  }
+
+  request->callback->Call(Context::GetCurrent()->Global(), 2, argv);
+
+  request->callback.Dispose();
+  if (!request->buffer.IsEmpty())
+    request->buffer.Dispose();
+  delete request;
+
+  if (try_catch.HasCaught())
+    node::FatalException(try_catch);
+}
+
+//
+// EncodeRequest
+// State of an asynchronous encode. The image is an implicitly shared copy,
+// so JS may keep painting on the original meanwhile. Images that don't own
+// their pixels are copied instead (see WorkerCopy())
+//
+struct EncodeRequest {
+  uv_work_t req;
+
+  // Input
+  QImage image;
+  QString path; // empty: encode to memory
+  QByteArray format;
+  int quality;
+  int compression;
+
+  // Output
+  QByteArray data;
+  QString error;
+
+  v8::Persistent<v8::Function> callback;
+};
+
+// Parses ([options], cb) starting at args[first] and queues the request.
+// Returns an exception on bad arguments
+static Handle<Value> QueueEncode(const Arguments& args, int first,
+                                 EncodeRequest* request,
+                                 uv_work_cb work, uv_after_work_cb done) {
+  Local<Value> options = args[first + 1]->IsFunction() 
+      ? args[first] : Local<Value>();
+  Local<Value> callback = args[first + 1]->IsFunction() 
+      ? args[first + 1] : args[first];
+
+  if (!callback->IsFunction()) {
+    delete request;
+    return ThrowException(Exception::TypeError(
+        String::New("QImageWrap::Encode: callback not a function")));
+  }
+
+  request->req.data = request;
+  request->quality = -1;
+  request->compression = -1;
+
+  if (!options.IsEmpty() && options->IsObject()) {
+    Local<Object> o = options->ToObject();
+    Local<Value> quality = o->Get(String::NewSymbol("quality"));
+    Local<Value> compression = o->Get(String::NewSymbol("compression"));
+    if (quality->IsNumber())
+      request->quality = quality->IntegerValue();
+    if (compression->IsNumber())
+      request->compression = compression->IntegerValue();
+  }
+
+  request->callback = Persistent<Function>::New(
+      Local<Function>::Cast(callback));
+
+  uv_queue_work(uv_default_loop(), &request->req, work, done);
+
+  return Undefined();
+}
+
+//
+// QUIRK:
+// Encode()
+// encode(String format, [Object options], Function cb)
+// Encodes the image (e.g. 'PNG', 'JPG') into a Buffer with QImageWriter on
+// the libuv threadpool and calls cb(err, buffer). Options:
+//   quality: 0-100, format specific (JPEG quality, PNG effort)
+//   compression: format specific (e.g. TIFF)
+//
+Handle<Value> QImageWrap::Encode(const Arguments& args) {
+  HandleScope scope;
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  if (w->disposed_)
+    return ThrowDisposed();
+  if (w->busy_)
+    return ThrowBusy();
+  QImage* q = w->GetWrapped();
+
+  if (!args[0]->IsString())
+    return ThrowException(Exception::TypeError(
+        String::New("QImageWrap::Encode: format not a string")));
+
+  EncodeRequest* request = new EncodeRequest;
+  request->image = w->WorkerCopy();
+  request->format = qt_v8::ToQString(args[0]->ToString()).toLatin1();
+
+  return scope.Close(
+      QueueEncode(args, 1, request, OnEncodeWork, OnEncodeDone));
+}
+
+//
+// QUIRK:
+// SaveAsync()
+// saveAsync(String fileName, [String format], [Object options], Function cb)
+// Like save(), on the libuv threadpool. Calls cb(err). The format is
+// guessed from the file name if not given; options are as for encode()
+//
+Handle<Value> QImageWrap::SaveAsync(const Arguments& args) {
+  HandleScope scope;
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  if (w->disposed_)
+    return ThrowDisposed();
+  if (w->busy_)
+    return ThrowBusy();
+  QImage* q = w->GetWrapped();
+
+  if (!args[0]->IsString())
+    return ThrowException(Exception::TypeError(
+        String::New("QImageWrap::SaveAsync: file name not a string")));
+
+  EncodeRequest* request = new EncodeRequest;
+  request->image = w->WorkerCopy();
+  request->path = qt_v8::ToQString(args[0]->ToString());
+
+  // Format is optional
+  int first = 1;
+  if (args[1]->IsString()) {
+    request->format = qt_v8::ToQString(args[1]->ToString()).toLatin1();
+    first = 2;
+  }
+
+  return scope.Close(
+      QueueEncode(args, first, request, OnEncodeWork, OnEncodeDone));
+}
+
+// Runs on a threadpool thread: no V8 here
+void QImageWrap::OnEncodeWork(uv_work_t* req) {
+  EncodeRequest* request = static_cast<EncodeRequest*>(req->data);
+
+  QBuffer device(&request->data);
+  QImageWriter writer;
+  if (request->path.isEmpty()) {
+    device.open(QIODevice::WriteOnly);
+    writer.setDevice(&device);
+  } else {
+    writer.setFileName(request->path);
+  }
+
+  if (!request->format.isEmpty())
+    writer.setFormat(request->format);
+  if (request->quality >= 0)
+    writer.setQuality(request->quality);
+  if (request->compression >= 0)
+    writer.setCompression(request->compression);
+
+  if (!writer.write(request->image))
+    request->error = writer.errorString();
+}
+
+void QImageWrap::OnEncodeDone(uv_work_t* req) {
+  HandleScope scope;
+  TryCatch try_catch;
+
+  EncodeRequest* request = static_cast<EncodeRequest*>(req->data);
+
+  Handle<Value> argv[2];
+  argv[0] = Null();
+  argv[1] = Undefined();
+  if (!request->error.isEmpty()) {
+    argv[0] = Exception::Error(qt_v8::FromQString(
+        "QImage.encode: " + request->error));
+  } else if (request->path.isEmpty()) {
+    argv[1] = qt_v8::FromQByteArray(request->data);
+  }
+
+  request->callback->Call(Context::GetCurrent()->Global(), 
+      request->path.isEmpty() ? 2 : 1, argv);
+
+  request->callback.Dispose();
+  delete request;
+
+  if (try_catch.HasCaught())
+    node::FatalException(try_catch);
+}
+
+// Format handled by Convert() that QImage::Format lacks, numbered as in
+// Qt 5 and exported as qt.ImageFormat.Format_Grayscale8
+static const int Format_Grayscale8 = 24;
+
+static bool Is32Bit(QImage::Format format) {
+  return format == QImage::Format_RGB32 || format == QImage::Format_ARGB32 ||
+         format == QImage::Format_ARGB32_Premultiplied;
+}
+
+static const quint32* ConstRow(const QImage& image, int y) {
+  return reinterpret_cast<const quint32*>(image.constScanLine(y));
+}
+
+//
+// QUIRK:
+// Convert()
+// convert(Format format, [Object options])
+// Like convertToFormat(), with vectorized paths from 32-bit images to
+// ARGB32, ARGB32_Premultiplied, RGB16 and Format_Grayscale8. Other
+// conversions go through Qt. Always returns a QImage. Options:
+//   inPlace: convert this image's pixels and return it, instead of a new
+//     image. Only between ARGB32 and ARGB32_Premultiplied, and not while a
+//     painter is active on the image
+// Not in Qt 4.8:
+//   Format_Grayscale8 returns an Indexed8 image with a gray color table.
+//     Alpha is ignored
+// See toRgbaBuffer() for RGBA bytes
+//
+Handle<Value> QImageWrap::Convert(const Arguments& args) {
+  HandleScope scope;
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  if (w->disposed_)
+    return ThrowDisposed();
+  if (w->busy_)
+    return ThrowBusy();
+  QImage* q = w->GetWrapped();
+
+  if (!args[0]->IsNumber())
+    return ThrowException(Exception::TypeError(
+        String::New("QImageWrap::Convert: format not a number")));
+
+  int format = args[0]->IntegerValue();
+  bool inPlace = args[1]->IsObject() &&
+      args[1]->ToObject()->Get(String::NewSymbol("inPlace"))->BooleanValue();
+
+  if (format != Format_Grayscale8 &&
+      (format <= QImage::Format_Invalid || format >= QImage::NImageFormats))
+    return ThrowException(Exception::RangeError(
+        String::New("QImageWrap::Convert: unknown format")));
+
+  if (q->isNull())
+    return ThrowException(Exception::Error(
+        String::New("QImageWrap::Convert: image is null")));
+
+  QImage::Format source = q->format();
+  int width = q->width();
+  int height = q->height();
+
+  if (inPlace) {
+    if ((source != QImage::Format_ARGB32 &&
+         source != QImage::Format_ARGB32_Premultiplied) ||
+        (format != QImage::Format_ARGB32 &&
+         format != QImage::Format_ARGB32_Premultiplied))
+      return ThrowException(Exception::RangeError(String::New(
+          "QImageWrap::Convert: conversion not possible in place")));
+
+    if (format == source)
+      return scope.Close(args.This());
+
+    // The paint engine of an active painter refers to the image
+    if (q->paintingActive())
+      return ThrowException(Exception::Error(
+          String::New("QImageWrap::Convert: image is being painted on")));
+
+    // Detaches from shared copies, e.g. one being encoded
+    uchar* bits = q->bits();
+    int stride = q->bytesPerLine();
+    for (int y = 0; y < height; y++) {
+      quint32* row = reinterpret_cast<quint32*>(bits + y * stride);
+      if (format == QImage::Format_ARGB32_Premultiplied)
+        ImageConvert::Premultiply(row, row, width);
+      else
+        ImageConvert::Unpremultiply(row, row, width);
+    }
+
+    // QImage can't change format in place; view the same pixels with the
+    // new format, keeping their owner around
+    if (w->storage_.isNull() || w->storage_.constBits() != bits)
+      w->storage_ = *q;
+    *q = QImage(bits, width, height, stride, (QImage::Format)format);
+
+    return scope.Close(args.This());
+  }
+
+  // Qt would share the pixels, which the next paint would detach from
+  // buffers from bits()
+  if (format == source && w->HasLiveBits())
+    return scope.Close(NewInstance(q->copy()));
+
+  // Non-32-bit sources, and conversions without a fast path, go through Qt
+  QImage image = *q;
+  if (!Is32Bit(source)) {
+    if (format != Format_Grayscale8)
+      return scope.Close(NewInstance(
+          q->convertToFormat((QImage::Format)format)));
+    image = q->convertToFormat(QImage::Format_ARGB32);
+    source = QImage::Format_ARGB32;
+  }
+
+  if (format == Format_Grayscale8) {
+    QImage result(width, height, QImage::Format_Indexed8);
+    QVector<QRgb> grays(256);
+    for (int i = 0; i < 256; i++)
+      grays[i] = qRgb(i, i, i);
+    result.setColorTable(grays);
+    for (int y = 0; y < height; y++)
+      ImageConvert::ToGray8(ConstRow(image, y), result.scanLine(y), width);
+    return scope.Close(NewInstance(result));
+  }
+
+  if (format == QImage::Format_RGB16) {
+    // ARGB32 is premultiplied first, i.e. composited on black
+    QImage result(width, height, QImage::Format_RGB16);
+    QVector<quint32> temp(source == QImage::Format_ARGB32 ? width : 0);
+    for (int y = 0; y < height; y++) {
+      const quint32* row = ConstRow(image, y);
+      if (source == QImage::Format_ARGB32) {
+        ImageConvert::Premultiply(row, temp.data(), width);
+        row = temp.constData();
+      }
+      ImageConvert::ToRgb565(row,
+          reinterpret_cast<quint16*>(result.scanLine(y)), width);
+    }
+    return scope.Close(NewInstance(result));
+  }
+
+  if ((source == QImage::Format_ARGB32 &&
+       format == QImage::Format_ARGB32_Premultiplied) ||
+      (source == QImage::Format_ARGB32_Premultiplied &&
+       format == QImage::Format_ARGB32)) {
+    QImage result(width, height, (QImage::Format)format);
+    for (int y = 0; y < height; y++) {
+      quint32* out = reinterpret_cast<quint32*>(result.scanLine(y));
+      if (format == QImage::Format_ARGB32_Premultiplied)
+        ImageConvert::Premultiply(ConstRow(image, y), out, width);
+      else
+        ImageConvert::Unpremultiply(ConstRow(image, y), out, width);
+    }
+    return scope.Close(NewInstance(result));
+  }
+
+  return scope.Close(NewInstance(image.convertToFormat(
+      (QImage::Format)format)));
+}
+
+//
+// QUIRK:
+// ToRgbaBuffer()
+// Not in Qt. Returns a Buffer of tightly packed, non-premultiplied R, G,
+// B, A bytes, e.g. for WebGL or canvas ImageData. Vectorized from 32-bit
+// images; other formats go through ARGB32 first
+//
+Handle<Value> QImageWrap::ToRgbaBuffer(const Arguments& args) {
+  HandleScope scope;
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  if (w->disposed_)
+    return ThrowDisposed();
+  if (w->busy_)
+    return ThrowBusy();
+  QImage* q = w->GetWrapped();
+
+  if (q->isNull())
+    return ThrowException(Exception::Error(
+        String::New("QImageWrap::ToRgbaBuffer: image is null")));
+
+  QImage image = *q;
+  QImage::Format source = q->format();
+  int width = q->width();
+  int height = q->height();
+  if (!Is32Bit(source)) {
+    image = q->convertToFormat(QImage::Format_ARGB32);
+    source = QImage::Format_ARGB32;
+  }
+
+  node::Buffer* buffer = node::Buffer::New((size_t) width * height * 4);
+  uchar* out = reinterpret_cast<uchar*>(node::Buffer::Data(buffer));
+  QVector<quint32> temp(source == QImage::Format_ARGB32_Premultiplied
+                        ? width : 0);
+  for (int y = 0; y < height; y++) {
+    const quint32* row = ConstRow(image, y);
+    if (source == QImage::Format_ARGB32_Premultiplied) {
+      ImageConvert::Unpremultiply(row, temp.data(), width);
+      row = temp.constData();
+    }
+    ImageConvert::SwizzleToRgba(row, out + y * width * 4, width);
+  }
+
+  return scope.Close(buffer->handle_);
+}
+
+//
+// ScaleRequest
+// State of an asynchronous scale. The image is an implicitly shared copy,
+// or a deep one as for EncodeRequest
+//
+struct ScaleRequest {
+  uv_work_t req;
+
+  // Input
+  QImage image;
+  int width;
+  int height;
+  ImageScale::Filter filter;
+  int threads;
+
+  // Output
+  QImage result;
+
+  v8::Persistent<v8::Function> callback;
+};
+
+//
+// QUIRK:
+// Scaled()
+// scaled(int width, int height, [Object options], [Function cb])
+// Resamples the image with a separable filter, splitting the output rows
+// into bands that run in parallel. Options:
+//   filter: qt.ScaleFilter.Box (area average), Bilinear (default) or
+//     Lanczos3
+//   threads: bands run in parallel, QThread::idealThreadCount() by default
+// Without cb, returns the new image. With cb, runs on the libuv threadpool
+// and calls cb(err, image)
+// Qt: scaled(int, int, Qt::AspectRatioMode, Qt::TransformationMode); the
+// size is taken as is here
+//
+Handle<Value> QImageWrap::Scaled(const Arguments& args) {
+  HandleScope scope;
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  if (w->disposed_)
+    return ThrowDisposed();
+  if (w->busy_)
+    return ThrowBusy();
+  QImage* q = w->GetWrapped();
+
+  if (!args[0]->IsNumber() || !args[1]->IsNumber())
+    return ThrowException(Exception::TypeError(
+        String::New("QImageWrap::Scaled: bad arguments")));
+
+  int width = args[0]->IntegerValue();
+  int height = args[1]->IntegerValue();
+  int filter = ImageScale::Bilinear;
+  int threads = QThread::idealThreadCount();
+
+  Local<Value> callback = args[2]->IsFunction() ? args[2] : args[3];
+  if (args[2]->IsObject() && !args[2]->IsFunction()) {
+    Local<Object> o = args[2]->ToObject();
+    Local<Value> f = o->Get(String::NewSymbol("filter"));
+    Local<Value> t = o->Get(String::NewSymbol("threads"));
+    if (f->IsNumber())
+      filter = f->IntegerValue();
+    if (t->IsNumber())
+      threads = t->IntegerValue();
+  }
+
+  if (width <= 0 || height <= 0)
+    return ThrowException(Exception::RangeError(
+        String::New("QImageWrap::Scaled: size must be positive")));
+
+  if (filter < ImageScale::Box || filter > ImageScale::Lanczos3)
+    return ThrowException(Exception::RangeError(
+        String::New("QImageWrap::Scaled: unknown filter")));
+
+  if (q->isNull())
+    return ThrowException(Exception::Error(
+        String::New("QImageWrap::Scaled: image is null")));
+
+  if (!callback->IsFunction())
+    return scope.Close(NewInstance(ImageScale::Scale(
+        *q, width, height, (ImageScale::Filter)filter, threads)));
+
+  ScaleRequest* request = new ScaleRequest;
+  request->req.data = request;
+  request->image = w->WorkerCopy();
+  request->width = width;
+  request->height = height;
+  request->filter = (ImageScale::Filter)filter;
+  request->threads = threads;
+  request->callback = Persistent<Function>::New(
+      Local<Function>::Cast(callback));
+
+  uv_queue_work(uv_default_loop(), &request->req, OnScaleWork, OnScaleDone);
+
+  return scope.Close(Undefined());
+}
+
+// Runs on a threadpool thread: no V8 here. Bands fan out further onto
+// QThreadPool
+void QImageWrap::OnScaleWork(uv_work_t* req) {
+  ScaleRequest* request = static_cast<ScaleRequest*>(req->data);
+
+  request->result = ImageScale::Scale(request->image, request->width,
+      request->height, request->filter, request->threads);
+}
+
+void QImageWrap::OnScaleDone(uv_work_t* req) {
+  HandleScope scope;
+  TryCatch try_catch;
+
+  ScaleRequest* request = static_cast<ScaleRequest*>(req->data);
+
+  Handle<Value> argv[2];
+  if (request->result.isNull()) {
+    argv[0] = Exception::Error(
+        String::New("QImage.scaled: out of memory"));
+    argv[1] = Undefined();
+  } else {
+    argv[0] = Null();
+    argv[1] = NewInstance(request->result);
+  }
+
+  request->callback->Call(Context::GetCurrent()->Global(), 2, argv);
+
+  request->callback.Dispose();
+  delete request;
+
+  if (try_catch.HasCaught())
+    node::FatalException(try_catch);
+}
@@ -32,24 +32,121 @@
 
 #define BUILDING_NODE_EXTENSION
 #include <node.h>
+#include <uv.h>
 #include <QImage>
 
 class QImageWrap : public node::ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
+  static bool HasInstance(v8::Handle<v8::Value> value);
+  static v8::Handle<v8::Value> NewInstance(QImage q);
   QImage* GetWrapped() const { return q_; };
+  void SetWrapped(QImage q) { 
+    if (q_) delete q_; 
+    q_ = new QImage(q); 
+    UpdateMemory();
+  };
+
+  // Pooled wrappers return their pixels to SurfacePool when freed
+  void SetPooled(bool pooled) { pooled_ = pooled; };
+
+  // Set while worker threads paint into the pixels (see
+  // QPainter.renderTiled()). Methods using them throw meanwhile
+  void SetBusy(bool busy) { busy_ = busy; };
+  bool IsBusy() const { return busy_; };
+
+  // An image sharing q_'s pixels that keeps them allocated: storage_ after
+  // an in-place Convert(), else q_. fromBuffer() pixels belong to buffer_
+  QImage PixelOwner() const;
 
  private:
   QImageWrap(const v8::Arguments& args);
   ~QImageWrap();
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> constructor_template;
   static v8::Handle<v8::Value> New(const v8::Arguments& args);
 
+  // Reports the size of q_'s pixels to V8
+  void UpdateMemory();
+
+  // q_ for threadpool workers: a deep copy if its pixels belong to
+  // buffer_ or storage_, which JS may release meanwhile, or if buffers
+  // from bits() write to them
+  QImage WorkerCopy() const;
+  bool ReleaseToPool();
+
+  // Buffers from bits() alive, and the pixels they keep once the image
+  // has let go of them (see Dispose()). Outlives the wrapper if the
+  // buffers are collected after it
+  struct BitsRef {
+    int buffers;
+    bool orphaned;
+    QImage pixels;
+  };
+  bool HasLiveBits() const { return bits_ && bits_->buffers > 0; };
+  void RetainBits();
+  static void OnBitsFreed(char* data, void* hint);
+
   // Wrapped methods
   static v8::Handle<v8::Value> IsNull(const v8::Arguments& args);
+  static v8::Handle<v8::Value> Width(const v8::Arguments& args);
+  static v8::Handle<v8::Value> Height(const v8::Arguments& args);
+  static v8::Handle<v8::Value> Format(const v8::Arguments& args);
+  static v8::Handle<v8::Value> Fill(const v8::Arguments& args);
+  static v8::Handle<v8::Value> Save(const v8::Arguments& args);
+  static v8::Handle<v8::Value> BytesPerLine(const v8::Arguments& args);
+  static v8::Handle<v8::Value> ByteCount(const v8::Arguments& args);
+
+  // QUIRK
+  // Frees the pixels before garbage collection
+  static v8::Handle<v8::Value> Dispose(const v8::Arguments& args);
+
+  // QUIRK
+  // Zero-copy pixel access through Node buffers
+  static v8::Handle<v8::Value> Bits(const v8::Arguments& args);
+  static v8::Handle<v8::Value> FromBuffer(const v8::Arguments& args);
+
+  // QUIRK
+  // Asynchronous decoding on the libuv threadpool
+  static v8::Handle<v8::Value> Load(const v8::Arguments& args);
+  static void OnLoadWork(uv_work_t* req);
+  static void OnLoadDone(uv_work_t* req);
+
+  // QUIRK
+  // Asynchronous encoding on the libuv threadpool
+  static v8::Handle<v8::Value> Encode(const v8::Arguments& args);
+  static v8::Handle<v8::Value> SaveAsync(const v8::Arguments& args);
+  static void OnEncodeWork(uv_work_t* req);
+  static void OnEncodeDone(uv_work_t* req);
+
+  // QUIRK
+  // Vectorized pixel format conversions
+  static v8::Handle<v8::Value> Convert(const v8::Arguments& args);
+  static v8::Handle<v8::Value> ToRgbaBuffer(const v8::Arguments& args);
+
+  // QUIRK
+  // Multi-threaded resampling, synchronous or on the libuv threadpool
+  static v8::Handle<v8::Value> Scaled(const v8::Arguments& args);
+  static void OnScaleWork(uv_work_t* req);
+  static void OnScaleDone(uv_work_t* req);
 
   // Wrapped object
   QImage* q_;
+
+  // Buffer owning the pixels of q_, if created with FromBuffer()
+  v8::Persistent<v8::Object> buffer_;
+
+  // Owner of the pixels of q_ after an in-place Convert()
+  QImage storage_;
+
+  // Created by the first Bits() over pixels not in buffer_
+  BitsRef* bits_;
+
+  // Bytes reported to V8 as external memory
+  int memory_;
+  bool disposed_;
+  bool pooled_;
+  bool busy_;
 };
 
 #endif
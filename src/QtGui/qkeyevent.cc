@@ -35,8 +35,9 @@
 using namespace v8;
 
 Persistent<Function> QKeyEventWrap::constructor;
+Persistent<FunctionTemplate> QKeyEventWrap::constructor_template;
 
-QKeyEventWrap::QKeyEventWrap() : q_(NULL) {
+QKeyEventWrap::QKeyEventWrap() : q_(NULL), valid_(true) {
   // Standalone constructor not implemented
   // Use SetWrapped()
 }
@@ -48,6 +49,7 @@ QKeyEventWrap::~QKeyEventWrap() {
 void QKeyEventWrap::Initialize(Handle<Object> target) {
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
   tpl->SetClassName(String::NewSymbol("QKeyEvent"));
   tpl->InstanceTemplate()->SetInternalFieldCount(1);  
 
@@ -60,6 +62,10 @@ void QKeyEventWrap::Initialize(Handle<Object> target) {
   target->Set(String::NewSymbol("QKeyEvent"), constructor);
 }
 
+bool QKeyEventWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
 Handle<Value> QKeyEventWrap::New(const Arguments& args) {
   HandleScope scope;
 
@@ -85,6 +91,10 @@ Handle<Value> QKeyEventWrap::Key(const Arguments& args) {
   QKeyEventWrap* w = node::ObjectWrap::Unwrap<QKeyEventWrap>(args.This());
   QKeyEvent* q = w->GetWrapped();
 
+  if (!w->valid_)
+    return ThrowException(Exception::Error(
+        String::New("QKeyEvent: event object used outside its callback")));
+
   return scope.Close(Number::New(q->key()));
 }
 
@@ -94,5 +104,9 @@ Handle<Value> QKeyEventWrap::Text(const Arguments& args) {
   QKeyEventWrap* w = node::ObjectWrap::Unwrap<QKeyEventWrap>(args.This());
   QKeyEvent* q = w->GetWrapped();
 
+  if (!w->valid_)
+    return ThrowException(Exception::Error(
+        String::New("QKeyEvent: event object used outside its callback")));
+
   return scope.Close(qt_v8::FromQString(q->text()));
 }
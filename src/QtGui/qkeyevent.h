@@ -37,6 +37,7 @@
 class QKeyEventWrap : public node::ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
+  static bool HasInstance(v8::Handle<v8::Value> value);
   static v8::Handle<v8::Value> NewInstance(QKeyEvent q);
   QKeyEvent* GetWrapped() const { return q_; };
   void SetWrapped(QKeyEvent q) { 
@@ -44,10 +45,20 @@ class QKeyEventWrap : public node::ObjectWrap {
     q_ = new QKeyEvent(q); 
   };
 
+  // Reusable event objects: Refill() copies q over the wrapped event in
+  // place and revalidates it, Invalidate() makes wrapped methods throw
+  void Refill(const QKeyEvent& q) {
+    if (q_) *q_ = q;
+    else q_ = new QKeyEvent(q);
+    valid_ = true;
+  };
+  void Invalidate() { valid_ = false; };
+
  private:
   QKeyEventWrap();
   ~QKeyEventWrap();
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> constructor_template;
   static v8::Handle<v8::Value> New(const v8::Arguments& args);
 
   // Wrapped methods
@@ -56,6 +67,7 @@ class QKeyEventWrap : public node::ObjectWrap {
 
   // Wrapped object
   QKeyEvent* q_;
+  bool valid_;
 };
 
 #endif
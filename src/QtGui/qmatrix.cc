@@ -35,23 +35,18 @@
 using namespace v8;
 
 Persistent<Function> QMatrixWrap::constructor;
+Persistent<FunctionTemplate> QMatrixWrap::constructor_template;
 
 // Supported implementations:
 //   QMatrix ( )
 //   QMatrix ( qreal m11, qreal m12, qreal m21, qreal m22, qreal dx, qreal dy )
 //   QMatrix ( QMatrix matrix )
-QMatrixWrap::QMatrixWrap(const Arguments& args) : q_(NULL) {
+QMatrixWrap::QMatrixWrap(const Arguments& args) {
   if (args.Length() == 0) {
-    // QMatrix ( )
-
-    q_ = new QMatrix;
+    // QMatrix ( ): q_ is already the identity
   } else if (args[0]->IsObject()) {
     // QMatrix ( QMatrix matrix )
-
-    QString arg0_constructor = 
-        qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
-
-    if (arg0_constructor != "QMatrix")
+    if (!QMatrixWrap::HasInstance(args[0]))
       ThrowException(Exception::TypeError(
         String::New("QMatrix::QMatrix: bad argument")));
 
@@ -60,23 +55,23 @@ QMatrixWrap::QMatrixWrap(const Arguments& args) : q_(NULL) {
         args[0]->ToObject());
     QMatrix* q = q_wrap->GetWrapped();
 
-    q_ = new QMatrix(*q);
+    q_ = QMatrix(*q);
   } else if (args.Length() == 6) {
     // QMatrix(qreal m11, qreal m12, qreal m21, qreal m22, qreal dx, qreal dy)
 
-    q_ = new QMatrix(args[0]->NumberValue(), args[1]->NumberValue(),
-                     args[2]->NumberValue(), args[3]->NumberValue(),
-                     args[4]->NumberValue(), args[5]->NumberValue());
+    q_ = QMatrix(args[0]->NumberValue(), args[1]->NumberValue(),
+                 args[2]->NumberValue(), args[3]->NumberValue(),
+                 args[4]->NumberValue(), args[5]->NumberValue());
   }
 }
 
 QMatrixWrap::~QMatrixWrap() {
-  delete q_;
 }
 
 void QMatrixWrap::Initialize(Handle<Object> target) {
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
   tpl->SetClassName(String::NewSymbol("QMatrix"));
   tpl->InstanceTemplate()->SetInternalFieldCount(1);  
 
@@ -102,6 +97,10 @@ void QMatrixWrap::Initialize(Handle<Object> target) {
   target->Set(String::NewSymbol("QMatrix"), constructor);
 }
 
+bool QMatrixWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
 Handle<Value> QMatrixWrap::New(const Arguments& args) {
   HandleScope scope;
 
@@ -111,7 +110,7 @@ Handle<Value> QMatrixWrap::New(const Arguments& args) {
   return args.This();
 }
 
-Handle<Value> QMatrixWrap::NewInstance(QMatrix q) {
+Handle<Value> QMatrixWrap::NewInstance(const QMatrix& q) {
   HandleScope scope;
   
   Local<Object> instance = constructor->NewInstance(0, NULL);
@@ -37,17 +37,16 @@
 class QMatrixWrap : public node::ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
-  QMatrix* GetWrapped() const { return q_; };
-  void SetWrapped(QMatrix q) { 
-    if (q_) delete q_; 
-    q_ = new QMatrix(q); 
-  };
-  static v8::Handle<v8::Value> NewInstance(QMatrix q);
+  static bool HasInstance(v8::Handle<v8::Value> value);
+  QMatrix* GetWrapped() { return &q_; };
+  void SetWrapped(const QMatrix& q) { q_ = q; };
+  static v8::Handle<v8::Value> NewInstance(const QMatrix& q);
 
  private:
   QMatrixWrap(const v8::Arguments& args);
   ~QMatrixWrap();
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> constructor_template;
   static v8::Handle<v8::Value> New(const v8::Arguments& args);
 
   // Wrapped methods
@@ -61,7 +60,7 @@ class QMatrixWrap : public node::ObjectWrap {
   static v8::Handle<v8::Value> Scale(const v8::Arguments& args);
 
   // Wrapped object
-  QMatrix* q_;
+  QMatrix q_;
 };
 
 #endif
@@ -34,8 +34,9 @@
 using namespace v8;
 
 Persistent<Function> QMouseEventWrap::constructor;
+Persistent<FunctionTemplate> QMouseEventWrap::constructor_template;
 
-QMouseEventWrap::QMouseEventWrap() : q_(NULL) {
+QMouseEventWrap::QMouseEventWrap() : q_(NULL), valid_(true) {
   // Standalone constructor not implemented
   // Use SetWrapped()
 }
@@ -47,6 +48,7 @@ QMouseEventWrap::~QMouseEventWrap() {
 void QMouseEventWrap::Initialize(Handle<Object> target) {
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
   tpl->SetClassName(String::NewSymbol("QMouseEvent"));
   tpl->InstanceTemplate()->SetInternalFieldCount(1);  
 
@@ -61,6 +63,10 @@ void QMouseEventWrap::Initialize(Handle<Object> target) {
   target->Set(String::NewSymbol("QMouseEvent"), constructor);
 }
 
+bool QMouseEventWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
 Handle<Value> QMouseEventWrap::New(const Arguments& args) {
   HandleScope scope;
 
@@ -86,6 +92,10 @@ Handle<Value> QMouseEventWrap::X(const Arguments& args) {
   QMouseEventWrap* w = node::ObjectWrap::Unwrap<QMouseEventWrap>(args.This());
   QMouseEvent* q = w->GetWrapped();
 
+  if (!w->valid_)
+    return ThrowException(Exception::Error(
+        String::New("QMouseEvent: event object used outside its callback")));
+
   return scope.Close(Number::New(q->x()));
 }
 
@@ -95,6 +105,10 @@ Handle<Value> QMouseEventWrap::Y(const Arguments& args) {
   QMouseEventWrap* w = node::ObjectWrap::Unwrap<QMouseEventWrap>(args.This());
   QMouseEvent* q = w->GetWrapped();
 
+  if (!w->valid_)
+    return ThrowException(Exception::Error(
+        String::New("QMouseEvent: event object used outside its callback")));
+
   return scope.Close(Number::New(q->y()));
 }
 
@@ -104,5 +118,9 @@ Handle<Value> QMouseEventWrap::Button(const Arguments& args) {
   QMouseEventWrap* w = node::ObjectWrap::Unwrap<QMouseEventWrap>(args.This());
   QMouseEvent* q = w->GetWrapped();
 
+  if (!w->valid_)
+    return ThrowException(Exception::Error(
+        String::New("QMouseEvent: event object used outside its callback")));
+
   return scope.Close(Number::New(q->button()));
 }
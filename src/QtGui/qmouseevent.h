@@ -37,6 +37,7 @@
 class QMouseEventWrap : public node::ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
+  static bool HasInstance(v8::Handle<v8::Value> value);
   static v8::Handle<v8::Value> NewInstance(QMouseEvent q);
   QMouseEvent* GetWrapped() const { return q_; };
   void SetWrapped(QMouseEvent q) { 
@@ -44,10 +45,20 @@ class QMouseEventWrap : public node::ObjectWrap {
     q_ = new QMouseEvent(q); 
   };
 
+  // Reusable event objects: Refill() copies q over the wrapped event in
+  // place and revalidates it, Invalidate() makes wrapped methods throw
+  void Refill(const QMouseEvent& q) {
+    if (q_) *q_ = q;
+    else q_ = new QMouseEvent(q);
+    valid_ = true;
+  };
+  void Invalidate() { valid_ = false; };
+
  private:
   QMouseEventWrap();
   ~QMouseEventWrap();
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> constructor_template;
   static v8::Handle<v8::Value> New(const v8::Arguments& args);
 
   // Wrapped methods
@@ -57,6 +68,7 @@ class QMouseEventWrap : public node::ObjectWrap {
 
   // Wrapped object
   QMouseEvent* q_;
+  bool valid_;
 };
 
 #endif
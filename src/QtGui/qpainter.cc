@@ -40,10 +40,17 @@
 #include "qpainterpath.h"
 #include "qfont.h"
 #include "qmatrix.h"
+#include "qpicture.h"
+#include "paintcommands.h"
+#include "tiledrender.h"
+#include <QHash>
+#include <QPair>
+#include <QThread>
 
 using namespace v8;
 
 Persistent<Function> QPainterWrap::constructor;
+Persistent<FunctionTemplate> QPainterWrap::constructor_template;
 
 QPainterWrap::QPainterWrap() {
   q_ = new QPainter();
@@ -55,6 +62,7 @@ QPainterWrap::~QPainterWrap() {
 void QPainterWrap::Initialize(Handle<Object> target) {
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
   tpl->SetClassName(String::NewSymbol("QPainter"));
   tpl->InstanceTemplate()->SetInternalFieldCount(1);  
 
@@ -83,13 +91,25 @@ void QPainterWrap::Initialize(Handle<Object> target) {
       FunctionTemplate::New(DrawPixmap)->GetFunction());
   tpl->PrototypeTemplate()->Set(String::NewSymbol("drawImage"),
       FunctionTemplate::New(DrawImage)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("drawPicture"),
+      FunctionTemplate::New(DrawPicture)->GetFunction());
   tpl->PrototypeTemplate()->Set(String::NewSymbol("strokePath"),
       FunctionTemplate::New(StrokePath)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("submit"),
+      FunctionTemplate::New(Submit)->GetFunction());
+
+  // Static methods
+  tpl->Set(String::NewSymbol("renderTiled"),
+      FunctionTemplate::New(RenderTiled)->GetFunction());
 
   constructor = Persistent<Function>::New(tpl->GetFunction());
   target->Set(String::NewSymbol("QPainter"), constructor);
 }
 
+bool QPainterWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
 Handle<Value> QPainterWrap::New(const Arguments& args) {
   HandleScope scope;
 
@@ -114,24 +134,47 @@ Handle<Value> QPainterWrap::Begin(const Arguments& args) {
     return ThrowException(Exception::TypeError(
         String::New("QPainterWrap:Begin: bad arguments")));
 
-  QString constructor_name = 
-    qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
-  
-  // Determine argument type (from its constructor) so we can unwrap it
-  if (constructor_name == "QPixmap") {
+  // Determine argument type so we can unwrap it
+  if (QPixmapWrap::HasInstance(args[0])) {
     // QPixmap
     QPixmapWrap* pixmap_wrap = ObjectWrap::Unwrap<QPixmapWrap>(
         args[0]->ToObject());
     QPixmap* pixmap = pixmap_wrap->GetWrapped();
 
     return scope.Close(Boolean::New( q->begin(pixmap) ));
-  } else if (constructor_name == "QWidget") {
+  } else if (QImageWrap::HasInstance(args[0])) {
+    // QImage
+    QImageWrap* image_wrap = ObjectWrap::Unwrap<QImageWrap>(
+        args[0]->ToObject());
+    QImage* image = image_wrap->GetWrapped();
+
+    if (image_wrap->IsBusy())
+      return ThrowException(Exception::Error(
+          String::New("QPainterWrap::Begin: image is being rendered")));
+
+    return scope.Close(Boolean::New( q->begin(image) ));
+  } else if (QPictureWrap::HasInstance(args[0])) {
+    // QPicture (records paint commands)
+    QPictureWrap* picture_wrap = ObjectWrap::Unwrap<QPictureWrap>(
+        args[0]->ToObject());
+    QPicture* picture = picture_wrap->GetWrapped();
+
+    return scope.Close(Boolean::New( q->begin(picture) ));
+  } else if (QWidgetWrap::HasInstance(args[0])) {
     // QWidget
     QWidgetWrap* widget_wrap = ObjectWrap::Unwrap<QWidgetWrap>(
         args[0]->ToObject());
-    QWidget* widget = widget_wrap->GetWrapped();
+    QWidgetImpl* widget = widget_wrap->GetWrapped();
+
+    if (!q->begin(widget))
+      return scope.Close(Boolean::New( false ));
 
-    return scope.Close(Boolean::New( q->begin(widget) ));
+    // Inside paintEvent(): clip to the exposed region so that drawing
+    // outside of it is rejected early
+    if (widget->InPaintEvent())
+      q->setClipRegion(widget->PaintRegion());
+
+    return scope.Close(Boolean::New( true ));
   }
 
   // Unknown argument type
@@ -180,19 +223,25 @@ Handle<Value> QPainterWrap::Restore(const Arguments& args) {
 
 // Supported implementations:
 //   setPen( QPen pen )
+//   setPen( uint argb, qreal width = 0, Qt::PenStyle style = Qt::SolidLine )
+// QUIRK: the second form takes a packed 0xAARRGGBB color, as
+// PaintCommandBuffer.setPen() does, and needs no QPen object
 Handle<Value> QPainterWrap::SetPen(const Arguments& args) {
   HandleScope scope;
 
   QPainterWrap* w = ObjectWrap::Unwrap<QPainterWrap>(args.This());
   QPainter* q = w->GetWrapped();
 
-  QString arg0_constructor;
-  if (args[0]->IsObject()) {
-    arg0_constructor = 
-        qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
+  if (args[0]->IsNumber()) {
+    QPen pen(QBrush(QColor::fromRgba(args[0]->Uint32Value())),
+             args[1]->IsNumber() ? args[1]->NumberValue() : 0,
+             args[2]->IsNumber() ? (Qt::PenStyle)args[2]->IntegerValue()
+                                 : Qt::SolidLine);
+    q->setPen(pen);
+    return scope.Close(Undefined());
   }
 
-  if (arg0_constructor != "QPen")
+  if (!QPenWrap::HasInstance(args[0]))
     return ThrowException(Exception::TypeError(
       String::New("QPainterWrap::SetPen: bad argument")));
 
@@ -206,19 +255,44 @@ Handle<Value> QPainterWrap::SetPen(const Arguments& args) {
   return scope.Close(Undefined());
 }
 
+// Fonts set by family and pixel size, so that repeated setFont() calls
+// reuse a resolved QFont. Cleared when it grows past kFontCacheSize. Never
+// freed: fonts can't outlive the application
+typedef QHash<QPair<QString, int>, QFont> FontCache;
+static const int kFontCacheSize = 64;
+static FontCache* fontCache = NULL;
+
+// Supported implementations:
+//   setFont( QFont font )
+//   setFont( QString family, int pixelSize )
+// QUIRK: the second form needs no QFont object, as
+// PaintCommandBuffer.setFont()
 Handle<Value> QPainterWrap::SetFont(const Arguments& args) {
   HandleScope scope;
 
   QPainterWrap* w = ObjectWrap::Unwrap<QPainterWrap>(args.This());
   QPainter* q = w->GetWrapped();
 
-  QString arg0_constructor;
-  if (args[0]->IsObject()) {
-    arg0_constructor = 
-        qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
+  if (args[0]->IsString() && args[1]->IsNumber()) {
+    if (!fontCache)
+      fontCache = new FontCache;
+
+    QPair<QString, int> key(qt_v8::ToQStringInterned(args[0]->ToString()),
+                            args[1]->IntegerValue());
+    FontCache::const_iterator it = fontCache->constFind(key);
+    if (it == fontCache->constEnd()) {
+      if (fontCache->size() >= kFontCacheSize)
+        fontCache->clear();
+      QFont font(key.first);
+      if (key.second > 0)
+        font.setPixelSize(key.second);
+      it = fontCache->insert(key, font);
+    }
+    q->setFont(*it);
+    return scope.Close(Undefined());
   }
 
-  if (arg0_constructor != "QFont")
+  if (!QFontWrap::HasInstance(args[0]))
     return ThrowException(Exception::TypeError(
       String::New("QPainterWrap::SetFont: bad argument")));
 
@@ -239,13 +313,7 @@ Handle<Value> QPainterWrap::SetMatrix(const Arguments& args) {
   QPainterWrap* w = ObjectWrap::Unwrap<QPainterWrap>(args.This());
   QPainter* q = w->GetWrapped();
 
-  QString arg0_constructor;
-  if (args[0]->IsObject()) {
-    arg0_constructor = 
-        qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
-  }
-
-  if (arg0_constructor != "QMatrix")
+  if (!QMatrixWrap::HasInstance(args[0]))
     return ThrowException(Exception::TypeError(
       String::New("QPainterWrap::SetMatrix: bad argument")));
 
@@ -263,6 +331,10 @@ Handle<Value> QPainterWrap::SetMatrix(const Arguments& args) {
 //   fillRect(int x, int y, int w, int h, QBrush brush)
 //   fillRect(int x, int y, int w, int h, QColor color)
 //   fillRect(int x, int y, int w, int h, Qt::GlobalColor color)
+//   fillRect(int x, int y, int w, int h, uint argb)
+// QUIRK: numbers up to Qt::transparent (19) are Qt::GlobalColor, larger
+// ones packed 0xAARRGGBB colors as in PaintCommandBuffer.fillRect(). The
+// nearly invisible colors 0x00000000 to 0x00000013 need a QColor
 Handle<Value> QPainterWrap::FillRect(const Arguments& args) {
   HandleScope scope;
 
@@ -272,14 +344,8 @@ Handle<Value> QPainterWrap::FillRect(const Arguments& args) {
   if (!args[0]->IsNumber() || !args[1]->IsNumber() || !args[2]->IsNumber() ||
       !args[3]->IsNumber())
     return scope.Close(Undefined());
-      
-  QString arg4_constructor;
-  if (args[4]->IsObject()) {
-    arg4_constructor = 
-        qt_v8::ToQString(args[4]->ToObject()->GetConstructorName());
-  }
-  
-  if (arg4_constructor == "QBrush") {
+
+  if (QBrushWrap::HasInstance(args[4])) {
     // fillRect(int x, int y, int w, int h, QBrush brush)
 
     // Unwrap QBrush
@@ -290,7 +356,7 @@ Handle<Value> QPainterWrap::FillRect(const Arguments& args) {
     q->fillRect(args[0]->IntegerValue(), args[1]->IntegerValue(),
                 args[2]->IntegerValue(), args[3]->IntegerValue(), 
                 *brush);
-  } else if (arg4_constructor == "QColor") {
+  } else if (QColorWrap::HasInstance(args[4])) {
     // fillRect(int x, int y, int w, int h, QColor color)
 
     // Unwrap QColor
@@ -302,11 +368,19 @@ Handle<Value> QPainterWrap::FillRect(const Arguments& args) {
                 args[2]->IntegerValue(), args[3]->IntegerValue(), 
                 *color);
   } else if (args[4]->IsNumber()) {
-    // fillRect(int x, int y, int w, int h, Qt::GlobalColor color)
-
-    q->fillRect(args[0]->IntegerValue(), args[1]->IntegerValue(),
-                args[2]->IntegerValue(), args[3]->IntegerValue(), 
-                (Qt::GlobalColor)args[4]->IntegerValue());
+    uint color = args[4]->Uint32Value();
+
+    if (color <= Qt::transparent) {
+      // fillRect(int x, int y, int w, int h, Qt::GlobalColor color)
+      q->fillRect(args[0]->IntegerValue(), args[1]->IntegerValue(),
+                  args[2]->IntegerValue(), args[3]->IntegerValue(),
+                  (Qt::GlobalColor)color);
+    } else {
+      // fillRect(int x, int y, int w, int h, uint argb)
+      q->fillRect(args[0]->IntegerValue(), args[1]->IntegerValue(),
+                  args[2]->IntegerValue(), args[3]->IntegerValue(),
+                  QColor::fromRgba(color));
+    }
   } else {
     return ThrowException(Exception::TypeError(
         String::New("QPainterWrap:fillRect: bad arguments")));
@@ -328,7 +402,7 @@ Handle<Value> QPainterWrap::DrawText(const Arguments& args) {
         String::New("QPainterWrap:DrawText: bad arguments")));
       
   q->drawText(args[0]->IntegerValue(), args[1]->IntegerValue(), 
-      qt_v8::ToQString(args[2]->ToString()));
+      qt_v8::ToQStringInterned(args[2]->ToString()));
 
   return scope.Close(Undefined());
 }
@@ -341,13 +415,7 @@ Handle<Value> QPainterWrap::DrawPixmap(const Arguments& args) {
   QPainterWrap* w = ObjectWrap::Unwrap<QPainterWrap>(args.This());
   QPainter* q = w->GetWrapped();
 
-  QString arg2_constructor;
-  if (args[2]->IsObject()) {
-    arg2_constructor = 
-        qt_v8::ToQString(args[2]->ToObject()->GetConstructorName());
-  }
-
-  if (arg2_constructor != "QPixmap" ) {
+  if (!QPixmapWrap::HasInstance(args[2])) {
     return ThrowException(Exception::TypeError(
       String::New("QPainterWrap::DrawPixmap: pixmap argument not recognized")));
   }
@@ -375,13 +443,7 @@ Handle<Value> QPainterWrap::DrawImage(const Arguments& args) {
   QPainterWrap* w = ObjectWrap::Unwrap<QPainterWrap>(args.This());
   QPainter* q = w->GetWrapped();
 
-  QString arg2_constructor;
-  if (args[2]->IsObject()) {
-    arg2_constructor = 
-        qt_v8::ToQString(args[2]->ToObject()->GetConstructorName());
-  }
-
-  if (arg2_constructor != "QImage" ) {
+  if (!QImageWrap::HasInstance(args[2])) {
     return ThrowException(Exception::TypeError(
       String::New("QPainterWrap::DrawImage: image argument not recognized")));
   }
@@ -402,31 +464,42 @@ Handle<Value> QPainterWrap::DrawImage(const Arguments& args) {
 }
 
 // Supported versions:
-//   strokePath( QPainterPath path, QPen pen )
-Handle<Value> QPainterWrap::StrokePath(const Arguments& args) {
+//   drawPicture( int x, int y, QPicture picture )
+Handle<Value> QPainterWrap::DrawPicture(const Arguments& args) {
   HandleScope scope;
 
   QPainterWrap* w = ObjectWrap::Unwrap<QPainterWrap>(args.This());
   QPainter* q = w->GetWrapped();
 
-  QString arg0_constructor;
-  if (args[0]->IsObject()) {
-    arg0_constructor = 
-        qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
+  if (!QPictureWrap::HasInstance(args[2])) {
+    return ThrowException(Exception::TypeError(
+      String::New("QPainterWrap::DrawPicture: picture argument not recognized")));
   }
 
-  if (arg0_constructor != "QPainterPath" ) {
+  // Unwrap QPicture
+  QPictureWrap* picture_wrap = ObjectWrap::Unwrap<QPictureWrap>(
+      args[2]->ToObject());
+  QPicture* picture = picture_wrap->GetWrapped();
+
+  q->drawPicture(args[0]->IntegerValue(), args[1]->IntegerValue(), *picture);
+
+  return scope.Close(Undefined());
+}
+
+// Supported versions:
+//   strokePath( QPainterPath path, QPen pen )
+Handle<Value> QPainterWrap::StrokePath(const Arguments& args) {
+  HandleScope scope;
+
+  QPainterWrap* w = ObjectWrap::Unwrap<QPainterWrap>(args.This());
+  QPainter* q = w->GetWrapped();
+
+  if (!QPainterPathWrap::HasInstance(args[0])) {
     return ThrowException(Exception::TypeError(
       String::New("QPainterWrap::StrokePath: bad arguments")));
   }
-  
-  QString arg1_constructor;
-  if (args[1]->IsObject()) {
-    arg1_constructor = 
-        qt_v8::ToQString(args[1]->ToObject()->GetConstructorName());
-  }
 
-  if (arg1_constructor != "QPen" ) {
+  if (!QPenWrap::HasInstance(args[1])) {
     return ThrowException(Exception::TypeError(
       String::New("QPainterWrap::StrokePath: bad arguments")));
   }
@@ -445,3 +518,272 @@ Handle<Value> QPainterWrap::StrokePath(const Arguments& args) {
 
   return scope.Close(Undefined());
 }
+
+// Reads a batch of paint commands from JS: a PaintCommandBuffer, or a
+// Float64Array with its length and side tables. commands points into the
+// Float64Array. Throws and returns false on bad arguments
+bool QPainterWrap::ReadCommands(const char* caller, Local<Value> arg,
+                         Local<Value> length, Local<Value> strings,
+                         Local<Value> images, const double** commands,
+                         int* count, PaintCommands::Resources* resources) {
+  if (!arg->IsObject()) {
+    ThrowException(Exception::TypeError(String::Concat(
+        String::New(caller), String::New(": bad arguments"))));
+    return false;
+  }
+
+  Local<Object> array = arg->ToObject();
+
+  if (!array->HasIndexedPropertiesInExternalArrayData()) {
+    // PaintCommandBuffer
+    Local<Object> buffer = array;
+    Local<Value> ops = buffer->Get(String::NewSymbol("commands"));
+    if (!ops->IsObject()) {
+      ThrowException(Exception::TypeError(String::Concat(
+          String::New(caller), String::New(": bad arguments"))));
+      return false;
+    }
+
+    array = ops->ToObject();
+    length = buffer->Get(String::NewSymbol("length"));
+    strings = buffer->Get(String::NewSymbol("strings"));
+    images = buffer->Get(String::NewSymbol("images"));
+  }
+
+  if (array->GetIndexedPropertiesExternalArrayDataType() != 
+      kExternalDoubleArray) {
+    ThrowException(Exception::TypeError(String::Concat(
+        String::New(caller),
+        String::New(": commands must be a Float64Array"))));
+    return false;
+  }
+
+  int available = array->GetIndexedPropertiesExternalArrayDataLength();
+  *count = length->IsNumber() ? length->IntegerValue() : available;
+  if (*count < 0 || *count > available) {
+    ThrowException(Exception::RangeError(String::Concat(
+        String::New(caller), String::New(": bad length"))));
+    return false;
+  }
+
+  // Side tables
+  if (strings->IsArray()) {
+    Local<Array> list = Local<Array>::Cast(strings);
+    resources->strings.resize(list->Length());
+    for (uint32_t i = 0; i < list->Length(); i++)
+      resources->strings[i] =
+          qt_v8::ToQStringInterned(list->Get(i)->ToString());
+  }
+
+  if (images->IsArray()) {
+    Local<Array> list = Local<Array>::Cast(images);
+    resources->images.resize(list->Length());
+    resources->pixmaps.resize(list->Length());
+    for (uint32_t i = 0; i < list->Length(); i++) {
+      Local<Value> image = list->Get(i);
+      if (QImageWrap::HasInstance(image)) {
+        resources->images[i] = *ObjectWrap::Unwrap<QImageWrap>(
+            image->ToObject())->GetWrapped();
+      } else if (QPixmapWrap::HasInstance(image)) {
+        resources->pixmaps[i] = *ObjectWrap::Unwrap<QPixmapWrap>(
+            image->ToObject())->GetWrapped();
+      }
+    }
+  }
+
+  *commands = static_cast<const double*>(
+      array->GetIndexedPropertiesExternalArrayData());
+
+  return true;
+}
+
+// Supported versions:
+//   submit(Float64Array commands, int length, Array strings, Array images)
+//   submit(PaintCommandBuffer buffer)
+//
+// QUIRK:
+// Not in Qt. Runs a batch of paint commands encoded by
+// qt.PaintCommandBuffer (see lib/paintcommands.js) in a single call
+Handle<Value> QPainterWrap::Submit(const Arguments& args) {
+  HandleScope scope;
+
+  QPainterWrap* w = ObjectWrap::Unwrap<QPainterWrap>(args.This());
+  QPainter* q = w->GetWrapped();
+
+  const double* commands;
+  int count;
+  PaintCommands::Resources resources;
+  if (!ReadCommands("QPainterWrap::Submit", args[0], args[1], args[2],
+                    args[3], &commands, &count, &resources))
+    return scope.Close(Undefined());
+
+  QString error;
+  if (!PaintCommands::Execute(q, commands, count, resources, &error))
+    return ThrowException(Exception::RangeError(qt_v8::FromQString(
+        "QPainterWrap::Submit: " + error)));
+
+  return scope.Close(Undefined());
+}
+
+//
+// TileRequest
+// State of an asynchronous tiled render. Commands are copied; the target's
+// pixels are painted in place. The image is marked busy meanwhile, so JS
+// can't free, replace or paint on them
+//
+struct TileRequest {
+  uv_work_t req;
+
+  // Input
+  TiledRender::Target target;
+  QImage pixels; // keeps target.bits allocated
+  QVector<double> commands;
+  PaintCommands::Resources resources;
+  int columns;
+  int rows;
+  int threads;
+
+  // Output
+  QString error;
+
+  v8::Persistent<v8::Object> image;
+  v8::Persistent<v8::Function> callback;
+};
+
+//
+// QUIRK:
+// RenderTiled()
+// Static. renderTiled(QImage image, PaintCommandBuffer commands,
+//   [Object options], [Function cb])
+// Not in Qt. Replays commands into image split in columns x rows tiles,
+// each painted by its own QPainter on a worker thread, directly into the
+// image's pixels. Options:
+//   columns, rows: tile grid, 4 x 4 by default
+//   threads: QThread::idealThreadCount() by default
+// Without cb, returns when done. With cb, runs on the libuv threadpool and
+// calls cb(err); until then, methods of the image that use its pixels
+// throw, as does painting on it
+//
+Handle<Value> QPainterWrap::RenderTiled(const Arguments& args) {
+  HandleScope scope;
+
+  if (!QImageWrap::HasInstance(args[0]))
+    return ThrowException(Exception::TypeError(
+        String::New("QPainterWrap::RenderTiled: bad arguments")));
+
+  QImageWrap* image_wrap = ObjectWrap::Unwrap<QImageWrap>(
+      args[0]->ToObject());
+  QImage* image = image_wrap->GetWrapped();
+
+  if (image_wrap->IsBusy())
+    return ThrowException(Exception::Error(
+        String::New("QPainterWrap::RenderTiled: image is being rendered")));
+
+  const double* commands;
+  int count;
+  PaintCommands::Resources resources;
+  Local<Value> none = Local<Value>::New(Undefined());
+  if (!ReadCommands("QPainterWrap::RenderTiled", args[1], none, none, none,
+                    &commands, &count, &resources))
+    return scope.Close(Undefined());
+
+  int columns = 4;
+  int rows = 4;
+  int threads = QThread::idealThreadCount();
+
+  Local<Value> callback = args[2]->IsFunction() ? args[2] : args[3];
+  if (args[2]->IsObject() && !args[2]->IsFunction()) {
+    Local<Object> o = args[2]->ToObject();
+    Local<Value> c = o->Get(String::NewSymbol("columns"));
+    Local<Value> r = o->Get(String::NewSymbol("rows"));
+    Local<Value> t = o->Get(String::NewSymbol("threads"));
+    if (c->IsNumber())
+      columns = c->IntegerValue();
+    if (r->IsNumber())
+      rows = r->IntegerValue();
+    if (t->IsNumber())
+      threads = t->IntegerValue();
+  }
+
+  if (columns < 1 || rows < 1)
+    return ThrowException(Exception::RangeError(
+        String::New("QPainterWrap::RenderTiled: bad tile grid")));
+
+  if (image->isNull() || image->depth() < 16)
+    return ThrowException(Exception::RangeError(
+        String::New("QPainterWrap::RenderTiled: unsupported image")));
+
+  PaintCommands::ConvertPixmaps(&resources);
+
+  // Detaches the image here, tiles share its pixels afterwards
+  TiledRender::Target target;
+  target.bits = image->bits();
+  target.width = image->width();
+  target.height = image->height();
+  target.bytesPerLine = image->bytesPerLine();
+  target.format = image->format();
+
+  if (!callback->IsFunction()) {
+    QString error;
+    if (!TiledRender::Render(target, commands, count, resources, columns,
+                             rows, threads, &error))
+      return ThrowException(Exception::RangeError(qt_v8::FromQString(
+          "QPainterWrap::RenderTiled: " + error)));
+    return scope.Close(Undefined());
+  }
+
+  TileRequest* request = new TileRequest;
+  request->req.data = request;
+  request->target = target;
+  request->commands.resize(count);
+  qMemCopy(request->commands.data(), commands, count * sizeof(double));
+  request->resources = resources;
+  request->columns = columns;
+  request->rows = rows;
+  request->threads = threads;
+  request->pixels = image_wrap->PixelOwner();
+  request->image = Persistent<Object>::New(args[0]->ToObject());
+  image_wrap->SetBusy(true);
+  request->callback = Persistent<Function>::New(
+      Local<Function>::Cast(callback));
+
+  uv_queue_work(uv_default_loop(), &request->req, OnRenderTiledWork,
+                OnRenderTiledDone);
+
+  return scope.Close(Undefined());
+}
+
+// Runs on a threadpool thread: no V8 here. Tiles fan out further onto
+// QThreadPool
+void QPainterWrap::OnRenderTiledWork(uv_work_t* req) {
+  TileRequest* request = static_cast<TileRequest*>(req->data);
+
+  TiledRender::Render(request->target, request->commands.constData(),
+                      request->commands.size(), request->resources,
+                      request->columns, request->rows, request->threads,
+                      &request->error);
+}
+
+void QPainterWrap::OnRenderTiledDone(uv_work_t* req) {
+  HandleScope scope;
+  TryCatch try_catch;
+
+  TileRequest* request = static_cast<TileRequest*>(req->data);
+  ObjectWrap::Unwrap<QImageWrap>(request->image)->SetBusy(false);
+
+  Handle<Value> argv[1];
+  if (request->error.isEmpty())
+    argv[0] = Null();
+  else
+    argv[0] = Exception::RangeError(qt_v8::FromQString(
+        "QPainter.renderTiled: " + request->error));
+
+  request->callback->Call(Context::GetCurrent()->Global(), 1, argv);
+
+  request->image.Dispose();
+  request->callback.Dispose();
+  delete request;
+
+  if (try_catch.HasCaught())
+    node::FatalException(try_catch);
+}
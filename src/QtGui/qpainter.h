@@ -32,17 +32,29 @@
 
 #define BUILDING_NODE_EXTENSION
 #include <node.h>
+#include <uv.h>
 #include <QPainter>
+#include "paintcommands.h"
 
 class QPainterWrap : public node::ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
+  static bool HasInstance(v8::Handle<v8::Value> value);
   QPainter* GetWrapped() const { return q_; };
 
+  // Reads the arguments of submit(), for other functions taking commands
+  static bool ReadCommands(const char* caller, v8::Local<v8::Value> arg,
+                           v8::Local<v8::Value> length,
+                           v8::Local<v8::Value> strings,
+                           v8::Local<v8::Value> images,
+                           const double** commands, int* count,
+                           PaintCommands::Resources* resources);
+
  private:
   QPainterWrap();
   ~QPainterWrap();
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> constructor_template;
   static v8::Handle<v8::Value> New(const v8::Arguments& args);
 
   //
@@ -65,8 +77,18 @@ class QPainterWrap : public node::ObjectWrap {
   static v8::Handle<v8::Value> DrawText(const v8::Arguments& args);
   static v8::Handle<v8::Value> DrawPixmap(const v8::Arguments& args);
   static v8::Handle<v8::Value> DrawImage(const v8::Arguments& args);
+  static v8::Handle<v8::Value> DrawPicture(const v8::Arguments& args);
   static v8::Handle<v8::Value> StrokePath(const v8::Arguments& args);
 
+  // Batched paint actions
+  static v8::Handle<v8::Value> Submit(const v8::Arguments& args);
+
+  // QUIRK
+  // Tile-parallel rendering of a batch into a QImage
+  static v8::Handle<v8::Value> RenderTiled(const v8::Arguments& args);
+  static void OnRenderTiledWork(uv_work_t* req);
+  static void OnRenderTiledDone(uv_work_t* req);
+
   // Wrapped object
   QPainter* q_;
 };
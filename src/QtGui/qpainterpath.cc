@@ -36,6 +36,7 @@
 using namespace v8;
 
 Persistent<Function> QPainterPathWrap::constructor;
+Persistent<FunctionTemplate> QPainterPathWrap::constructor_template;
 
 // Supported implementations:
 //   QPainterPath ( ??? )
@@ -50,6 +51,7 @@ QPainterPathWrap::~QPainterPathWrap() {
 void QPainterPathWrap::Initialize(Handle<Object> target) {
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
   tpl->SetClassName(String::NewSymbol("QPainterPath"));
   tpl->InstanceTemplate()->SetInternalFieldCount(1);  
 
@@ -67,6 +69,10 @@ void QPainterPathWrap::Initialize(Handle<Object> target) {
   target->Set(String::NewSymbol("QPainterPath"), constructor);
 }
 
+bool QPainterPathWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
 Handle<Value> QPainterPathWrap::New(const Arguments& args) {
   HandleScope scope;
 
@@ -78,19 +84,20 @@ Handle<Value> QPainterPathWrap::New(const Arguments& args) {
 
 // Supported versions:
 //   moveTo( QPointF() )
+//   moveTo( qreal x, qreal y )
 Handle<Value> QPainterPathWrap::MoveTo(const Arguments& args) {
   HandleScope scope;
 
   QPainterPathWrap* w = ObjectWrap::Unwrap<QPainterPathWrap>(args.This());
   QPainterPath* q = w->GetWrapped();
 
-  QString arg0_constructor;
-  if (args[0]->IsObject()) {
-    arg0_constructor = 
-        qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
+  if (args[0]->IsNumber() && args[1]->IsNumber()) {
+    // moveTo( qreal x, qreal y ): no QPointF to allocate and unwrap
+    q->moveTo(args[0]->NumberValue(), args[1]->NumberValue());
+    return scope.Close(Undefined());
   }
-  
-  if (arg0_constructor != "QPointF")
+
+  if (!QPointFWrap::HasInstance(args[0]))
     return ThrowException(Exception::TypeError(
       String::New("QPainterPathWrap::MoveTo: argument not recognized")));
 
@@ -115,21 +122,22 @@ Handle<Value> QPainterPathWrap::CurrentPosition(const Arguments& args) {
 
 // Supported versions:
 //   lineTo( QPointF() )
+//   lineTo( qreal x, qreal y )
 Handle<Value> QPainterPathWrap::LineTo(const Arguments& args) {
   HandleScope scope;
 
   QPainterPathWrap* w = ObjectWrap::Unwrap<QPainterPathWrap>(args.This());
   QPainterPath* q = w->GetWrapped();
 
-  QString arg0_constructor;
-  if (args[0]->IsObject()) {
-    arg0_constructor = 
-        qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
+  if (args[0]->IsNumber() && args[1]->IsNumber()) {
+    // lineTo( qreal x, qreal y )
+    q->lineTo(args[0]->NumberValue(), args[1]->NumberValue());
+    return scope.Close(Undefined());
   }
-  
-  if (arg0_constructor != "QPointF")
+
+  if (!QPointFWrap::HasInstance(args[0]))
     return ThrowException(Exception::TypeError(
-      String::New("QPainterPathWrap::MoveTo: argument not recognized")));
+      String::New("QPainterPathWrap::LineTo: argument not recognized")));
 
   // lineTo( QPointF point )
   QPointFWrap* pointf_wrap = ObjectWrap::Unwrap<QPointFWrap>(
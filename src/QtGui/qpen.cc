@@ -37,26 +37,22 @@
 using namespace v8;
 
 Persistent<Function> QPenWrap::constructor;
+Persistent<FunctionTemplate> QPenWrap::constructor_template;
 
 // Supported implementations:
 //   QPen (QBrush brush, qreal width, Qt::PenStyle style = Qt::SolidLine, Qt::PenCapStyle cap = Qt::SquareCap, Qt::PenJoinStyle join = Qt::BevelJoin )
 //   QPen (QColor color)
 //   QPen ()
 QPenWrap::QPenWrap(const Arguments& args) {
-  QString arg0_constructor;
-  if (args[0]->IsObject()) {
-    arg0_constructor = 
-        qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
-  }
 
   if (!args[0]->IsObject()) {
     // QPen ()
   
-    q_ = new QPen();
+    q_ = QPen();
     return;
   }
 
-  if (arg0_constructor == "QColor") {
+  if (QColorWrap::HasInstance(args[0])) {
     // QPen (QColor color)
 
     // Unwrap QColor
@@ -64,9 +60,9 @@ QPenWrap::QPenWrap(const Arguments& args) {
         args[0]->ToObject());
     QColor* color = color_wrap->GetWrapped();
 
-    q_ = new QPen(*color);
+    q_ = QPen(*color);
     return;
-  } else if (arg0_constructor == "QBrush") {    
+  } else if (QBrushWrap::HasInstance(args[0])) {    
     // QPen (QBrush brush, qreal width, Qt::PenStyle style = Qt::SolidLine, Qt::PenCapStyle cap = Qt::SquareCap, Qt::PenJoinStyle join = Qt::BevelJoin )
     
     // Unwrap QBrush
@@ -77,14 +73,14 @@ QPenWrap::QPenWrap(const Arguments& args) {
     qreal width(args[1]->NumberValue());
 
     if (args.Length() == 2) {
-      q_ = new QPen(*brush, width);
+      q_ = QPen(*brush, width);
       return;
     }
 
     if (args.Length() == 3) {
       Qt::PenStyle style((Qt::PenStyle)args[2]->IntegerValue());
 
-      q_ = new QPen(*brush, width, style);
+      q_ = QPen(*brush, width, style);
       return;
     }
 
@@ -92,7 +88,7 @@ QPenWrap::QPenWrap(const Arguments& args) {
       Qt::PenStyle style((Qt::PenStyle)args[2]->IntegerValue());
       Qt::PenCapStyle cap((Qt::PenCapStyle)args[3]->IntegerValue());
 
-      q_ = new QPen(*brush, width, style, cap);
+      q_ = QPen(*brush, width, style, cap);
       return;
     }
 
@@ -101,19 +97,19 @@ QPenWrap::QPenWrap(const Arguments& args) {
       Qt::PenCapStyle cap((Qt::PenCapStyle)args[3]->IntegerValue());
       Qt::PenJoinStyle join((Qt::PenJoinStyle)args[4]->IntegerValue());
 
-      q_ = new QPen(*brush, width, style, cap, join);
+      q_ = QPen(*brush, width, style, cap, join);
       return;
     }
   } // QPen (QBrush, ...)
 }
 
 QPenWrap::~QPenWrap() {
-  delete q_;
 }
 
 void QPenWrap::Initialize(Handle<Object> target) {
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
   tpl->SetClassName(String::NewSymbol("QPen"));
   tpl->InstanceTemplate()->SetInternalFieldCount(1);  
 
@@ -121,6 +117,10 @@ void QPenWrap::Initialize(Handle<Object> target) {
   target->Set(String::NewSymbol("QPen"), constructor);
 }
 
+bool QPenWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
 Handle<Value> QPenWrap::New(const Arguments& args) {
   HandleScope scope;
 
@@ -37,18 +37,20 @@
 class QPenWrap : public node::ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
-  QPen* GetWrapped() const { return q_; };
+  static bool HasInstance(v8::Handle<v8::Value> value);
+  QPen* GetWrapped() { return &q_; };
 
  private:
   QPenWrap(const v8::Arguments& args);
   ~QPenWrap();
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> constructor_template;
   static v8::Handle<v8::Value> New(const v8::Arguments& args);
 
   // Wrapped methods
 
   // Wrapped object
-  QPen* q_;
+  QPen q_;
 };
 
 #endif
@@ -0,0 +1,210 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#define BUILDING_NODE_EXTENSION
+#include <node.h>
+#include <node_buffer.h>
+#include <string.h>
+#include "qpicture.h"
+#include "../qt_v8.h"
+
+using namespace v8;
+
+// Header of QPicture data
+static const char kPictureMagic[] = "QPIC";
+
+Persistent<Function> QPictureWrap::constructor;
+Persistent<FunctionTemplate> QPictureWrap::constructor_template;
+
+QPictureWrap::QPictureWrap() : q_(NULL) {
+  q_ = new QPicture();
+}
+
+QPictureWrap::~QPictureWrap() {
+  delete q_;
+}
+
+void QPictureWrap::Initialize(Handle<Object> target) {
+  // Prepare constructor template
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
+  tpl->SetClassName(String::NewSymbol("QPicture"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);  
+
+  // Prototype
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("isNull"),
+      FunctionTemplate::New(IsNull)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("size"),
+      FunctionTemplate::New(Size)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("width"),
+      FunctionTemplate::New(Width)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("height"),
+      FunctionTemplate::New(Height)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("save"),
+      FunctionTemplate::New(Save)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("load"),
+      FunctionTemplate::New(Load)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("data"),
+      FunctionTemplate::New(Data)->GetFunction());
+
+  // Static methods
+  tpl->Set(String::NewSymbol("fromBuffer"),
+      FunctionTemplate::New(FromBuffer)->GetFunction());
+
+  constructor = Persistent<Function>::New(tpl->GetFunction());
+  target->Set(String::NewSymbol("QPicture"), constructor);
+}
+
+bool QPictureWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
+Handle<Value> QPictureWrap::New(const Arguments& args) {
+  HandleScope scope;
+
+  QPictureWrap* w = new QPictureWrap();
+  w->Wrap(args.This());
+
+  return args.This();
+}
+
+Handle<Value> QPictureWrap::NewInstance(QPicture q) {
+  HandleScope scope;
+  
+  Local<Object> instance = constructor->NewInstance(0, NULL);
+  QPictureWrap* w = node::ObjectWrap::Unwrap<QPictureWrap>(instance);
+  w->SetWrapped(q);
+
+  return scope.Close(instance);
+}
+
+Handle<Value> QPictureWrap::IsNull(const Arguments& args) {
+  HandleScope scope;
+
+  QPictureWrap* w = ObjectWrap::Unwrap<QPictureWrap>(args.This());
+  QPicture* q = w->GetWrapped();
+
+  return scope.Close(Boolean::New(q->isNull()));
+}
+
+// Size of the recorded data, in bytes
+Handle<Value> QPictureWrap::Size(const Arguments& args) {
+  HandleScope scope;
+
+  QPictureWrap* w = ObjectWrap::Unwrap<QPictureWrap>(args.This());
+  QPicture* q = w->GetWrapped();
+
+  return scope.Close(Integer::New(q->size()));
+}
+
+Handle<Value> QPictureWrap::Width(const Arguments& args) {
+  HandleScope scope;
+
+  QPictureWrap* w = ObjectWrap::Unwrap<QPictureWrap>(args.This());
+  QPicture* q = w->GetWrapped();
+
+  return scope.Close(Integer::New(q->width()));
+}
+
+Handle<Value> QPictureWrap::Height(const Arguments& args) {
+  HandleScope scope;
+
+  QPictureWrap* w = ObjectWrap::Unwrap<QPictureWrap>(args.This());
+  QPicture* q = w->GetWrapped();
+
+  return scope.Close(Integer::New(q->height()));
+}
+
+Handle<Value> QPictureWrap::Save(const Arguments& args) {
+  HandleScope scope;
+
+  QPictureWrap* w = ObjectWrap::Unwrap<QPictureWrap>(args.This());
+  QPicture* q = w->GetWrapped();
+
+  QString file(qt_v8::ToQString(args[0]->ToString()));
+
+  return scope.Close(Boolean::New( q->save(file) ));
+}
+
+Handle<Value> QPictureWrap::Load(const Arguments& args) {
+  HandleScope scope;
+
+  QPictureWrap* w = ObjectWrap::Unwrap<QPictureWrap>(args.This());
+  QPicture* q = w->GetWrapped();
+
+  QString file(qt_v8::ToQString(args[0]->ToString()));
+
+  return scope.Close(Boolean::New( q->load(file) ));
+}
+
+//
+// QUIRK:
+// Data()
+// Returns a copy of the recorded picture data as a Node Buffer. Use
+// QPicture.fromBuffer() to restore it
+//
+Handle<Value> QPictureWrap::Data(const Arguments& args) {
+  HandleScope scope;
+
+  QPictureWrap* w = ObjectWrap::Unwrap<QPictureWrap>(args.This());
+  QPicture* q = w->GetWrapped();
+
+  node::Buffer* buffer = node::Buffer::New(q->data(), q->size());
+
+  return scope.Close(buffer->handle_);
+}
+
+//
+// QUIRK:
+// FromBuffer()
+// Static. Creates a QPicture from data returned by data(). Throws if the
+// data is not a valid picture
+//
+Handle<Value> QPictureWrap::FromBuffer(const Arguments& args) {
+  HandleScope scope;
+
+  if (!node::Buffer::HasInstance(args[0]))
+    return ThrowException(Exception::TypeError(
+        String::New("QPictureWrap::FromBuffer: argument not a Buffer")));
+
+  Local<Object> buffer = args[0]->ToObject();
+  const char* data = node::Buffer::Data(buffer);
+  size_t length = node::Buffer::Length(buffer);
+
+  // QPicture only checks its format when played back
+  if (length < sizeof(kPictureMagic) - 1 ||
+      memcmp(data, kPictureMagic, sizeof(kPictureMagic) - 1) != 0)
+    return ThrowException(Exception::Error(
+        String::New("QPictureWrap::FromBuffer: invalid picture data")));
+
+  QPicture picture;
+  picture.setData(data, length);
+
+  return scope.Close(NewInstance(picture));
+}
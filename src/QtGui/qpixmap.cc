@@ -29,24 +29,56 @@
 
 #define BUILDING_NODE_EXTENSION
 #include <node.h>
+#include <QApplication>
+#include <QThread>
 #include "../qt_v8.h"
 #include "qpixmap.h"
 #include "qcolor.h"
+#include "qimage.h"
+#include "imagescale.h"
+#include "surfacepool.h"
 
 using namespace v8;
 
 Persistent<Function> QPixmapWrap::constructor;
+Persistent<FunctionTemplate> QPixmapWrap::constructor_template;
 
-QPixmapWrap::QPixmapWrap(int width, int height) : q_(NULL) {
+QPixmapWrap::QPixmapWrap(int width, int height)
+    : q_(NULL), memory_(0), disposed_(false), pooled_(false) {
   q_ = new QPixmap(width, height);
+  UpdateMemory();
 }
 QPixmapWrap::~QPixmapWrap() {
+  if (pooled_)
+    SurfacePool::Release(*q_);
   delete q_;
+  q_ = NULL;
+  UpdateMemory();
+}
+
+//
+// UpdateMemory()
+// Tells V8 about the pixels the wrapper holds, so that large pixmaps weigh
+// on garbage collection. Pixmaps may live in the window system rather
+// than in this process; they are counted all the same
+//
+void QPixmapWrap::UpdateMemory() {
+  int memory = q_ ? q_->width() * q_->height() * q_->depth() / 8 : 0;
+  if (memory != memory_)
+    V8::AdjustAmountOfExternalAllocatedMemory(memory - memory_);
+  memory_ = memory;
+}
+
+// Methods called after dispose()
+static Handle<Value> ThrowDisposed() {
+  return ThrowException(Exception::Error(
+      String::New("QPixmapWrap: pixmap was disposed")));
 }
 
 void QPixmapWrap::Initialize(Handle<Object> target) {
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
   tpl->SetClassName(String::NewSymbol("QPixmap"));
   tpl->InstanceTemplate()->SetInternalFieldCount(1);  
 
@@ -59,14 +91,28 @@ void QPixmapWrap::Initialize(Handle<Object> target) {
       FunctionTemplate::New(Save)->GetFunction());
   tpl->PrototypeTemplate()->Set(String::NewSymbol("fill"),
       FunctionTemplate::New(Fill)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("toImage"),
+      FunctionTemplate::New(ToImage)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("scaled"),
+      FunctionTemplate::New(Scaled)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("dispose"),
+      FunctionTemplate::New(Dispose)->GetFunction());
 
   constructor = Persistent<Function>::New(tpl->GetFunction());
   target->Set(String::NewSymbol("QPixmap"), constructor);
 }
 
+bool QPixmapWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
 Handle<Value> QPixmapWrap::New(const Arguments& args) {
   HandleScope scope;
 
+  if (QApplication::type() == QApplication::Tty)
+    return ThrowException(Exception::Error(
+        String::New("QPixmapWrap: not available in headless mode")));
+
   QPixmapWrap* w = new QPixmapWrap(args[0]->IntegerValue(), 
       args[1]->IntegerValue());
   w->Wrap(args.This());
@@ -88,6 +134,8 @@ Handle<Value> QPixmapWrap::Width(const Arguments& args) {
   HandleScope scope;
 
   QPixmapWrap* w = ObjectWrap::Unwrap<QPixmapWrap>(args.This());
+  if (w->disposed_)
+    return ThrowDisposed();
   QPixmap* q = w->GetWrapped();
 
   return scope.Close(Number::New(q->width()));
@@ -97,20 +145,91 @@ Handle<Value> QPixmapWrap::Height(const Arguments& args) {
   HandleScope scope;
 
   QPixmapWrap* w = ObjectWrap::Unwrap<QPixmapWrap>(args.This());
+  if (w->disposed_)
+    return ThrowDisposed();
   QPixmap* q = w->GetWrapped();
 
   return scope.Close(Number::New(q->height()));
 }
 
+// Supported versions:
+//   save(QString fileName, QString format = null, int quality = -1)
 Handle<Value> QPixmapWrap::Save(const Arguments& args) {
   HandleScope scope;
 
   QPixmapWrap* w = ObjectWrap::Unwrap<QPixmapWrap>(args.This());
+  if (w->disposed_)
+    return ThrowDisposed();
   QPixmap* q = w->GetWrapped();
 
   QString file(qt_v8::ToQString(args[0]->ToString()));
+  QByteArray format;
+  if (args[1]->IsString())
+    format = qt_v8::ToQString(args[1]->ToString()).toLatin1();
+  int quality = args[2]->IsNumber() ? args[2]->IntegerValue() : -1;
+
+  return scope.Close(Boolean::New( 
+      q->save(file, format.isEmpty() ? 0 : format.constData(), quality) ));
+}
 
-  return scope.Close(Boolean::New( q->save(file) ));
+// Pixmaps may live in the window system; convert to a QImage to use the
+// asynchronous encode()/saveAsync()
+Handle<Value> QPixmapWrap::ToImage(const Arguments& args) {
+  HandleScope scope;
+
+  QPixmapWrap* w = ObjectWrap::Unwrap<QPixmapWrap>(args.This());
+  if (w->disposed_)
+    return ThrowDisposed();
+  QPixmap* q = w->GetWrapped();
+
+  return scope.Close(QImageWrap::NewInstance(q->toImage()));
+}
+
+//
+// QUIRK:
+// Scaled()
+// scaled(int width, int height, [Object options])
+// Synchronous form of QImage.scaled(), same options. Goes through a QImage
+//
+Handle<Value> QPixmapWrap::Scaled(const Arguments& args) {
+  HandleScope scope;
+
+  QPixmapWrap* w = ObjectWrap::Unwrap<QPixmapWrap>(args.This());
+  if (w->disposed_)
+    return ThrowDisposed();
+  QPixmap* q = w->GetWrapped();
+
+  if (!args[0]->IsNumber() || !args[1]->IsNumber())
+    return ThrowException(Exception::TypeError(
+        String::New("QPixmapWrap::Scaled: bad arguments")));
+
+  int width = args[0]->IntegerValue();
+  int height = args[1]->IntegerValue();
+  int filter = ImageScale::Bilinear;
+  int threads = QThread::idealThreadCount();
+
+  if (args[2]->IsObject()) {
+    Local<Object> o = args[2]->ToObject();
+    Local<Value> f = o->Get(String::NewSymbol("filter"));
+    Local<Value> t = o->Get(String::NewSymbol("threads"));
+    if (f->IsNumber())
+      filter = f->IntegerValue();
+    if (t->IsNumber())
+      threads = t->IntegerValue();
+  }
+
+  if (width <= 0 || height <= 0)
+    return ThrowException(Exception::RangeError(
+        String::New("QPixmapWrap::Scaled: size must be positive")));
+
+  if (filter < ImageScale::Box || filter > ImageScale::Lanczos3)
+    return ThrowException(Exception::RangeError(
+        String::New("QPixmapWrap::Scaled: unknown filter")));
+
+  QImage image = ImageScale::Scale(q->toImage(), width, height,
+                                   (ImageScale::Filter)filter, threads);
+
+  return scope.Close(NewInstance(QPixmap::fromImage(image)));
 }
 
 // Supports:
@@ -120,6 +239,8 @@ Handle<Value> QPixmapWrap::Fill(const Arguments& args) {
   HandleScope scope;
 
   QPixmapWrap* w = ObjectWrap::Unwrap<QPixmapWrap>(args.This());
+  if (w->disposed_)
+    return ThrowDisposed();
   QPixmap* q = w->GetWrapped();
 
   if (args[0]->IsObject()) {
@@ -135,3 +256,31 @@ Handle<Value> QPixmapWrap::Fill(const Arguments& args) {
 
   return scope.Close(Undefined());
 }
+
+//
+// QUIRK:
+// Dispose()
+// Not in Qt. Frees the pixmap now instead of at garbage collection, or
+// returns it to the pool for pixmaps from qt.SurfacePool. Any
+// later call on the pixmap throws; passed to other methods it acts as a
+// null pixmap. Calling dispose() again does nothing
+//
+Handle<Value> QPixmapWrap::Dispose(const Arguments& args) {
+  HandleScope scope;
+
+  QPixmapWrap* w = ObjectWrap::Unwrap<QPixmapWrap>(args.This());
+  if (w->disposed_)
+    return scope.Close(Undefined());
+
+  if (w->q_->paintingActive())
+    return ThrowException(Exception::Error(
+        String::New("QPixmapWrap::Dispose: pixmap is being painted on")));
+
+  if (w->pooled_)
+    SurfacePool::Release(*w->q_);
+  *w->q_ = QPixmap();
+  w->disposed_ = true;
+  w->UpdateMemory();
+
+  return scope.Close(Undefined());
+}
@@ -37,27 +37,47 @@
 class QPixmapWrap : public node::ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
+  static bool HasInstance(v8::Handle<v8::Value> value);
   static v8::Handle<v8::Value> NewInstance(QPixmap q);
   QPixmap* GetWrapped() const { return q_; };
   void SetWrapped(QPixmap q) { 
     if (q_) delete q_; 
     q_ = new QPixmap(q); 
+    UpdateMemory();
   };
 
+  // Pooled wrappers return their pixels to SurfacePool when freed
+  void SetPooled(bool pooled) { pooled_ = pooled; };
+
  private:
   QPixmapWrap(int width, int height);
   ~QPixmapWrap();
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> constructor_template;
   static v8::Handle<v8::Value> New(const v8::Arguments& args);
 
+  // Reports the size of q_'s pixels to V8
+  void UpdateMemory();
+
   // Wrapped methods
   static v8::Handle<v8::Value> Width(const v8::Arguments& args);
   static v8::Handle<v8::Value> Height(const v8::Arguments& args);
   static v8::Handle<v8::Value> Save(const v8::Arguments& args);
   static v8::Handle<v8::Value> Fill(const v8::Arguments& args);
+  static v8::Handle<v8::Value> ToImage(const v8::Arguments& args);
+  static v8::Handle<v8::Value> Scaled(const v8::Arguments& args);
+
+  // QUIRK
+  // Frees the pixels before garbage collection
+  static v8::Handle<v8::Value> Dispose(const v8::Arguments& args);
 
   // Wrapped object
   QPixmap* q_;
+
+  // Bytes reported to V8 as external memory
+  int memory_;
+  bool disposed_;
+  bool pooled_;
 };
 
 #endif
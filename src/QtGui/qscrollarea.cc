@@ -29,6 +29,7 @@
 
 #define BUILDING_NODE_EXTENSION
 #include <node.h>
+#include <QApplication>
 #include <QFrame>
 #include "../qt_v8.h"
 #include "../QtCore/qsize.h"
@@ -39,6 +40,7 @@
 using namespace v8;
 
 Persistent<Function> QScrollAreaWrap::constructor;
+Persistent<FunctionTemplate> QScrollAreaWrap::constructor_template;
 
 // Supported implementations:
 //   QScrollArea ( )
@@ -52,11 +54,7 @@ QScrollAreaWrap::QScrollAreaWrap(const v8::Arguments& args) {
   }
 
   // QScrollArea ( QWidget widget )
-
-  QString arg0_constructor = 
-      qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
-
-  if (arg0_constructor != "QWidget")
+  if (!QWidgetWrap::HasInstance(args[0]))
     ThrowException(Exception::TypeError(
       String::New("QScrollArea::constructor: bad argument")));
 
@@ -75,6 +73,7 @@ QScrollAreaWrap::~QScrollAreaWrap() {
 void QScrollAreaWrap::Initialize(Handle<Object> target) {
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
   tpl->SetClassName(String::NewSymbol("QScrollArea"));
   tpl->InstanceTemplate()->SetInternalFieldCount(1);  
 
@@ -126,9 +125,17 @@ void QScrollAreaWrap::Initialize(Handle<Object> target) {
   target->Set(String::NewSymbol("QScrollArea"), constructor);
 }
 
+bool QScrollAreaWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
 Handle<Value> QScrollAreaWrap::New(const Arguments& args) {
   HandleScope scope;
 
+  if (QApplication::type() == QApplication::Tty)
+    return ThrowException(Exception::Error(
+        String::New("QScrollAreaWrap: not available in headless mode")));
+
   QScrollAreaWrap* w = new QScrollAreaWrap(args);
   w->Wrap(args.This());
 
@@ -247,13 +254,7 @@ Handle<Value> QScrollAreaWrap::SetWidget(const Arguments& args) {
   QScrollAreaWrap* w = node::ObjectWrap::Unwrap<QScrollAreaWrap>(args.This());
   QScrollArea* q = w->GetWrapped();
 
-  QString arg0_constructor;
-  if (args[0]->IsObject()) {
-    arg0_constructor = 
-        qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
-  }
-
-  if (arg0_constructor != "QWidget")
+  if (!QWidgetWrap::HasInstance(args[0]))
     return ThrowException(Exception::TypeError(
       String::New("QScrollArea::SetWidget: bad argument")));
 
@@ -40,12 +40,14 @@
 class QScrollAreaWrap : public node::ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
+  static bool HasInstance(v8::Handle<v8::Value> value);
   QScrollArea* GetWrapped() const { return q_; };
 
  private:
   QScrollAreaWrap(const v8::Arguments& args);
   ~QScrollAreaWrap();
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> constructor_template;
   static v8::Handle<v8::Value> New(const v8::Arguments& args);
 
   // Generic QWidget methods
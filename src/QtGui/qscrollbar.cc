@@ -29,11 +29,13 @@
 
 #define BUILDING_NODE_EXTENSION
 #include <node.h>
+#include <QApplication>
 #include "qscrollbar.h"
 
 using namespace v8;
 
 Persistent<Function> QScrollBarWrap::constructor;
+Persistent<FunctionTemplate> QScrollBarWrap::constructor_template;
 
 QScrollBarWrap::QScrollBarWrap(const Arguments& args) : q_(NULL) {
 }
@@ -46,6 +48,7 @@ QScrollBarWrap::~QScrollBarWrap() {
 void QScrollBarWrap::Initialize(Handle<Object> target) {
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
   tpl->SetClassName(String::NewSymbol("QScrollBar"));
   tpl->InstanceTemplate()->SetInternalFieldCount(1);  
 
@@ -59,9 +62,17 @@ void QScrollBarWrap::Initialize(Handle<Object> target) {
   target->Set(String::NewSymbol("QScrollBar"), constructor);
 }
 
+bool QScrollBarWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
 Handle<Value> QScrollBarWrap::New(const Arguments& args) {
   HandleScope scope;
 
+  if (QApplication::type() == QApplication::Tty)
+    return ThrowException(Exception::Error(
+        String::New("QScrollBarWrap: not available in headless mode")));
+
   QScrollBarWrap* w = new QScrollBarWrap(args);
   w->Wrap(args.This());
 
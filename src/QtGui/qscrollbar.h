@@ -37,6 +37,7 @@
 class QScrollBarWrap : public node::ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
+  static bool HasInstance(v8::Handle<v8::Value> value);
   QScrollBar* GetWrapped() const { return q_; };
   void SetWrapped(QScrollBar *q) { 
     // Since q_ is never new'd (it's always a pointer to an existing scrollbar), 
@@ -49,6 +50,7 @@ class QScrollBarWrap : public node::ObjectWrap {
   QScrollBarWrap(const v8::Arguments& args);
   ~QScrollBarWrap();
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> constructor_template;
   static v8::Handle<v8::Value> New(const v8::Arguments& args);
 
   // Wrapped methods
@@ -35,6 +35,7 @@
 using namespace v8;
 
 Persistent<Function> QSoundWrap::constructor;
+Persistent<FunctionTemplate> QSoundWrap::constructor_template;
 
 // Supported implementations:
 //   QSound ( QString filename )
@@ -49,6 +50,7 @@ QSoundWrap::~QSoundWrap() {
 void QSoundWrap::Initialize(Handle<Object> target) {
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
   tpl->SetClassName(String::NewSymbol("QSound"));
   tpl->InstanceTemplate()->SetInternalFieldCount(1);  
 
@@ -64,6 +66,10 @@ void QSoundWrap::Initialize(Handle<Object> target) {
   target->Set(String::NewSymbol("QSound"), constructor);
 }
 
+bool QSoundWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
 Handle<Value> QSoundWrap::New(const Arguments& args) {
   HandleScope scope;
 
@@ -37,12 +37,14 @@
 class QSoundWrap : public node::ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
+  static bool HasInstance(v8::Handle<v8::Value> value);
   QSound* GetWrapped() const { return q_; };
 
  private:
   QSoundWrap(const v8::Arguments& args);
   ~QSoundWrap();
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> constructor_template;
   static v8::Handle<v8::Value> New(const v8::Arguments& args);
 
   // Wrapped methods
@@ -29,21 +29,37 @@
 
 #define BUILDING_NODE_EXTENSION
 #include <node.h>
+#include <stdlib.h>
+#include <string.h>
+#include <QApplication>
+#include <QFontDatabase>
+#include <QPainter>
 #include "../qt_v8.h"
 #include "../QtCore/qsize.h"
 #include "qwidget.h"
 #include "qmouseevent.h"
 #include "qkeyevent.h"
+#include "frameclock.h"
+#include "qpainter.h"
+#include "renderthread.h"
 
 using namespace v8;
 
 Persistent<Function> QWidgetWrap::constructor;
+Persistent<FunctionTemplate> QWidgetWrap::constructor_template;
 
 //
 // QWidgetImpl()
 //
 
-QWidgetImpl::QWidgetImpl(QWidgetImpl* parent) : QWidget(parent) {
+// Default number of buffered samples for coalesced mouse moves
+static const int kDefaultMotionCapacity = 256;
+
+QWidgetImpl::QWidgetImpl(QWidgetImpl* parent) : QWidget(parent),
+    reuseEventObjects_(false), renderThread_(NULL), inPaintEvent_(false),
+    presenting_(false),
+    mouseEventInUse_(false), keyEventInUse_(false),
+    motionCapacity_(0), motionStart_(0), motionCount_(0), motionIdle_(NULL) {
   // Initialize callbacks as boolean values so we can test if the callback
   // has been set via ->IsFunction() below
   paintEventCallback_ = Persistent<Boolean>::New(Boolean::New(false));
@@ -52,115 +68,282 @@ QWidgetImpl::QWidgetImpl(QWidgetImpl* parent) : QWidget(parent) {
   mouseMoveCallback_ = Persistent<Boolean>::New(Boolean::New(false));
   keyPressCallback_ = Persistent<Boolean>::New(Boolean::New(false));
   keyReleaseCallback_ = Persistent<Boolean>::New(Boolean::New(false));
+  coalescedMouseMoveCallback_ = Persistent<Boolean>::New(Boolean::New(false));
 }
 
 QWidgetImpl::~QWidgetImpl() {
+  delete renderThread_;
+
   paintEventCallback_.Dispose();
   mousePressCallback_.Dispose();
   mouseReleaseCallback_.Dispose();
   mouseMoveCallback_.Dispose();
   keyPressCallback_.Dispose();
   keyReleaseCallback_.Dispose();
+  coalescedMouseMoveCallback_.Dispose();
+  mouseEventObject_.Dispose();
+  keyEventObject_.Dispose();
+
+  if (motionIdle_) {
+    uv_idle_stop(motionIdle_);
+    uv_close(reinterpret_cast<uv_handle_t*>(motionIdle_), OnCloseMotionIdle);
+  }
 }
 
 void QWidgetImpl::paintEvent(QPaintEvent* e) {
   HandleScope scope;
+
+  if (renderThread_) {
+    QPainter painter(this);
+    painter.drawImage(0, 0, renderThread_->Frame());
+    painter.end();
+
+    // Only other repaints (expose, resize, update()) ask JS for a frame
+    if (presenting_)
+      return;
+  }
   
   if (!paintEventCallback_->IsFunction())
     return;
 
-  const unsigned argc = 0;
-  Handle<Value> argv[1] = {};
+  // Exposed region as a flat list of rects: x, y, width, height, ...
+  QVector<QRect> rects = e->region().rects();
+  Local<Object> region = qt_v8::NewTypedArray("Int32Array", rects.size() * 4);
+  int32_t* data = static_cast<int32_t*>(
+      region->GetIndexedPropertiesExternalArrayData());
+  for (int i = 0; i < rects.size(); i++) {
+    data[i*4] = rects[i].x();
+    data[i*4 + 1] = rects[i].y();
+    data[i*4 + 2] = rects[i].width();
+    data[i*4 + 3] = rects[i].height();
+  }
+
+  const unsigned argc = 1;
+  Handle<Value> argv[argc] = {
+    region
+  };
   Handle<Function> cb = Persistent<Function>::Cast(paintEventCallback_);
-    
+
+  // Painters begun on this widget from the callback clip to the region
+  bool wasInPaintEvent = inPaintEvent_;
+  QRegion previousRegion = paintRegion_;
+  inPaintEvent_ = true;
+  paintRegion_ = e->region();
+
   cb->Call(Context::GetCurrent()->Global(), argc, argv);
+
+  inPaintEvent_ = wasInPaintEvent;
+  paintRegion_ = previousRegion;
+}
+
+void QWidgetImpl::PresentFrame() {
+  presenting_ = true;
+  repaint();
+  presenting_ = false;
 }
 
 void QWidgetImpl::mousePressEvent(QMouseEvent* e) {
   e->ignore(); // ensures event bubbles up
 
-  HandleScope scope;
-  
-  if (!mousePressCallback_->IsFunction())
-    return;
+  // Deliver buffered moves first so JS sees events in order
+  FlushMotionSamples();
 
-  const unsigned argc = 1;
-  Handle<Value> argv[argc] = {
-    QMouseEventWrap::NewInstance(*e)
-  };
-  Handle<Function> cb = Persistent<Function>::Cast(mousePressCallback_);
-    
-  cb->Call(Context::GetCurrent()->Global(), argc, argv);
+  DispatchMouseEvent(mousePressCallback_, e);
 }
 
 void QWidgetImpl::mouseReleaseEvent(QMouseEvent* e) {
   e->ignore(); // ensures event bubbles up
 
-  HandleScope scope;
-  
-  if (!mouseReleaseCallback_->IsFunction())
-    return;
+  FlushMotionSamples();
 
-  const unsigned argc = 1;
-  Handle<Value> argv[argc] = {
-    QMouseEventWrap::NewInstance(*e)
-  };
-  Handle<Function> cb = Persistent<Function>::Cast(mouseReleaseCallback_);
-    
-  cb->Call(Context::GetCurrent()->Global(), argc, argv);
+  DispatchMouseEvent(mouseReleaseCallback_, e);
 }
 
 void QWidgetImpl::mouseMoveEvent(QMouseEvent* e) {
   e->ignore(); // ensures event bubbles up
 
+  if (coalescedMouseMoveCallback_->IsFunction()) {
+    // Append to the ring, overwriting the oldest sample when full
+    int index;
+    if (motionCount_ < motionCapacity_) {
+      index = (motionStart_ + motionCount_) % motionCapacity_;
+      motionCount_++;
+    } else {
+      index = motionStart_;
+      motionStart_ = (motionStart_ + 1) % motionCapacity_;
+    }
+
+    double* sample = motionSamples_.data() + index * kMotionSampleSize;
+    sample[0] = e->x();
+    sample[1] = e->y();
+    sample[2] = e->buttons();
+    sample[3] = e->modifiers();
+    sample[4] = uv_hrtime() / 1e6; // ms
+
+    if (!motionIdle_) {
+      motionIdle_ = static_cast<uv_idle_t*>(malloc(sizeof(uv_idle_t)));
+      uv_idle_init(uv_default_loop(), motionIdle_);
+      motionIdle_->data = this;
+    }
+    uv_idle_start(motionIdle_, OnMotionIdle);
+    return;
+  }
+
+  DispatchMouseEvent(mouseMoveCallback_, e);
+}
+
+void QWidgetImpl::keyPressEvent(QKeyEvent* e) {
+  e->ignore(); // ensures event bubbles up
+
+  DispatchKeyEvent(keyPressCallback_, e);
+}
+
+void QWidgetImpl::keyReleaseEvent(QKeyEvent* e) {
+  e->ignore(); // ensures event bubbles up
+
+  DispatchKeyEvent(keyReleaseCallback_, e);
+}
+
+void QWidgetImpl::DispatchMouseEvent(Handle<Value> callback, QMouseEvent* e) {
   HandleScope scope;
-  
-  if (!mouseMoveCallback_->IsFunction())
+
+  if (!callback->IsFunction())
     return;
 
+  // Fall back to a fresh object if the pooled one is still in use by an
+  // outer callback (e.g. processEvents() called from a handler)
+  bool reuse = reuseEventObjects_ && !mouseEventInUse_;
+
+  Handle<Value> event;
+  if (reuse) {
+    if (mouseEventObject_.IsEmpty()) {
+      mouseEventObject_ = Persistent<Object>::New(
+          QMouseEventWrap::NewInstance(*e)->ToObject());
+    } else {
+      node::ObjectWrap::Unwrap<QMouseEventWrap>(mouseEventObject_)->Refill(*e);
+    }
+    event = mouseEventObject_;
+    mouseEventInUse_ = true;
+  } else {
+    event = QMouseEventWrap::NewInstance(*e);
+  }
+
   const unsigned argc = 1;
   Handle<Value> argv[argc] = {
-    QMouseEventWrap::NewInstance(*e)
+    event
   };
-  Handle<Function> cb = Persistent<Function>::Cast(mouseMoveCallback_);
-    
+  Handle<Function> cb = Handle<Function>::Cast(callback);
+
   cb->Call(Context::GetCurrent()->Global(), argc, argv);
-}
 
-void QWidgetImpl::keyPressEvent(QKeyEvent* e) {
-  e->ignore(); // ensures event bubbles up
+  if (reuse) {
+    node::ObjectWrap::Unwrap<QMouseEventWrap>(mouseEventObject_)->Invalidate();
+    mouseEventInUse_ = false;
+  }
+}
 
+void QWidgetImpl::DispatchKeyEvent(Handle<Value> callback, QKeyEvent* e) {
   HandleScope scope;
-  
-  if (!keyPressCallback_->IsFunction())
+
+  if (!callback->IsFunction())
     return;
 
+  bool reuse = reuseEventObjects_ && !keyEventInUse_;
+
+  Handle<Value> event;
+  if (reuse) {
+    if (keyEventObject_.IsEmpty()) {
+      keyEventObject_ = Persistent<Object>::New(
+          QKeyEventWrap::NewInstance(*e)->ToObject());
+    } else {
+      node::ObjectWrap::Unwrap<QKeyEventWrap>(keyEventObject_)->Refill(*e);
+    }
+    event = keyEventObject_;
+    keyEventInUse_ = true;
+  } else {
+    event = QKeyEventWrap::NewInstance(*e);
+  }
+
   const unsigned argc = 1;
   Handle<Value> argv[argc] = {
-    QKeyEventWrap::NewInstance(*e)
+    event
   };
-  Handle<Function> cb = Persistent<Function>::Cast(keyPressCallback_);
-    
+  Handle<Function> cb = Handle<Function>::Cast(callback);
+
   cb->Call(Context::GetCurrent()->Global(), argc, argv);
+
+  if (reuse) {
+    node::ObjectWrap::Unwrap<QKeyEventWrap>(keyEventObject_)->Invalidate();
+    keyEventInUse_ = false;
+  }
 }
 
-void QWidgetImpl::keyReleaseEvent(QKeyEvent* e) {
-  e->ignore(); // ensures event bubbles up
+void QWidgetImpl::SetMotionCapacity(int capacity) {
+  FlushMotionSamples();
+
+  motionCapacity_ = capacity;
+  motionSamples_.resize(capacity * kMotionSampleSize);
+  motionStart_ = 0;
+  motionCount_ = 0;
+}
+
+//
+// FlushMotionSamples()
+// Calls the coalesced mouse move callback with all buffered samples, oldest
+// first
+//
+void QWidgetImpl::FlushMotionSamples() {
+  if (motionIdle_)
+    uv_idle_stop(motionIdle_);
+
+  if (motionCount_ == 0)
+    return;
 
   HandleScope scope;
-  
-  if (!keyReleaseCallback_->IsFunction())
+
+  int count = motionCount_;
+  Local<Object> samples = qt_v8::NewTypedArray("Float64Array",
+      count * kMotionSampleSize);
+  double* data = static_cast<double*>(
+      samples->GetIndexedPropertiesExternalArrayData());
+
+  // Unroll the ring
+  int head = qMin(count, motionCapacity_ - motionStart_);
+  memcpy(data, motionSamples_.constData() + motionStart_ * kMotionSampleSize,
+         head * kMotionSampleSize * sizeof(double));
+  memcpy(data + head * kMotionSampleSize, motionSamples_.constData(),
+         (count - head) * kMotionSampleSize * sizeof(double));
+
+  motionStart_ = 0;
+  motionCount_ = 0;
+
+  if (!coalescedMouseMoveCallback_->IsFunction())
     return;
 
-  const unsigned argc = 1;
+  const unsigned argc = 2;
   Handle<Value> argv[argc] = {
-    QKeyEventWrap::NewInstance(*e)
+    samples,
+    Integer::New(count)
   };
-  Handle<Function> cb = Persistent<Function>::Cast(keyReleaseCallback_);
-    
+  Handle<Function> cb = Persistent<Function>::Cast(coalescedMouseMoveCallback_);
+
   cb->Call(Context::GetCurrent()->Global(), argc, argv);
 }
 
+void QWidgetImpl::OnMotionIdle(uv_idle_t* handle, int status) {
+  HandleScope scope;
+  TryCatch try_catch;
+
+  static_cast<QWidgetImpl*>(handle->data)->FlushMotionSamples();
+
+  if (try_catch.HasCaught())
+    node::FatalException(try_catch);
+}
+
+void QWidgetImpl::OnCloseMotionIdle(uv_handle_t* handle) {
+  free(handle);
+}
+
 //
 // QWidgetWrap()
 //
@@ -176,6 +359,7 @@ QWidgetWrap::~QWidgetWrap() {
 void QWidgetWrap::Initialize(Handle<Object> target) {
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
   tpl->SetClassName(String::NewSymbol("QWidget"));
   tpl->InstanceTemplate()->SetInternalFieldCount(1);  
 
@@ -200,6 +384,10 @@ void QWidgetWrap::Initialize(Handle<Object> target) {
       FunctionTemplate::New(SetObjectName)->GetFunction());
   tpl->PrototypeTemplate()->Set(String::NewSymbol("update"),
       FunctionTemplate::New(Update)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("repaint"),
+      FunctionTemplate::New(Repaint)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("requestFrame"),
+      FunctionTemplate::New(RequestFrame)->GetFunction());
   tpl->PrototypeTemplate()->Set(String::NewSymbol("hasMouseTracking"),
       FunctionTemplate::New(HasMouseTracking)->GetFunction());
   tpl->PrototypeTemplate()->Set(String::NewSymbol("setMouseTracking"),
@@ -212,6 +400,16 @@ void QWidgetWrap::Initialize(Handle<Object> target) {
       FunctionTemplate::New(X)->GetFunction());
   tpl->PrototypeTemplate()->Set(String::NewSymbol("y"),
       FunctionTemplate::New(Y)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setReuseEventObjects"),
+      FunctionTemplate::New(SetReuseEventObjects)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("reuseEventObjects"),
+      FunctionTemplate::New(ReuseEventObjects)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setRenderThread"),
+      FunctionTemplate::New(SetRenderThread)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("renderThread"),
+      FunctionTemplate::New(RenderThreadFrames)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("submitFrame"),
+      FunctionTemplate::New(SubmitFrame)->GetFunction());
 
   // Events
   tpl->PrototypeTemplate()->Set(String::NewSymbol("paintEvent"),
@@ -226,13 +424,24 @@ void QWidgetWrap::Initialize(Handle<Object> target) {
       FunctionTemplate::New(KeyPressEvent)->GetFunction());
   tpl->PrototypeTemplate()->Set(String::NewSymbol("keyReleaseEvent"),
       FunctionTemplate::New(KeyReleaseEvent)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("coalescedMouseMoveEvent"),
+      FunctionTemplate::New(CoalescedMouseMoveEvent)->GetFunction());
 
   constructor = Persistent<Function>::New(tpl->GetFunction());
   target->Set(String::NewSymbol("QWidget"), constructor);
 }
 
+bool QWidgetWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
 Handle<Value> QWidgetWrap::New(const Arguments& args) {
   HandleScope scope;
+
+  if (QApplication::type() == QApplication::Tty)
+    return ThrowException(Exception::Error(
+        String::New("QWidgetWrap: not available in headless mode")));
+
   QWidgetImpl* q_parent = 0;
 
   if (args.Length() > 0) {
@@ -443,13 +652,121 @@ Handle<Value> QWidgetWrap::KeyReleaseEvent(const Arguments& args) {
   return scope.Close(Undefined());
 }
 
+//
+// QUIRK:
+// CoalescedMouseMoveEvent()
+// Binds a callback receiving all mouse moves since the last event loop turn,
+// instead of one QMouseEvent per move:
+//   callback(Float64Array samples, int count)
+// Each sample is 5 doubles: x, y, buttons, modifiers, timestamp (ms).
+// Up to 'capacity' (default 256) samples are kept, dropping the oldest.
+// While bound, mouseMoveEvent() callbacks are not called. Pass a non-function
+// to unbind
+//
+Handle<Value> QWidgetWrap::CoalescedMouseMoveEvent(const Arguments& args) {
+  HandleScope scope;
+
+  QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
+  QWidgetImpl* q = w->GetWrapped();
+
+  int capacity = args[1]->IsNumber() ? args[1]->IntegerValue()
+                                     : kDefaultMotionCapacity;
+  if (args[0]->IsFunction() && capacity < 1)
+    return ThrowException(Exception::RangeError(
+        String::New("QWidgetWrap::CoalescedMouseMoveEvent: bad capacity")));
+
+  // Deliver what was buffered for the previous callback
+  q->FlushMotionSamples();
+
+  q->coalescedMouseMoveCallback_.Dispose();
+
+  if (!args[0]->IsFunction()) {
+    q->coalescedMouseMoveCallback_ = Persistent<Boolean>::New(
+        Boolean::New(false));
+    q->SetMotionCapacity(0);
+    return scope.Close(Undefined());
+  }
+
+  q->coalescedMouseMoveCallback_ = Persistent<Function>::New(
+      Local<Function>::Cast(args[0]));
+
+  q->SetMotionCapacity(capacity);
+
+  return scope.Close(Undefined());
+}
+
+// Supported versions:
+//   update()
+//   update(int x, int y, int w, int h)
+//
+// QUIRK:
+// Here: while the frame clock is active (see QApplication::requestFrame()),
+//   the repaint is deferred to the next frame and merged with other
+//   update() calls
+// Qt: update() schedules a repaint from the event loop
+//
 Handle<Value> QWidgetWrap::Update(const Arguments& args) {
   HandleScope scope;
 
   QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
   QWidgetImpl* q = w->GetWrapped();
 
-  q->update();
+  bool partial = args.Length() >= 4;
+  QRect rect;
+  if (partial) {
+    rect = QRect(args[0]->IntegerValue(), args[1]->IntegerValue(),
+                 args[2]->IntegerValue(), args[3]->IntegerValue());
+    if (rect.isEmpty())
+      return scope.Close(Undefined());
+  }
+
+  FrameClock* clock = FrameClock::Instance();
+  if (clock->IsActive())
+    clock->ScheduleRepaint(q, partial ? QRegion(rect) : QRegion());
+  else if (partial)
+    q->update(rect);
+  else
+    q->update();
+
+  return scope.Close(Undefined());
+}
+
+// Supported versions:
+//   repaint()
+//   repaint(int x, int y, int w, int h)
+Handle<Value> QWidgetWrap::Repaint(const Arguments& args) {
+  HandleScope scope;
+
+  QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
+  QWidgetImpl* q = w->GetWrapped();
+
+  if (args.Length() >= 4) {
+    q->repaint(args[0]->IntegerValue(), args[1]->IntegerValue(),
+               args[2]->IntegerValue(), args[3]->IntegerValue());
+  } else {
+    q->repaint();
+  }
+
+  return scope.Close(Undefined());
+}
+
+//
+// QUIRK:
+// RequestFrame()
+// Not in Qt. Like QApplication::requestFrame(), and repaints the widget in
+// the same frame once all callbacks have run
+//
+Handle<Value> QWidgetWrap::RequestFrame(const Arguments& args) {
+  HandleScope scope;
+
+  QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
+  QWidgetImpl* q = w->GetWrapped();
+
+  if (!args[0]->IsFunction())
+    return ThrowException(Exception::TypeError(
+        String::New("QWidgetWrap::RequestFrame: argument not a function")));
+
+  FrameClock::Instance()->RequestFrame(Local<Function>::Cast(args[0]), q);
 
   return scope.Close(Undefined());
 }
@@ -515,3 +832,120 @@ Handle<Value> QWidgetWrap::Y(const Arguments& args) {
 
   return scope.Close(Integer::New(q->y()));
 }
+
+//
+// QUIRK:
+// SetReuseEventObjects()
+// When true, mouse and key callbacks of this widget receive the same event
+// object every time, refilled in place. The object is only valid during the
+// callback; its methods throw afterwards. Default is false (new object per
+// event), for code that keeps event objects around
+//
+Handle<Value> QWidgetWrap::SetReuseEventObjects(const Arguments& args) {
+  HandleScope scope;
+
+  QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
+  QWidgetImpl* q = w->GetWrapped();
+
+  q->reuseEventObjects_ = args[0]->BooleanValue();
+
+  return scope.Close(Undefined());
+}
+
+Handle<Value> QWidgetWrap::ReuseEventObjects(const Arguments& args) {
+  HandleScope scope;
+
+  QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
+  QWidgetImpl* q = w->GetWrapped();
+
+  return scope.Close(Boolean::New(q->reuseEventObjects_));
+}
+
+//
+// QUIRK:
+// SetRenderThread()
+// setRenderThread(int framesInFlight)
+// Not in Qt. With framesInFlight > 0, frames submitted with submitFrame()
+// are rasterized on a dedicated thread, up to framesInFlight at a time,
+// and the widget's paintEvent() blits the newest finished one. The paint
+// callback is still called for repaints not caused by a new frame (expose,
+// resize, update()), and is expected to record and submit a frame rather
+// than paint. 0 stops the thread, dropping frames in flight
+//
+Handle<Value> QWidgetWrap::SetRenderThread(const Arguments& args) {
+  HandleScope scope;
+
+  QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
+  QWidgetImpl* q = w->GetWrapped();
+
+  int frames = args[0]->IntegerValue();
+  if (frames < 0)
+    return ThrowException(Exception::RangeError(
+        String::New("QWidgetWrap::SetRenderThread: bad frame count")));
+
+  if (q->renderThread_ && q->renderThread_->Capacity() == frames)
+    return scope.Close(Undefined());
+
+  delete q->renderThread_;
+  q->renderThread_ = frames > 0 ? new RenderThread(q, frames) : NULL;
+
+  return scope.Close(Undefined());
+}
+
+Handle<Value> QWidgetWrap::RenderThreadFrames(const Arguments& args) {
+  HandleScope scope;
+
+  QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
+  QWidgetImpl* q = w->GetWrapped();
+
+  return scope.Close(Integer::New(
+      q->renderThread_ ? q->renderThread_->Capacity() : 0));
+}
+
+//
+// QUIRK:
+// SubmitFrame()
+// submitFrame(PaintCommandBuffer commands, [Function cb])
+// Not in Qt. Queues a frame of commands, at the widget's current size, to
+// the render thread (see setRenderThread()). Returns false, dropping the
+// frame, if framesInFlight frames are already queued. cb() is called once
+// the frame, or a newer one replacing it, is on screen. Frames with text
+// throw where Qt can't render fonts outside the GUI thread
+//
+Handle<Value> QWidgetWrap::SubmitFrame(const Arguments& args) {
+  HandleScope scope;
+
+  QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
+  QWidgetImpl* q = w->GetWrapped();
+
+  if (!q->renderThread_)
+    return ThrowException(Exception::Error(
+        String::New("QWidgetWrap::SubmitFrame: no render thread")));
+
+  const double* commands;
+  int count;
+  PaintCommands::Resources resources;
+  Local<Value> none = Local<Value>::New(Undefined());
+  if (!QPainterWrap::ReadCommands("QWidgetWrap::SubmitFrame", args[0],
+                                  none, none, none, &commands, &count,
+                                  &resources))
+    return scope.Close(Undefined());
+
+  // Errors can't be reported from the render thread, check now
+  QString error;
+  if (!PaintCommands::Validate(commands, count, resources, &error))
+    return ThrowException(Exception::RangeError(qt_v8::FromQString(
+        "QWidgetWrap::SubmitFrame: " + error)));
+
+  // Strings are only referenced by text commands
+  if (!resources.strings.isEmpty() &&
+      !QFontDatabase::supportsThreadedFontRendering())
+    return ThrowException(Exception::Error(String::New(
+        "QWidgetWrap::SubmitFrame: text can't be rendered off the GUI "
+        "thread on this platform")));
+
+  PaintCommands::ConvertPixmaps(&resources);
+
+  return scope.Close(Boolean::New(q->renderThread_->Submit(
+      commands, count, resources, q->size(), args[1])));
+}
@@ -32,7 +32,12 @@
 
 #define BUILDING_NODE_EXTENSION
 #include <node.h>
+#include <uv.h>
 #include <QWidget>
+#include <QVector>
+#include <QRegion>
+
+class RenderThread;
 
 //
 // QWidgetImpl()
@@ -48,8 +53,52 @@ class QWidgetImpl : public QWidget {
   v8::Persistent<v8::Value> mouseMoveCallback_;
   v8::Persistent<v8::Value> keyPressCallback_;
   v8::Persistent<v8::Value> keyReleaseCallback_;
+  v8::Persistent<v8::Value> coalescedMouseMoveCallback_;
+
+  // Coalesced mouse moves: samples are buffered in a ring of
+  // kMotionSampleSize doubles each (x, y, buttons, modifiers, timestamp)
+  // and delivered once per event loop turn
+  static const int kMotionSampleSize = 5;
+  void SetMotionCapacity(int capacity);
+  void FlushMotionSamples();
+
+  // Reusable event objects: when enabled, one QMouseEvent and one QKeyEvent
+  // object per widget is refilled for each callback and invalidated after it
+  // returns, instead of allocating a new object per event
+  bool reuseEventObjects_;
+
+  // Frames rasterized off the main thread (see RenderThread). While set,
+  // paintEvent() blits its last frame. PresentFrame() repaints with a new
+  // frame without calling the paint callback
+  RenderThread* renderThread_;
+  void PresentFrame();
+
+  // Region being repainted, valid while inside paintEvent()
+  bool InPaintEvent() const { return inPaintEvent_; };
+  const QRegion& PaintRegion() const { return paintRegion_; };
 
  private:
+  bool inPaintEvent_;
+  QRegion paintRegion_;
+  bool presenting_;
+
+  void DispatchMouseEvent(v8::Handle<v8::Value> callback, QMouseEvent* e);
+  void DispatchKeyEvent(v8::Handle<v8::Value> callback, QKeyEvent* e);
+
+  v8::Persistent<v8::Object> mouseEventObject_;
+  v8::Persistent<v8::Object> keyEventObject_;
+  bool mouseEventInUse_;
+  bool keyEventInUse_;
+
+  static void OnMotionIdle(uv_idle_t* handle, int status);
+  static void OnCloseMotionIdle(uv_handle_t* handle);
+
+  QVector<double> motionSamples_;
+  int motionCapacity_;
+  int motionStart_;
+  int motionCount_;
+  uv_idle_t* motionIdle_;
+
   void paintEvent(QPaintEvent* e);
   void mousePressEvent(QMouseEvent* e);
   void mouseReleaseEvent(QMouseEvent* e);
@@ -64,12 +113,14 @@ class QWidgetImpl : public QWidget {
 class QWidgetWrap : public node::ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
+  static bool HasInstance(v8::Handle<v8::Value> value);
   QWidgetImpl* GetWrapped() const { return q_; };
 
  private:
   QWidgetWrap(QWidgetImpl* parent);
   ~QWidgetWrap();
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> constructor_template;
   static v8::Handle<v8::Value> New(const v8::Arguments& args);
 
   // Wrapped methods
@@ -83,12 +134,22 @@ class QWidgetWrap : public node::ObjectWrap {
   static v8::Handle<v8::Value> SetObjectName(const v8::Arguments& args);
   static v8::Handle<v8::Value> Parent(const v8::Arguments& args);
   static v8::Handle<v8::Value> Update(const v8::Arguments& args);
+  static v8::Handle<v8::Value> Repaint(const v8::Arguments& args);
+  static v8::Handle<v8::Value> RequestFrame(const v8::Arguments& args);
   static v8::Handle<v8::Value> SetMouseTracking(const v8::Arguments& args);
   static v8::Handle<v8::Value> HasMouseTracking(const v8::Arguments& args);
   static v8::Handle<v8::Value> SetFocusPolicy(const v8::Arguments& args);
   static v8::Handle<v8::Value> Move(const v8::Arguments& args);
   static v8::Handle<v8::Value> X(const v8::Arguments& args);
   static v8::Handle<v8::Value> Y(const v8::Arguments& args);
+  static v8::Handle<v8::Value> SetReuseEventObjects(const v8::Arguments& args);
+  static v8::Handle<v8::Value> ReuseEventObjects(const v8::Arguments& args);
+
+  // QUIRK
+  // Rasterization on a render thread
+  static v8::Handle<v8::Value> SetRenderThread(const v8::Arguments& args);
+  static v8::Handle<v8::Value> RenderThreadFrames(const v8::Arguments& args);
+  static v8::Handle<v8::Value> SubmitFrame(const v8::Arguments& args);
 
   // QUIRK
   // Event binding. These functions bind implemented event handlers above
@@ -100,6 +161,8 @@ class QWidgetWrap : public node::ObjectWrap {
   static v8::Handle<v8::Value> MouseMoveEvent(const v8::Arguments& args);
   static v8::Handle<v8::Value> KeyPressEvent(const v8::Arguments& args);
   static v8::Handle<v8::Value> KeyReleaseEvent(const v8::Arguments& args);
+  static v8::Handle<v8::Value> CoalescedMouseMoveEvent(
+      const v8::Arguments& args);
 
   // Wrapped object
   QWidgetImpl* q_;
@@ -0,0 +1,392 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "renderbatch.h"
+#include <QAtomicInt>
+#include <QBuffer>
+#include <QFontDatabase>
+#include <QImageWriter>
+#include <QPaintEngine>
+#include <QPainter>
+#include <QPicture>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include "../qt_v8.h"
+#include "paintcommands.h"
+#include "qpainter.h"
+#include "qpicture.h"
+
+using namespace v8;
+
+namespace RenderBatch {
+
+//
+// Job
+// One image of the batch. Paints commands, or picture if it isn't null.
+// image is set if the job was painted on the main thread already
+//
+struct Job {
+  QSize size;
+  QRgb background;
+  QVector<double> commands;
+  PaintCommands::Resources resources;
+  QPicture picture;
+  QImage image;
+  QByteArray format;
+  int quality;
+
+  // Output
+  QByteArray data;
+  QString error;
+};
+
+//
+// Batch
+// State of a renderBatch() call. Jobs are claimed through next by up to
+// threads threads
+//
+struct Batch {
+  uv_work_t req;
+
+  QVector<Job> jobs;
+  int threads;
+  QAtomicInt next;
+  Job* data; // jobs.data(), taken before workers start
+
+  Persistent<Object> input;
+  Persistent<Function> callback;
+};
+
+// Returns a null image if out of memory
+static QImage Paint(Job* job) {
+  QImage image(job->size, QImage::Format_ARGB32_Premultiplied);
+  if (image.isNull())
+    return image;
+
+  // background is not premultiplied
+  image.fill(QColor::fromRgba(job->background));
+
+  QPainter painter(&image);
+  if (!job->picture.isNull()) {
+    painter.drawPicture(0, 0, job->picture);
+  } else {
+    PaintCommands::Execute(&painter, job->commands.constData(),
+                           job->commands.size(), job->resources,
+                           &job->error);
+  }
+  painter.end();
+
+  return image;
+}
+
+static void RenderJob(Job* job) {
+  QImage image = job->image.isNull() ? Paint(job) : job->image;
+  if (image.isNull()) {
+    job->error = "out of memory";
+    return;
+  }
+
+  QBuffer device(&job->data);
+  device.open(QIODevice::WriteOnly);
+  QImageWriter writer(&device, job->format);
+  if (job->quality >= 0)
+    writer.setQuality(job->quality);
+  if (!writer.write(image))
+    job->error = writer.errorString();
+}
+
+static void RenderJobs(Batch* batch) {
+  int index;
+  while ((index = batch->next.fetchAndAddOrdered(1)) < batch->jobs.size())
+    RenderJob(batch->data + index);
+}
+
+//
+// JobWorker
+// Renders jobs on the thread pool until none are left
+//
+class JobWorker : public QRunnable {
+ public:
+  JobWorker(Batch* batch, QSemaphore* done) : batch_(batch), done_(done) {}
+
+  void run() {
+    RenderJobs(batch_);
+    done_->release();
+  }
+
+ private:
+  Batch* batch_;
+  QSemaphore* done_;
+};
+
+// Runs on a threadpool thread: no V8 here. The libuv thread renders too
+static void OnWork(uv_work_t* req) {
+  Batch* batch = static_cast<Batch*>(req->data);
+
+  int threads = qBound(1, batch->threads, qMax(1, batch->jobs.size()));
+  batch->data = batch->jobs.data();
+
+  QSemaphore done;
+  for (int i = 1; i < threads; i++)
+    QThreadPool::globalInstance()->start(new JobWorker(batch, &done));
+  RenderJobs(batch);
+  done.acquire(threads - 1);
+}
+
+static void OnDone(uv_work_t* req) {
+  HandleScope scope;
+  TryCatch try_catch;
+
+  Batch* batch = static_cast<Batch*>(req->data);
+
+  Local<Array> results = Array::New(batch->jobs.size());
+  Handle<Value> error = Null();
+  for (int i = 0; i < batch->jobs.size(); i++) {
+    Job& job = batch->jobs[i];
+    if (!job.error.isEmpty()) {
+      if (error->IsNull())
+        error = Exception::Error(qt_v8::FromQString(
+            QString("qt.renderBatch: job %1: %2").arg(i).arg(job.error)));
+      results->Set(i, Null());
+    } else {
+      results->Set(i, qt_v8::FromQByteArray(job.data));
+    }
+  }
+
+  Handle<Value> argv[2] = { error, results };
+  batch->callback->Call(Context::GetCurrent()->Global(), 2, argv);
+
+  batch->input.Dispose();
+  batch->callback.Dispose();
+  delete batch;
+
+  if (try_catch.HasCaught())
+    node::FatalException(try_catch);
+}
+
+//
+// PixmapProbe
+// Paint device noting whether anything draws a pixmap on it, or sets a
+// pen, brush or background textured with one, and drawing nothing
+// otherwise. Pictures replay recorded pixmaps as QPixmap, which can only be
+// used on the GUI thread: replaying a picture on the probe tells if it may
+// go to a worker
+//
+class PixmapProbe : public QPaintDevice {
+ public:
+  PixmapProbe(const QSize& size) : size_(size) {}
+  bool HasPixmaps() const { return engine_.pixmaps; }
+  QPaintEngine* paintEngine() const { return &engine_; }
+
+ protected:
+  int metric(PaintDeviceMetric metric) const {
+    switch (metric) {
+      case PdmWidth: return size_.width();
+      case PdmHeight: return size_.height();
+      case PdmWidthMM: return size_.width() * 254 / 960;
+      case PdmHeightMM: return size_.height() * 254 / 960;
+      case PdmNumColors: return 0;
+      case PdmDepth: return 32;
+      default: return 96; // resolutions
+    }
+  }
+
+ private:
+  struct Engine : public QPaintEngine {
+    Engine() : QPaintEngine(AllFeatures), pixmaps(false) {}
+    bool begin(QPaintDevice*) { return true; }
+    bool end() { return true; }
+    Type type() const { return User; }
+    void updateState(const QPaintEngineState& state) {
+      QPaintEngine::DirtyFlags dirty = state.state();
+      if (((dirty & DirtyBrush) && IsTexture(state.brush())) ||
+          ((dirty & DirtyPen) && IsTexture(state.pen().brush())) ||
+          ((dirty & DirtyBackground) && IsTexture(state.backgroundBrush())))
+        pixmaps = true;
+    }
+    static bool IsTexture(const QBrush& brush) {
+      return brush.style() == Qt::TexturePattern &&
+             !brush.texture().isNull();
+    }
+    void drawPixmap(const QRectF&, const QPixmap&, const QRectF&) {
+      pixmaps = true;
+    }
+
+    // The defaults of these would end up in drawPixmap() or warn
+    void drawImage(const QRectF&, const QImage&, const QRectF&,
+                   Qt::ImageConversionFlags) {}
+    void drawPath(const QPainterPath&) {}
+    void drawPolygon(const QPointF*, int, PolygonDrawMode) {}
+    void drawTextItem(const QPointF&, const QTextItem&) {}
+
+    bool pixmaps;
+  };
+
+  QSize size_;
+  mutable Engine engine_;
+};
+
+// Reads job i of the array into job. Throws and returns false if malformed
+static bool ReadJob(Local<Object> o, int i, Job* job) {
+  job->size = QSize(o->Get(String::NewSymbol("width"))->IntegerValue(),
+                    o->Get(String::NewSymbol("height"))->IntegerValue());
+  if (job->size.isEmpty()) {
+    ThrowException(Exception::RangeError(qt_v8::FromQString(
+        QString("qt.renderBatch: job %1: bad size").arg(i))));
+    return false;
+  }
+
+  Local<Value> background = o->Get(String::NewSymbol("background"));
+  job->background = background->IsNumber()
+      ? background->Uint32Value() : 0;
+
+  Local<Value> format = o->Get(String::NewSymbol("format"));
+  job->format = format->IsString()
+      ? qt_v8::ToQString(format->ToString()).toLatin1() : QByteArray("PNG");
+
+  Local<Value> quality = o->Get(String::NewSymbol("quality"));
+  job->quality = quality->IsNumber() ? quality->IntegerValue() : -1;
+
+  Local<Value> picture = o->Get(String::NewSymbol("picture"));
+  if (QPictureWrap::HasInstance(picture)) {
+    // Pictures are replayed from a shared buffer; give each job its own
+    job->picture = *node::ObjectWrap::Unwrap<QPictureWrap>(
+        picture->ToObject())->GetWrapped();
+    job->picture.detach();
+
+    // Pictures with pixmaps are painted here, only encoded by workers
+    PixmapProbe probe(job->size);
+    QPainter painter(&probe);
+    painter.drawPicture(0, 0, job->picture);
+    painter.end();
+    if (probe.HasPixmaps())
+      job->image = Paint(job);
+
+    return true;
+  }
+
+  const double* commands;
+  int count;
+  Local<Value> none = Local<Value>::New(Undefined());
+  if (!QPainterWrap::ReadCommands("qt.renderBatch",
+                                  o->Get(String::NewSymbol("commands")),
+                                  none, none, none, &commands, &count,
+                                  &job->resources))
+    return false;
+
+  QString error;
+  if (!PaintCommands::Validate(commands, count, job->resources, &error)) {
+    ThrowException(Exception::RangeError(qt_v8::FromQString(
+        QString("qt.renderBatch: job %1: %2").arg(i).arg(error))));
+    return false;
+  }
+
+  PaintCommands::ConvertPixmaps(&job->resources);
+  job->commands.resize(count);
+  qMemCopy(job->commands.data(), commands, count * sizeof(double));
+
+  return true;
+}
+
+//
+// QUIRK:
+// Render()
+// qt.renderBatch(Array jobs, [Object options], Function cb)
+// Not in Qt. Renders each job into its own image and encodes it, spread
+// over options.threads threads (default QThread::idealThreadCount()), off
+// the main thread. Calls cb(err, buffers), with one Buffer per job, in
+// order; failed jobs are null and err describes the first. Jobs:
+//   width, height: image size
+//   commands: PaintCommandBuffer, or
+//   picture: QPicture, replayed at 0, 0. Pictures holding pixmaps are
+//     replayed right away on the main thread, only encoding is off-thread
+//   format: QImageWriter format, 'PNG' by default
+//   quality: format specific, as for QImage.encode()
+//   background: 0xAARRGGBB fill before painting, transparent by default
+// Images referenced by commands must not be modified until cb is called
+//
+static Handle<Value> Render(const Arguments& args) {
+  HandleScope scope;
+
+  Local<Value> callback = args[1]->IsFunction() ? args[1] : args[2];
+  if (!args[0]->IsArray() || !callback->IsFunction())
+    return ThrowException(Exception::TypeError(
+        String::New("qt.renderBatch: bad arguments")));
+
+  Local<Array> jobs = Local<Array>::Cast(args[0]);
+
+  Batch* batch = new Batch;
+  batch->req.data = batch;
+  batch->threads = QThread::idealThreadCount();
+  batch->jobs.resize(jobs->Length());
+
+  if (args[1]->IsObject() && !args[1]->IsFunction()) {
+    Local<Value> threads = args[1]->ToObject()->Get(
+        String::NewSymbol("threads"));
+    if (threads->IsNumber())
+      batch->threads = threads->IntegerValue();
+  }
+
+  bool text = false;
+  for (uint32_t i = 0; i < jobs->Length(); i++) {
+    Local<Value> job = jobs->Get(i);
+    if (!job->IsObject()) {
+      delete batch;
+      return ThrowException(Exception::TypeError(
+          String::New("qt.renderBatch: job not an object")));
+    }
+    if (!ReadJob(job->ToObject(), i, &batch->jobs[i])) {
+      delete batch;
+      return scope.Close(Undefined());
+    }
+    text = text || !batch->jobs[i].resources.strings.isEmpty() ||
+        !batch->jobs[i].picture.isNull();
+  }
+
+  // Pictures may hold text as well
+  if (text && !QFontDatabase::supportsThreadedFontRendering())
+    batch->threads = 1;
+
+  batch->input = Persistent<Object>::New(jobs);
+  batch->callback = Persistent<Function>::New(
+      Local<Function>::Cast(callback));
+
+  uv_queue_work(uv_default_loop(), &batch->req, OnWork, OnDone);
+
+  return scope.Close(Undefined());
+}
+
+void Initialize(Handle<Object> target) {
+  target->Set(String::NewSymbol("renderBatch"),
+      FunctionTemplate::New(Render)->GetFunction());
+}
+
+} // namespace RenderBatch
@@ -0,0 +1,172 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "renderthread.h"
+#include <stdlib.h>
+#include <QPainter>
+#include "qwidget.h"
+
+using namespace v8;
+
+RenderThread::RenderThread(QWidgetImpl* widget, int capacity)
+    : widget_(widget), capacity_(capacity), slots_(new Slot[capacity]),
+      submitted_(0), rendered_(0), presented_(0), quit_(0) {
+  async_ = static_cast<uv_async_t*>(malloc(sizeof(uv_async_t)));
+  uv_async_init(uv_default_loop(), async_, OnAsync);
+  async_->data = this;
+
+  // Only frames in flight keep the loop alive
+  uv_unref(reinterpret_cast<uv_handle_t*>(async_));
+
+  start();
+}
+
+RenderThread::~RenderThread() {
+  quit_.fetchAndStoreOrdered(1);
+  work_.release();
+  wait();
+
+  for (int i = 0; i < capacity_; i++)
+    slots_[i].callback.Dispose();
+  delete[] slots_;
+
+  if (submitted_ != presented_)
+    uv_unref(reinterpret_cast<uv_handle_t*>(async_));
+  uv_close(reinterpret_cast<uv_handle_t*>(async_), OnCloseAsync);
+}
+
+bool RenderThread::Submit(const double* commands, int length,
+                          const PaintCommands::Resources& resources,
+                          const QSize& size, Handle<Value> callback) {
+  int submitted = submitted_;
+  if (submitted - presented_ >= capacity_)
+    return false;
+
+  // The render thread is done with this slot: its frame was presented
+  Slot& slot = slots_[submitted % capacity_];
+  slot.commands.resize(length);
+  qMemCopy(slot.commands.data(), commands, length * sizeof(double));
+  slot.resources = resources;
+  slot.size = size;
+  slot.callback.Dispose();
+  slot.callback = Persistent<Value>::New(callback);
+
+  if (submitted == presented_)
+    uv_ref(reinterpret_cast<uv_handle_t*>(async_));
+
+  // Publishes the slot to the render thread
+  submitted_.fetchAndAddRelease(1);
+  work_.release();
+
+  return true;
+}
+
+void RenderThread::run() {
+  while (true) {
+    work_.acquire();
+    if (quit_.fetchAndAddAcquire(0))
+      return;
+
+    int rendered = rendered_;
+    if (rendered == submitted_.fetchAndAddAcquire(0))
+      continue;
+
+    Slot& slot = slots_[rendered % capacity_];
+
+    // Images come back from presentation, so they are only reallocated
+    // when the size changes
+    if (slot.image.size() != slot.size)
+      slot.image = QImage(slot.size, QImage::Format_ARGB32_Premultiplied);
+    slot.image.fill(Qt::transparent);
+
+    if (!slot.image.isNull()) {
+      QPainter painter(&slot.image);
+      QString error;
+      PaintCommands::Execute(&painter, slot.commands.constData(),
+                             slot.commands.size(), slot.resources, &error);
+    }
+
+    // Drop references to JS-side images in this thread's time
+    slot.resources = PaintCommands::Resources();
+
+    rendered_.fetchAndAddRelease(1);
+    uv_async_send(async_);
+  }
+}
+
+//
+// Present()
+// Takes all frames finished since the last call and repaints the widget
+// with the newest. Older ones are skipped
+//
+void RenderThread::Present() {
+  int rendered = rendered_.fetchAndAddAcquire(0);
+  if (rendered == presented_)
+    return;
+
+  // Swap rather than copy, so the slot reuses the old frame's pixels
+  Slot& newest = slots_[(rendered - 1) % capacity_];
+  frame_.swap(newest.image);
+
+  QVector<Persistent<Value> > callbacks;
+  for (; presented_ < rendered; presented_++) {
+    Slot& slot = slots_[presented_ % capacity_];
+    if (slot.callback->IsFunction())
+      callbacks.append(slot.callback);
+    else
+      slot.callback.Dispose();
+    slot.callback.Clear();
+  }
+
+  if (presented_ == submitted_)
+    uv_unref(reinterpret_cast<uv_handle_t*>(async_));
+
+  widget_->PresentFrame();
+
+  // Last: callbacks may delete this, see setRenderThread()
+  for (int i = 0; i < callbacks.size(); i++) {
+    Handle<Function> cb = Persistent<Function>::Cast(callbacks[i]);
+    cb->Call(Context::GetCurrent()->Global(), 0, NULL);
+    callbacks[i].Dispose();
+  }
+}
+
+void RenderThread::OnAsync(uv_async_t* handle, int status) {
+  HandleScope scope;
+  TryCatch try_catch;
+
+  static_cast<RenderThread*>(handle->data)->Present();
+
+  if (try_catch.HasCaught())
+    node::FatalException(try_catch);
+}
+
+void RenderThread::OnCloseAsync(uv_handle_t* handle) {
+  free(handle);
+}
@@ -0,0 +1,106 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RENDERTHREAD_H
+#define RENDERTHREAD_H
+
+#define BUILDING_NODE_EXTENSION
+#include <node.h>
+#include <uv.h>
+#include <QAtomicInt>
+#include <QImage>
+#include <QSemaphore>
+#include <QSize>
+#include <QThread>
+#include <QVector>
+#include "paintcommands.h"
+
+class QWidgetImpl;
+
+//
+// RenderThread
+// Rasterizes frames of paint commands for a widget on a dedicated thread,
+// so that JS can record frame N+1 while frame N is painted. Frames go
+// through a ring of slots shared with the main thread without locks: the
+// main thread only advances submitted_, the render thread only rendered_.
+// Finished frames are handed back through a uv_async and presented by
+// repainting the widget from Frame()
+//
+class RenderThread : public QThread {
+ public:
+  // capacity: frames in flight, submitted but not yet presented
+  RenderThread(QWidgetImpl* widget, int capacity);
+  ~RenderThread();
+
+  int Capacity() const { return capacity_; };
+
+  // Queues a frame of the given size. Commands are copied and must be
+  // valid (see PaintCommands::Validate()), with pixmaps converted. Returns
+  // false if capacity frames are already in flight. callback, if a
+  // function, is called once the frame is presented. Main thread only
+  bool Submit(const double* commands, int length,
+              const PaintCommands::Resources& resources, const QSize& size,
+              v8::Handle<v8::Value> callback);
+
+  // Last presented frame. Main thread only
+  const QImage& Frame() const { return frame_; };
+
+ protected:
+  void run();
+
+ private:
+  struct Slot {
+    QVector<double> commands;
+    PaintCommands::Resources resources;
+    QSize size;
+    QImage image;
+    v8::Persistent<v8::Value> callback;
+  };
+
+  static void OnAsync(uv_async_t* handle, int status);
+  static void OnCloseAsync(uv_handle_t* handle);
+  void Present();
+
+  QWidgetImpl* widget_;
+  int capacity_;
+  Slot* slots_;
+
+  // Frame counters; slot of frame n is n % capacity_
+  QAtomicInt submitted_;
+  QAtomicInt rendered_;
+  int presented_;
+
+  QSemaphore work_;
+  QAtomicInt quit_;
+
+  uv_async_t* async_;
+  QImage frame_;
+};
+
+#endif
@@ -0,0 +1,295 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "surfacepool.h"
+#include <QApplication>
+#include <QList>
+#include "../qt_v8.h"
+#include "qimage.h"
+#include "qpixmap.h"
+
+using namespace v8;
+
+namespace SurfacePool {
+
+struct Surface {
+  quint64 key;
+  int bytes;
+  QImage image;
+  QPixmap pixmap;
+};
+
+struct Pool {
+  // Free surfaces, least recently released first
+  QList<Surface> surfaces;
+  qint64 bytes;
+  qint64 capacity;
+
+  double hits;
+  double misses;
+  double evictions;
+};
+
+// Never freed: pixmaps can't outlive the application, which is gone by the
+// time static objects are destroyed
+static Pool* Instance() {
+  static Pool* pool = NULL;
+  if (!pool) {
+    pool = new Pool;
+    pool->bytes = 0;
+    pool->capacity = 64 * 1024 * 1024;
+    pool->hits = pool->misses = pool->evictions = 0;
+  }
+  return pool;
+}
+
+// Pixmaps in the top bit, then format, width and height
+static quint64 ImageKey(int width, int height, QImage::Format format) {
+  return (quint64(format) << 48) | (quint64(width) << 24) | quint64(height);
+}
+
+static quint64 PixmapKey(int width, int height) {
+  return (quint64(1) << 63) | (quint64(width) << 24) | quint64(height);
+}
+
+// Takes the most recently released surface with key, if any
+static bool Take(quint64 key, Surface* surface) {
+  Pool* pool = Instance();
+
+  for (int i = pool->surfaces.size() - 1; i >= 0; i--) {
+    if (pool->surfaces[i].key != key)
+      continue;
+    *surface = pool->surfaces.takeAt(i);
+    pool->bytes -= surface->bytes;
+    pool->hits++;
+    return true;
+  }
+
+  pool->misses++;
+  return false;
+}
+
+// Refuses surfaces larger than the whole pool
+static bool Put(const Surface& surface) {
+  Pool* pool = Instance();
+  if (surface.bytes > pool->capacity)
+    return false;
+
+  pool->surfaces.append(surface);
+  pool->bytes += surface.bytes;
+
+  while (pool->bytes > pool->capacity) {
+    pool->bytes -= pool->surfaces.takeFirst().bytes;
+    pool->evictions++;
+  }
+  return true;
+}
+
+QImage AcquireImage(int width, int height, QImage::Format format) {
+  Surface surface;
+  if (Take(ImageKey(width, height, format), &surface))
+    return surface.image;
+  return QImage(width, height, format);
+}
+
+QPixmap AcquirePixmap(int width, int height) {
+  Surface surface;
+  if (Take(PixmapKey(width, height), &surface))
+    return surface.pixmap;
+  return QPixmap(width, height);
+}
+
+bool Release(const QImage& image) {
+  if (image.isNull() || !image.isDetached())
+    return false;
+
+  Surface surface;
+  surface.key = ImageKey(image.width(), image.height(), image.format());
+  surface.bytes = image.byteCount();
+  surface.image = image;
+  return Put(surface);
+}
+
+bool Release(const QPixmap& pixmap) {
+  if (pixmap.isNull() || !pixmap.isDetached())
+    return false;
+
+  Surface surface;
+  surface.key = PixmapKey(pixmap.width(), pixmap.height());
+  surface.bytes = pixmap.width() * pixmap.height() * pixmap.depth() / 8;
+  surface.pixmap = pixmap;
+  return Put(surface);
+}
+
+// Sizes fit in the key, and are limited to what QImage can address anyway
+static bool ReadSize(const Arguments& args, int* width, int* height) {
+  if (!args[0]->IsNumber() || !args[1]->IsNumber())
+    return false;
+  *width = args[0]->IntegerValue();
+  *height = args[1]->IntegerValue();
+  return *width > 0 && *height > 0 && *width < (1 << 24) &&
+         *height < (1 << 24);
+}
+
+//
+// QUIRK:
+// Image()
+// qt.SurfacePool.image(int width, int height,
+//   Format format = Format_ARGB32_Premultiplied)
+// Not in Qt. A QImage whose pixels come from the pool when possible. Its
+// contents are undefined, as with new QImage(). dispose() or garbage
+// collection return the pixels to the pool
+//
+static Handle<Value> Image(const Arguments& args) {
+  HandleScope scope;
+
+  int width, height;
+  if (!ReadSize(args, &width, &height))
+    return ThrowException(Exception::RangeError(
+        String::New("SurfacePool::Image: bad size")));
+
+  QImage::Format format = args[2]->IsNumber()
+      ? (QImage::Format)args[2]->IntegerValue()
+      : QImage::Format_ARGB32_Premultiplied;
+  if (format <= QImage::Format_Invalid || format >= QImage::NImageFormats)
+    return ThrowException(Exception::RangeError(
+        String::New("SurfacePool::Image: unknown format")));
+
+  Local<Object> instance = QImageWrap::NewInstance(
+      AcquireImage(width, height, format))->ToObject();
+  node::ObjectWrap::Unwrap<QImageWrap>(instance)->SetPooled(true);
+
+  return scope.Close(instance);
+}
+
+//
+// QUIRK:
+// Pixmap()
+// qt.SurfacePool.pixmap(int width, int height)
+// Not in Qt. Like image(), for a QPixmap
+//
+static Handle<Value> Pixmap(const Arguments& args) {
+  HandleScope scope;
+
+  if (QApplication::type() == QApplication::Tty)
+    return ThrowException(Exception::Error(
+        String::New("QPixmapWrap: not available in headless mode")));
+
+  int width, height;
+  if (!ReadSize(args, &width, &height))
+    return ThrowException(Exception::RangeError(
+        String::New("SurfacePool::Pixmap: bad size")));
+
+  Local<Object> instance = QPixmapWrap::NewInstance(
+      AcquirePixmap(width, height))->ToObject();
+  node::ObjectWrap::Unwrap<QPixmapWrap>(instance)->SetPooled(true);
+
+  return scope.Close(instance);
+}
+
+// Cap of the pooled bytes, 64 MB by default. Lowering it evicts
+static Handle<Value> SetCapacity(const Arguments& args) {
+  HandleScope scope;
+
+  if (!args[0]->IsNumber() || args[0]->NumberValue() < 0)
+    return ThrowException(Exception::RangeError(
+        String::New("SurfacePool::SetCapacity: bad capacity")));
+
+  Pool* pool = Instance();
+  pool->capacity = args[0]->IntegerValue();
+  while (pool->bytes > pool->capacity) {
+    pool->bytes -= pool->surfaces.takeFirst().bytes;
+    pool->evictions++;
+  }
+
+  return scope.Close(Undefined());
+}
+
+static Handle<Value> Capacity(const Arguments& args) {
+  HandleScope scope;
+
+  return scope.Close(Number::New(Instance()->capacity));
+}
+
+//
+// Stats()
+// Returns { hits, misses, hitRate, evictions, surfaces, bytes, capacity },
+// counted since the start of the process. bytes are those of the free
+// surfaces waiting in the pool
+//
+static Handle<Value> Stats(const Arguments& args) {
+  HandleScope scope;
+
+  Pool* pool = Instance();
+  double requests = pool->hits + pool->misses;
+
+  Local<Object> stats = Object::New();
+  stats->Set(String::NewSymbol("hits"), Number::New(pool->hits));
+  stats->Set(String::NewSymbol("misses"), Number::New(pool->misses));
+  stats->Set(String::NewSymbol("hitRate"),
+             Number::New(requests > 0 ? pool->hits / requests : 0));
+  stats->Set(String::NewSymbol("evictions"), Number::New(pool->evictions));
+  stats->Set(String::NewSymbol("surfaces"),
+             Integer::New(pool->surfaces.size()));
+  stats->Set(String::NewSymbol("bytes"), Number::New(pool->bytes));
+  stats->Set(String::NewSymbol("capacity"), Number::New(pool->capacity));
+
+  return scope.Close(stats);
+}
+
+// Frees all pooled surfaces
+static Handle<Value> Clear(const Arguments& args) {
+  HandleScope scope;
+
+  Pool* pool = Instance();
+  pool->surfaces.clear();
+  pool->bytes = 0;
+
+  return scope.Close(Undefined());
+}
+
+void Initialize(Handle<Object> target) {
+  Local<Object> pool = Object::New();
+  pool->Set(String::NewSymbol("image"),
+      FunctionTemplate::New(Image)->GetFunction());
+  pool->Set(String::NewSymbol("pixmap"),
+      FunctionTemplate::New(Pixmap)->GetFunction());
+  pool->Set(String::NewSymbol("setCapacity"),
+      FunctionTemplate::New(SetCapacity)->GetFunction());
+  pool->Set(String::NewSymbol("capacity"),
+      FunctionTemplate::New(Capacity)->GetFunction());
+  pool->Set(String::NewSymbol("stats"),
+      FunctionTemplate::New(Stats)->GetFunction());
+  pool->Set(String::NewSymbol("clear"),
+      FunctionTemplate::New(Clear)->GetFunction());
+
+  target->Set(String::NewSymbol("SurfacePool"), pool);
+}
+
+} // namespace SurfacePool
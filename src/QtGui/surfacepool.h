@@ -0,0 +1,65 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SURFACEPOOL_H
+#define SURFACEPOOL_H
+
+#define BUILDING_NODE_EXTENSION
+#include <node.h>
+#include <QImage>
+#include <QPixmap>
+
+//
+// SurfacePool
+// Recycles the pixels of short-lived render targets, e.g. a layer drawn
+// and dropped every frame, instead of allocating and freeing megabytes
+// each time. Images and pixmaps handed out by qt.SurfacePool go back to
+// the pool on dispose() or garbage collection, where they wait for a
+// request of the same size and format. The pool holds at most a capacity
+// of bytes, evicting the least recently released surfaces. Main thread
+// only
+//
+namespace SurfacePool {
+
+// A surface from the pool if one matches, else a new one. Pixels are left
+// as they were: fill() before use
+QImage AcquireImage(int width, int height, QImage::Format format);
+QPixmap AcquirePixmap(int width, int height);
+
+// Takes back a surface handed out by Acquire*(). Surfaces still shared,
+// e.g. with an image being encoded, are left alone. Returns whether the
+// pool took it
+bool Release(const QImage& image);
+bool Release(const QPixmap& pixmap);
+
+void Initialize(v8::Handle<v8::Object> target);
+
+} // namespace SurfacePool
+
+#endif
@@ -0,0 +1,583 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "tiledimagesource.h"
+#include <math.h>
+#include <stdlib.h>
+#include <QImageIOHandler>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <qmath.h>
+#include "../qt_v8.h"
+#include "qpainter.h"
+
+using namespace v8;
+
+TiledImageSource::TiledImageSource(const QString& path, int tileSize,
+                                   int cacheBytes)
+    : path_(path), tileSize_(tileSize), levels_(0), clipped_(false),
+      quit_(false), wholeLevel_(-1), referenced_(false) {
+  // Only reads the header
+  QImageReader reader(path);
+  size_ = reader.size();
+  clipped_ = reader.supportsOption(QImageIOHandler::ClipRect);
+
+  if (!size_.isEmpty()) {
+    int extent = qMax(size_.width(), size_.height());
+    for (levels_ = 1; extent > tileSize_; levels_++)
+      extent = (extent + 1) / 2;
+  }
+
+  cache_.setMaxCost(cacheBytes);
+
+  async_ = static_cast<uv_async_t*>(malloc(sizeof(uv_async_t)));
+  uv_async_init(uv_default_loop(), async_, OnAsync);
+  async_->data = this;
+
+  // Only tiles in flight keep the loop alive
+  uv_unref(reinterpret_cast<uv_handle_t*>(async_));
+
+  if (!IsNull())
+    start();
+}
+
+TiledImageSource::~TiledImageSource() {
+  mutex_.lock();
+  quit_ = true;
+  mutex_.unlock();
+  wake_.wakeOne();
+  wait();
+
+  callback_.Dispose();
+
+  if (referenced_)
+    uv_unref(reinterpret_cast<uv_handle_t*>(async_));
+  uv_close(reinterpret_cast<uv_handle_t*>(async_), OnCloseAsync);
+}
+
+TiledImageSource::Key TiledImageSource::MakeKey(int level, int column,
+                                                int row) {
+  return (Key(level) << 56) | (Key(column) << 28) | Key(row);
+}
+
+int TiledImageSource::LevelFor(double scale) const {
+  if (scale >= 1.0)
+    return 0;
+  int level = qFloor(log(1.0 / scale) / log(2.0));
+  return qBound(0, level, levels_ - 1);
+}
+
+QRect TiledImageSource::SourceRect(int level, int column, int row) const {
+  int span = tileSize_ << level;
+  return QRect(column * span, row * span, span, span) &
+         QRect(QPoint(0, 0), size_);
+}
+
+QSize TiledImageSource::TileExtent(int level, int column, int row) const {
+  QRect source = SourceRect(level, column, row);
+  int round = (1 << level) - 1;
+  return QSize(qMax(1, (source.width() + round) >> level),
+               qMax(1, (source.height() + round) >> level));
+}
+
+//
+// Decode()
+// Runs on the worker thread. QImageReader falls back to decoding the whole
+// image for a clip rect the reader can't decode by itself, which would be
+// once per tile: then the whole level is decoded once and kept, and tiles
+// are cut from it, until the queue runs dry. Tiles are mostly asked for a
+// level at a time
+//
+QImage TiledImageSource::Decode(Key key) {
+  int level = int(key >> 56);
+  int column = int((key >> 28) & 0xfffffff);
+  int row = int(key & 0xfffffff);
+
+  if (!clipped_) {
+    if (wholeLevel_ != level) {
+      whole_ = QImage();
+      QImageReader reader(path_);
+      if (level > 0) {
+        int round = (1 << level) - 1;
+        reader.setScaledSize(QSize((size_.width() + round) >> level,
+                                   (size_.height() + round) >> level));
+      }
+      whole_ = reader.read().convertToFormat(
+          QImage::Format_ARGB32_Premultiplied);
+      wholeLevel_ = level;
+    }
+    if (whole_.isNull())
+      return QImage();
+    return whole_.copy(QRect(QPoint(column * tileSize_, row * tileSize_),
+                             TileExtent(level, column, row)));
+  }
+
+  QImageReader reader(path_);
+  reader.setClipRect(SourceRect(level, column, row));
+  if (level > 0)
+    reader.setScaledSize(TileExtent(level, column, row));
+
+  return reader.read().convertToFormat(
+      QImage::Format_ARGB32_Premultiplied);
+}
+
+void TiledImageSource::run() {
+  while (true) {
+    mutex_.lock();
+    // A whole level is only worth its memory while tiles are queued
+    if (queue_.isEmpty()) {
+      whole_ = QImage();
+      wholeLevel_ = -1;
+    }
+    while (!quit_ && queue_.isEmpty())
+      wake_.wait(&mutex_);
+    if (quit_) {
+      mutex_.unlock();
+      return;
+    }
+    Key key = queue_.takeFirst();
+    mutex_.unlock();
+
+    QImage tile = Decode(key);
+
+    mutex_.lock();
+    decoded_.append(qMakePair(key, tile));
+    mutex_.unlock();
+    uv_async_send(async_);
+  }
+}
+
+int TiledImageSource::Draw(QPainter* painter, const QRectF& rect,
+                           double scale) {
+  if (IsNull() || scale <= 0)
+    return 0;
+
+  int level = LevelFor(scale);
+  double span = (tileSize_ << level) * scale;
+  int columns = (size_.width() + (tileSize_ << level) - 1) /
+                (tileSize_ << level);
+  int rows = (size_.height() + (tileSize_ << level) - 1) /
+             (tileSize_ << level);
+
+  // Tiles shown in rect
+  int left = qMax(0, qFloor(rect.left() / span));
+  int top = qMax(0, qFloor(rect.top() / span));
+  int right = qMin(columns - 1, qCeil(rect.right() / span) - 1);
+  int bottom = qMin(rows - 1, qCeil(rect.bottom() / span) - 1);
+
+  QList<Key> wanted;
+  int missing = 0;
+
+  for (int row = top; row <= bottom; row++) {
+    for (int column = left; column <= right; column++) {
+      Key key = MakeKey(level, column, row);
+      QImage* tile = cache_.object(key);
+      if (!tile) {
+        DrawFallback(painter, level, column, row, scale);
+        wanted.append(key);
+        missing++;
+        continue;
+      }
+
+      // Tiles that failed to decode are cached empty
+      if (tile->isNull())
+        continue;
+
+      QRect source = SourceRect(level, column, row);
+      painter->drawImage(QRectF(source.x() * scale, source.y() * scale,
+                                source.width() * scale,
+                                source.height() * scale),
+                         *tile, QRectF(tile->rect()));
+    }
+  }
+
+  // Prefetch: the ring of tiles around the shown ones, so that scrolling
+  // finds them cached, then the next level up for zooming out and as the
+  // fallback of this one. Only as many as the cache holds besides the
+  // shown tiles: more would evict those as they arrive, and be asked for
+  // again by the next Draw()
+  int room = cache_.maxCost() / (tileSize_ * tileSize_ * 4);
+  if (left <= right && top <= bottom)
+    room -= (right - left + 1) * (bottom - top + 1);
+
+  for (int row = top - 1; row <= bottom + 1 && room > 0; row++) {
+    for (int column = left - 1; column <= right + 1 && room > 0; column++) {
+      if (row < 0 || row >= rows || column < 0 || column >= columns)
+        continue;
+      if (row >= top && row <= bottom && column >= left && column <= right)
+        continue;
+      Key key = MakeKey(level, column, row);
+      room--;
+      if (!cache_.contains(key))
+        wanted.append(key);
+    }
+  }
+  if (level + 1 < levels_ && left <= right && top <= bottom) {
+    for (int row = top / 2; row <= bottom / 2 && room > 0; row++) {
+      for (int column = left / 2; column <= right / 2 && room > 0;
+           column++) {
+        Key key = MakeKey(level + 1, column, row);
+        room--;
+        if (!cache_.contains(key))
+          wanted.append(key);
+      }
+    }
+  }
+
+  Schedule(wanted);
+
+  return missing;
+}
+
+// Paints a tile missing from the cache with the part of the closest
+// coarser cached tile covering it, if any
+void TiledImageSource::DrawFallback(QPainter* painter, int level, int column,
+                                    int row, double scale) {
+  QRect source = SourceRect(level, column, row);
+
+  for (int coarse = level + 1; coarse < levels_; coarse++) {
+    int shift = coarse - level;
+    QImage* tile = cache_.object(MakeKey(coarse, column >> shift,
+                                         row >> shift));
+    if (!tile || tile->isNull())
+      continue;
+
+    QRect parent = SourceRect(coarse, column >> shift, row >> shift);
+    double f = 1.0 / (1 << coarse);
+    painter->drawImage(QRectF(source.x() * scale, source.y() * scale,
+                              source.width() * scale,
+                              source.height() * scale),
+                       *tile,
+                       QRectF((source.x() - parent.x()) * f,
+                              (source.y() - parent.y()) * f,
+                              source.width() * f, source.height() * f));
+    return;
+  }
+}
+
+//
+// Schedule()
+// Replaces the decode queue with keys, in order. Tiles queued by an
+// earlier call and no longer wanted, e.g. scrolled past, are dropped
+//
+void TiledImageSource::Schedule(const QList<Key>& keys) {
+  mutex_.lock();
+
+  for (int i = 0; i < queue_.size(); i++)
+    requested_.remove(queue_[i]);
+  queue_.clear();
+
+  // Tiles being decoded, or decoded but not delivered, stay requested
+  for (int i = 0; i < keys.size(); i++) {
+    if (requested_.contains(keys[i]))
+      continue;
+    requested_.insert(keys[i]);
+    queue_.append(keys[i]);
+  }
+
+  mutex_.unlock();
+  wake_.wakeOne();
+
+  UpdateRef();
+}
+
+void TiledImageSource::UpdateRef() {
+  bool busy = !requested_.isEmpty();
+  if (busy == referenced_)
+    return;
+
+  if (busy)
+    uv_ref(reinterpret_cast<uv_handle_t*>(async_));
+  else
+    uv_unref(reinterpret_cast<uv_handle_t*>(async_));
+  referenced_ = busy;
+}
+
+void TiledImageSource::SetCallback(Handle<Value> callback) {
+  callback_.Dispose();
+  callback_ = Persistent<Value>::New(callback);
+}
+
+void TiledImageSource::Deliver() {
+  QList<QPair<Key, QImage> > decoded;
+  mutex_.lock();
+  decoded.swap(decoded_);
+  mutex_.unlock();
+
+  if (decoded.isEmpty())
+    return;
+
+  // Failed tiles are cached too, empty, so they are not asked for again
+  for (int i = 0; i < decoded.size(); i++) {
+    const QImage& tile = decoded[i].second;
+    requested_.remove(decoded[i].first);
+    cache_.insert(decoded[i].first, new QImage(tile), tile.byteCount());
+  }
+
+  UpdateRef();
+
+  if (callback_->IsFunction()) {
+    Handle<Function> cb = Persistent<Function>::Cast(callback_);
+    cb->Call(Context::GetCurrent()->Global(), 0, NULL);
+  }
+}
+
+void TiledImageSource::OnAsync(uv_async_t* handle, int status) {
+  HandleScope scope;
+  TryCatch try_catch;
+
+  static_cast<TiledImageSource*>(handle->data)->Deliver();
+
+  if (try_catch.HasCaught())
+    node::FatalException(try_catch);
+}
+
+void TiledImageSource::OnCloseAsync(uv_handle_t* handle) {
+  free(handle);
+}
+
+//
+// TiledImageSourceWrap
+//
+
+Persistent<Function> TiledImageSourceWrap::constructor;
+Persistent<FunctionTemplate> TiledImageSourceWrap::constructor_template;
+
+TiledImageSourceWrap::TiledImageSourceWrap(const QString& path, int tileSize,
+                                           int cacheBytes) : q_(NULL) {
+  q_ = new TiledImageSource(path, tileSize, cacheBytes);
+}
+
+TiledImageSourceWrap::~TiledImageSourceWrap() {
+  delete q_;
+}
+
+void TiledImageSourceWrap::Initialize(Handle<Object> target) {
+  // Prepare constructor template
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
+  tpl->SetClassName(String::NewSymbol("TiledImageSource"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  // Prototype
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("isNull"),
+      FunctionTemplate::New(IsNull)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("width"),
+      FunctionTemplate::New(Width)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("height"),
+      FunctionTemplate::New(Height)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("tileSize"),
+      FunctionTemplate::New(TileSize)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("levels"),
+      FunctionTemplate::New(Levels)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("cacheCost"),
+      FunctionTemplate::New(CacheCost)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("draw"),
+      FunctionTemplate::New(Draw)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("tileReady"),
+      FunctionTemplate::New(TileReady)->GetFunction());
+
+  constructor = Persistent<Function>::New(tpl->GetFunction());
+  target->Set(String::NewSymbol("TiledImageSource"), constructor);
+}
+
+bool TiledImageSourceWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
+//
+// QUIRK:
+// New()
+// Not in Qt. TiledImageSource(String path, [Object options])
+// Options:
+//   tileSize: edge of the square tiles, in pixels. 256 by default
+//   cacheSize: cap of the tile cache, in bytes. 64 MB by default, and at
+//     least one tile. Should hold the tiles shown at once: tiles
+//     prefetched around them only use what is left
+// The image is not decoded here, only its header is read: isNull() tells
+// whether it could be
+//
+Handle<Value> TiledImageSourceWrap::New(const Arguments& args) {
+  HandleScope scope;
+
+  if (!args[0]->IsString())
+    return ThrowException(Exception::TypeError(
+        String::New("TiledImageSourceWrap: path must be a string")));
+
+  int tileSize = 256;
+  int cacheBytes = 64 * 1024 * 1024;
+
+  if (args[1]->IsObject()) {
+    Local<Object> o = args[1]->ToObject();
+    Local<Value> size = o->Get(String::NewSymbol("tileSize"));
+    if (size->IsNumber())
+      tileSize = size->IntegerValue();
+    Local<Value> cache = o->Get(String::NewSymbol("cacheSize"));
+    if (cache->IsNumber())
+      cacheBytes = cache->IntegerValue();
+  }
+
+  // Keeps tile keys and pixel offsets within range
+  if (tileSize < 16 || tileSize > 4096)
+    return ThrowException(Exception::RangeError(
+        String::New("TiledImageSourceWrap: bad tile or cache size")));
+
+  // A cache without room for a tile would drop every tile it is given,
+  // and Draw() would ask for them again forever
+  if (cacheBytes < tileSize * tileSize * 4)
+    return ThrowException(Exception::RangeError(
+        String::New("TiledImageSourceWrap: cache smaller than a tile")));
+
+  TiledImageSourceWrap* w = new TiledImageSourceWrap(
+      qt_v8::ToQString(args[0]->ToString()), tileSize, cacheBytes);
+  w->Wrap(args.This());
+
+  return args.This();
+}
+
+Handle<Value> TiledImageSourceWrap::IsNull(const Arguments& args) {
+  HandleScope scope;
+
+  TiledImageSourceWrap* w = ObjectWrap::Unwrap<TiledImageSourceWrap>(
+      args.This());
+  TiledImageSource* q = w->GetWrapped();
+
+  return scope.Close(Boolean::New(q->IsNull()));
+}
+
+Handle<Value> TiledImageSourceWrap::Width(const Arguments& args) {
+  HandleScope scope;
+
+  TiledImageSourceWrap* w = ObjectWrap::Unwrap<TiledImageSourceWrap>(
+      args.This());
+  TiledImageSource* q = w->GetWrapped();
+
+  return scope.Close(Integer::New(q->Size().width()));
+}
+
+Handle<Value> TiledImageSourceWrap::Height(const Arguments& args) {
+  HandleScope scope;
+
+  TiledImageSourceWrap* w = ObjectWrap::Unwrap<TiledImageSourceWrap>(
+      args.This());
+  TiledImageSource* q = w->GetWrapped();
+
+  return scope.Close(Integer::New(q->Size().height()));
+}
+
+Handle<Value> TiledImageSourceWrap::TileSize(const Arguments& args) {
+  HandleScope scope;
+
+  TiledImageSourceWrap* w = ObjectWrap::Unwrap<TiledImageSourceWrap>(
+      args.This());
+  TiledImageSource* q = w->GetWrapped();
+
+  return scope.Close(Integer::New(q->TileSize()));
+}
+
+// Number of pyramid levels, 0 if the image can't be read
+Handle<Value> TiledImageSourceWrap::Levels(const Arguments& args) {
+  HandleScope scope;
+
+  TiledImageSourceWrap* w = ObjectWrap::Unwrap<TiledImageSourceWrap>(
+      args.This());
+  TiledImageSource* q = w->GetWrapped();
+
+  return scope.Close(Integer::New(q->Levels()));
+}
+
+// Bytes of pixels held by the tile cache
+Handle<Value> TiledImageSourceWrap::CacheCost(const Arguments& args) {
+  HandleScope scope;
+
+  TiledImageSourceWrap* w = ObjectWrap::Unwrap<TiledImageSourceWrap>(
+      args.This());
+  TiledImageSource* q = w->GetWrapped();
+
+  return scope.Close(Integer::New(q->CacheCost()));
+}
+
+//
+// QUIRK:
+// Draw()
+// draw(QPainter painter, Number x, Number y, Number width, Number height,
+//      [Number scale])
+// Paints the part of the image that falls in the given rect of a target
+// where the whole image is drawn at scale (1 by default), from cached
+// tiles, and queues missing tiles and their neighbours for decoding.
+// Missing tiles are painted from a coarser level when cached. Returns the
+// number of missing tiles: tileReady() callbacks follow as they arrive
+//
+Handle<Value> TiledImageSourceWrap::Draw(const Arguments& args) {
+  HandleScope scope;
+
+  TiledImageSourceWrap* w = ObjectWrap::Unwrap<TiledImageSourceWrap>(
+      args.This());
+  TiledImageSource* q = w->GetWrapped();
+
+  if (!QPainterWrap::HasInstance(args[0]) || !args[1]->IsNumber() ||
+      !args[2]->IsNumber() || !args[3]->IsNumber() || !args[4]->IsNumber())
+    return ThrowException(Exception::TypeError(
+        String::New("TiledImageSourceWrap::Draw: bad arguments")));
+
+  double scale = args[5]->IsNumber() ? args[5]->NumberValue() : 1.0;
+  if (!(scale > 0))
+    return ThrowException(Exception::RangeError(
+        String::New("TiledImageSourceWrap::Draw: bad scale")));
+
+  QPainter* painter = ObjectWrap::Unwrap<QPainterWrap>(
+      args[0]->ToObject())->GetWrapped();
+  if (!painter->isActive())
+    return ThrowException(Exception::Error(
+        String::New("TiledImageSourceWrap::Draw: painter not active")));
+
+  QRectF rect(args[1]->NumberValue(), args[2]->NumberValue(),
+              args[3]->NumberValue(), args[4]->NumberValue());
+
+  return scope.Close(Integer::New(q->Draw(painter, rect, scale)));
+}
+
+//
+// QUIRK:
+// TileReady()
+// tileReady(Function callback)
+// callback() is called whenever decoded tiles reach the cache, typically
+// to update() the widget showing the image
+//
+Handle<Value> TiledImageSourceWrap::TileReady(const Arguments& args) {
+  HandleScope scope;
+
+  TiledImageSourceWrap* w = ObjectWrap::Unwrap<TiledImageSourceWrap>(
+      args.This());
+  TiledImageSource* q = w->GetWrapped();
+
+  q->SetCallback(args[0]);
+
+  return scope.Close(Undefined());
+}
@@ -0,0 +1,162 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef TILEDIMAGESOURCE_H
+#define TILEDIMAGESOURCE_H
+
+#define BUILDING_NODE_EXTENSION
+#include <node.h>
+#include <uv.h>
+#include <QCache>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QPainter>
+#include <QSet>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+//
+// TiledImageSource
+// Shows images too large to decode whole. The image is cut into a pyramid
+// of tiles: level 0 is full resolution, each level above halves it, up to
+// a level that fits in one tile. Tiles are decoded on demand on a worker
+// thread with QImageReader::setClipRect()/setScaledSize(), so readers that
+// support those (e.g. JPEG) only decode what is shown. Other readers (e.g.
+// PNG) decode a whole level once, and its tiles are cut from that. Tiles
+// are kept premultiplied, ready to blit, in an LRU cache capped in bytes;
+// as images rather than pixmaps, so that it also works headless. Decoded
+// tiles are handed back through a uv_async. All methods are main thread
+// only
+//
+class TiledImageSource : public QThread {
+ public:
+  TiledImageSource(const QString& path, int tileSize, int cacheBytes);
+  ~TiledImageSource();
+
+  bool IsNull() const { return size_.isEmpty(); };
+  const QSize& Size() const { return size_; };
+  int TileSize() const { return tileSize_; };
+  int Levels() const { return levels_; };
+  int CacheCost() const { return cache_.totalCost(); };
+
+  // Finest level with at least scale resolution
+  int LevelFor(double scale) const;
+
+  // Paints the part of the image shown in rect of a target where the image
+  // is drawn at scale, from cached tiles. Tiles not cached yet are painted
+  // from a coarser cached level if there is one, and queued for decoding
+  // along with their neighbours. Returns the number of missing tiles
+  int Draw(QPainter* painter, const QRectF& rect, double scale);
+
+  // Called with no arguments whenever new tiles are cached
+  void SetCallback(v8::Handle<v8::Value> callback);
+
+ protected:
+  void run();
+
+ private:
+  // Level in the top byte, then tile column and row
+  typedef quint64 Key;
+  static Key MakeKey(int level, int column, int row);
+
+  // Area of the original image covered by a tile, and its decoded size
+  QRect SourceRect(int level, int column, int row) const;
+  QSize TileExtent(int level, int column, int row) const;
+  QImage Decode(Key key);
+
+  void DrawFallback(QPainter* painter, int level, int column, int row,
+                    double scale);
+  void Schedule(const QList<Key>& keys);
+  void UpdateRef();
+
+  static void OnAsync(uv_async_t* handle, int status);
+  static void OnCloseAsync(uv_handle_t* handle);
+  void Deliver();
+
+  QString path_;
+  QSize size_;
+  int tileSize_;
+  int levels_;
+  // Whether the reader decodes clip rects itself
+  bool clipped_;
+
+  QCache<Key, QImage> cache_;
+  // Tiles queued or being decoded
+  QSet<Key> requested_;
+
+  // Shared with the worker thread
+  QMutex mutex_;
+  QWaitCondition wake_;
+  QList<Key> queue_;
+  QList<QPair<Key, QImage> > decoded_;
+  bool quit_;
+
+  // Worker thread only: the last level decoded whole, when not clipped_
+  QImage whole_;
+  int wholeLevel_;
+
+  uv_async_t* async_;
+  bool referenced_;
+  v8::Persistent<v8::Value> callback_;
+};
+
+//
+// TiledImageSourceWrap()
+//
+class TiledImageSourceWrap : public node::ObjectWrap {
+ public:
+  static void Initialize(v8::Handle<v8::Object> target);
+  static bool HasInstance(v8::Handle<v8::Value> value);
+  TiledImageSource* GetWrapped() const { return q_; };
+
+ private:
+  TiledImageSourceWrap(const QString& path, int tileSize, int cacheBytes);
+  ~TiledImageSourceWrap();
+  static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> constructor_template;
+  static v8::Handle<v8::Value> New(const v8::Arguments& args);
+
+  // Wrapped methods
+  static v8::Handle<v8::Value> IsNull(const v8::Arguments& args);
+  static v8::Handle<v8::Value> Width(const v8::Arguments& args);
+  static v8::Handle<v8::Value> Height(const v8::Arguments& args);
+  static v8::Handle<v8::Value> TileSize(const v8::Arguments& args);
+  static v8::Handle<v8::Value> Levels(const v8::Arguments& args);
+  static v8::Handle<v8::Value> CacheCost(const v8::Arguments& args);
+  static v8::Handle<v8::Value> Draw(const v8::Arguments& args);
+  static v8::Handle<v8::Value> TileReady(const v8::Arguments& args);
+
+  // Wrapped object
+  TiledImageSource* q_;
+};
+
+#endif
@@ -0,0 +1,144 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "tiledrender.h"
+#include <QAtomicInt>
+#include <QFontDatabase>
+#include <QMutex>
+#include <QPainter>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+
+namespace TiledRender {
+
+//
+// Job
+// A render shared by all threads. Tiles are claimed through next, so fast
+// threads take over the tiles of slow ones
+//
+struct Job {
+  Target target;
+  int bytesPerPixel;
+  const double* commands;
+  int length;
+  const PaintCommands::Resources* resources;
+  int columns;
+  int rows;
+
+  QAtomicInt next;
+  QMutex lock;
+  QString error;
+};
+
+static void RenderTile(Job* job, int index) {
+  const Target& t = job->target;
+  int column = index % job->columns;
+  int row = index / job->columns;
+
+  int x0 = column * t.width / job->columns;
+  int x1 = (column + 1) * t.width / job->columns;
+  int y0 = row * t.height / job->rows;
+  int y1 = (row + 1) * t.height / job->rows;
+  if (x1 <= x0 || y1 <= y0)
+    return;
+
+  // A view on the target's pixels; its bounds clip the tile
+  QImage tile(t.bits + y0 * t.bytesPerLine + x0 * job->bytesPerPixel,
+              x1 - x0, y1 - y0, t.bytesPerLine, t.format);
+
+  QPainter painter(&tile);
+  painter.translate(-x0, -y0);
+
+  QString error;
+  if (!PaintCommands::Execute(&painter, job->commands, job->length,
+                              *job->resources, &error)) {
+    QMutexLocker locker(&job->lock);
+    if (job->error.isEmpty())
+      job->error = error;
+  }
+}
+
+static void RenderTiles(Job* job) {
+  int tiles = job->columns * job->rows;
+  int index;
+  while ((index = job->next.fetchAndAddOrdered(1)) < tiles)
+    RenderTile(job, index);
+}
+
+//
+// TileWorker
+// Renders tiles on the thread pool until none are left
+//
+class TileWorker : public QRunnable {
+ public:
+  TileWorker(Job* job, QSemaphore* done) : job_(job), done_(done) {}
+
+  void run() {
+    RenderTiles(job_);
+    done_->release();
+  }
+
+ private:
+  Job* job_;
+  QSemaphore* done_;
+};
+
+bool Render(const Target& target, const double* commands, int length,
+            const PaintCommands::Resources& resources, int columns,
+            int rows, int threads, QString* error) {
+  Job job;
+  job.target = target;
+  job.bytesPerPixel = QImage(1, 1, target.format).depth() / 8;
+  job.commands = commands;
+  job.length = length;
+  job.resources = &resources;
+  job.columns = qMax(1, columns);
+  job.rows = qMax(1, rows);
+
+  // Strings are only referenced by text commands
+  if (!resources.strings.isEmpty() &&
+      !QFontDatabase::supportsThreadedFontRendering())
+    threads = 1;
+  threads = qBound(1, threads, job.columns * job.rows);
+
+  QSemaphore done;
+  for (int i = 1; i < threads; i++)
+    QThreadPool::globalInstance()->start(new TileWorker(&job, &done));
+  RenderTiles(&job);
+  done.acquire(threads - 1);
+
+  if (!job.error.isEmpty()) {
+    *error = job.error;
+    return false;
+  }
+  return true;
+}
+
+} // namespace TiledRender
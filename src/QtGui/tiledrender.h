@@ -0,0 +1,65 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef TILEDRENDER_H
+#define TILEDRENDER_H
+
+#include <QImage>
+#include <QString>
+#include "paintcommands.h"
+
+//
+// TiledRender
+// Replays one batch of paint commands into an image split in
+// columns x rows tiles. Each tile is a QImage over the target's own pixels
+// with its own QPainter, so tiles are painted in parallel and need no
+// stitching. Tiles are handed out to up to threads threads, the calling
+// one included, from QThreadPool::globalInstance()
+//
+namespace TiledRender {
+
+struct Target {
+  uchar* bits;
+  int width;
+  int height;
+  int bytesPerLine;
+  QImage::Format format;
+};
+
+// Resources must not hold pixmaps, which can't be used outside the GUI
+// thread; convert them to images first. Text is rendered on one thread
+// where Qt can't render fonts from several. Returns false and sets error
+// on malformed commands, with the other tiles possibly painted
+bool Render(const Target& target, const double* commands, int length,
+            const PaintCommands::Resources& resources, int columns,
+            int rows, int threads, QString* error);
+
+} // namespace TiledRender
+
+#endif
@@ -29,13 +29,41 @@
 
 #define BUILDING_NODE_EXTENSION
 #include <node.h>
+#include <QApplication>
+#include <QMouseEvent>
 #include "../qt_v8.h"
 #include "../QtGui/qwidget.h"
 #include "qtesteventlist.h"
 
 using namespace v8;
 
+//
+// MouseMoveEvent
+// Delivers a move to the widget as if from the window system. Qt 4's
+// QTest moves the real cursor instead, which needs the pointer over the
+// widget and a round trip to the display
+//
+class MouseMoveEvent : public QTestEvent {
+ public:
+  MouseMoveEvent(const QPoint& pos, Qt::MouseButtons buttons)
+      : pos_(pos), buttons_(buttons) {}
+
+  void simulate(QWidget* w) {
+    QMouseEvent e(QEvent::MouseMove, pos_, w->mapToGlobal(pos_), Qt::NoButton,
+                  buttons_, Qt::NoModifier);
+    QSpontaneKeyEvent::setSpontaneous(&e);
+    QApplication::sendEvent(w, &e);
+  }
+
+  QTestEvent* clone() const { return new MouseMoveEvent(*this); }
+
+ private:
+  QPoint pos_;
+  Qt::MouseButtons buttons_;
+};
+
 Persistent<Function> QTestEventListWrap::constructor;
+Persistent<FunctionTemplate> QTestEventListWrap::constructor_template;
 
 QTestEventListWrap::QTestEventListWrap() {
   q_ = new QTestEventList();
@@ -48,12 +76,15 @@ QTestEventListWrap::~QTestEventListWrap() {
 void QTestEventListWrap::Initialize(Handle<Object> target) {
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  constructor_template = Persistent<FunctionTemplate>::New(tpl);
   tpl->SetClassName(String::NewSymbol("QTestEventList"));
   tpl->InstanceTemplate()->SetInternalFieldCount(1);  
 
   // Prototype
   tpl->PrototypeTemplate()->Set(String::NewSymbol("addMouseClick"),
       FunctionTemplate::New(AddMouseClick)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("addMouseMove"),
+      FunctionTemplate::New(AddMouseMove)->GetFunction());
   tpl->PrototypeTemplate()->Set(String::NewSymbol("addKeyPress"),
       FunctionTemplate::New(AddKeyPress)->GetFunction());
   tpl->PrototypeTemplate()->Set(String::NewSymbol("simulate"),
@@ -64,6 +95,10 @@ void QTestEventListWrap::Initialize(Handle<Object> target) {
   target->Set(String::NewSymbol("QTestEventList"), constructor);
 }
 
+bool QTestEventListWrap::HasInstance(Handle<Value> value) {
+  return value->IsObject() && constructor_template->HasInstance(value);
+}
+
 Handle<Value> QTestEventListWrap::New(const Arguments& args) {
   HandleScope scope;
 
@@ -84,6 +119,30 @@ Handle<Value> QTestEventListWrap::AddMouseClick(const Arguments& args) {
   return scope.Close(Undefined());
 }
 
+// Supported versions:
+//   addMouseMove(int x, int y, Qt::MouseButtons buttons = Qt::NoButton)
+//
+// QUIRK:
+// Here: the move is sent to the widget (see MouseMoveEvent); buttons are
+//   those held during the move
+// Qt: addMouseMove(QPoint pos, int delay = -1) moves the cursor
+Handle<Value> QTestEventListWrap::AddMouseMove(const Arguments& args) {
+  HandleScope scope;
+
+  QTestEventListWrap* w = ObjectWrap::Unwrap<QTestEventListWrap>(args.This());
+  QTestEventList* q = w->GetWrapped();
+
+  if (!args[0]->IsNumber() || !args[1]->IsNumber())
+    return ThrowException(Exception::TypeError(
+        String::New("QTestEventListWrap::AddMouseMove: bad arguments")));
+
+  q->append(new MouseMoveEvent(
+      QPoint(args[0]->IntegerValue(), args[1]->IntegerValue()),
+      Qt::MouseButtons(args[2]->IsNumber() ? args[2]->IntegerValue() : 0)));
+
+  return scope.Close(Undefined());
+}
+
 Handle<Value> QTestEventListWrap::AddKeyPress(const Arguments& args) {
   HandleScope scope;
 
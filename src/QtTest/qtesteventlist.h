@@ -37,16 +37,19 @@
 class QTestEventListWrap : public node::ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
+  static bool HasInstance(v8::Handle<v8::Value> value);
   QTestEventList* GetWrapped() const { return q_; };
 
  private:
   QTestEventListWrap();
   ~QTestEventListWrap();
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> constructor_template;
   static v8::Handle<v8::Value> New(const v8::Arguments& args);
 
   // Wrapped methods
   static v8::Handle<v8::Value> AddMouseClick(const v8::Arguments& args);
+  static v8::Handle<v8::Value> AddMouseMove(const v8::Arguments& args);
   static v8::Handle<v8::Value> AddKeyPress(const v8::Arguments& args);
   static v8::Handle<v8::Value> Simulate(const v8::Arguments& args);
 
@@ -49,6 +49,11 @@
 #include "QtGui/qsound.h"
 #include "QtGui/qscrollarea.h"
 #include "QtGui/qscrollbar.h"
+#include "QtGui/qpicture.h"
+#include "QtGui/renderbatch.h"
+#include "QtGui/imagecompare.h"
+#include "QtGui/tiledimagesource.h"
+#include "QtGui/surfacepool.h"
 
 #include "QtTest/qtesteventlist.h"
 
@@ -74,6 +79,11 @@ void Initialize(Handle<Object> target) {
   QSoundWrap::Initialize(target);
   QScrollAreaWrap::Initialize(target);
   QScrollBarWrap::Initialize(target);
+  QPictureWrap::Initialize(target);
+  RenderBatch::Initialize(target);
+  ImageCompare::Initialize(target);
+  TiledImageSourceWrap::Initialize(target);
+  SurfacePool::Initialize(target);
 }
 
 NODE_MODULE(qt, Initialize)
@@ -0,0 +1,75 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "qt_v8.h"
+
+using namespace v8;
+
+namespace qt_v8 {
+
+// Strings up to kInternedLength characters, in kInternedSlots slots
+static const int kInternedSlots = 128;
+static const int kInternedLength = 64;
+
+struct Interned {
+  Persistent<String> key;
+  QString value;
+};
+
+// Never freed: the cache lives as long as the process
+static Interned* interned = NULL;
+
+QString ToQStringInterned(Local<String> str) {
+  int length = str->Length();
+  if (length > kInternedLength)
+    return ToQString(str);
+
+  if (!interned)
+    interned = new Interned[kInternedSlots];
+
+  // node's V8 has no identity hash for strings: pick the slot from the
+  // length and first characters, then match by value with StrictEquals().
+  // It compares pointers first, so the same string object is matched
+  // without comparing contents; an equal but distinct string is matched
+  // too, after a character comparison
+  uint16_t head[2] = { 0, 0 };
+  str->Write(head, 0, 2, String::NO_NULL_TERMINATION);
+  Interned& entry = interned[(length * 31 + head[0] * 7 + head[1]) %
+                             kInternedSlots];
+
+  if (!entry.key.IsEmpty() && entry.key->StrictEquals(str))
+    return entry.value;
+
+  entry.key.Dispose();
+  entry.key = Persistent<String>::New(str);
+  entry.value = ToQString(str);
+  return entry.value;
+}
+
+} // namespace qt_v8
@@ -31,16 +31,110 @@
 #define QTV8_H
 
 #include <node.h>
+#include <node_buffer.h>
 #include <QString>
+#include <QByteArray>
 
 namespace qt_v8 {
 
+//
+// ToQString()
+// Copies a JS string once, straight into the QString's buffer. External
+// ASCII strings are widened from their one-byte data without a UTF-16
+// copy in between. Other strings V8 knows to be ASCII are read one byte
+// per character, which is half the bytes to write, and widened by
+// fromLatin1()
+//
 inline QString ToQString(v8::Local<v8::String> str) {
-  return QString::fromUtf16( *v8::String::Value(str) );
+  int length = str->Length();
+
+  if (str->IsExternalAscii()) {
+    const v8::String::ExternalAsciiStringResource* ascii =
+        str->GetExternalAsciiStringResource();
+    return QString::fromLatin1(ascii->data(), length);
+  }
+
+  if (!str->MayContainNonAscii()) {
+    QByteArray ascii;
+    ascii.resize(length);
+    str->WriteAscii(ascii.data(), 0, length,
+                    v8::String::NO_NULL_TERMINATION);
+    return QString::fromLatin1(ascii.constData(), length);
+  }
+
+  QString result;
+  result.resize(length);
+  str->Write(reinterpret_cast<uint16_t*>(result.data()), 0, length,
+             v8::String::NO_NULL_TERMINATION);
+  return result;
+}
+
+//
+// ToQStringInterned()
+// ToQString() for short strings passed over and over, e.g. labels given
+// to drawText() every frame. Recently seen strings are kept in a small
+// cache along with their QString. A string equal in value to a cached one
+// gets the cached QString, shared, instead of being converted again. See
+// qt_v8.cc
+//
+QString ToQStringInterned(v8::Local<v8::String> str);
+
+//
+// QStringResource
+// Lets a JS string use the UTF-16 data of a QString in place. QString is
+// implicitly shared, so creating one copies no characters; V8 disposes of
+// it when the string is collected
+//
+class QStringResource : public v8::String::ExternalStringResource {
+ public:
+  explicit QStringResource(const QString& str)
+      : str_(str), data_(reinterpret_cast<const uint16_t*>(str_.utf16())) {}
+  const uint16_t* data() const { return data_; }
+  size_t length() const { return str_.length(); }
+
+ private:
+  QString str_;
+  const uint16_t* data_;
+};
+
+// Shorter strings are cheaper to copy than to wrap
+static const int kExternalStringLength = 64;
+
+inline v8::Local<v8::String> FromQString(const QString& str) {
+  if (str.length() >= kExternalStringLength)
+    return v8::String::NewExternal(new QStringResource(str));
+  return v8::String::New(reinterpret_cast<const uint16_t*>(str.utf16()),
+                         str.length());
+}
+
+//
+// NewTypedArray()
+// Instantiates a JS typed array, e.g. NewTypedArray("Float64Array", n).
+// Its storage is reachable via GetIndexedPropertiesExternalArrayData()
+//
+inline v8::Local<v8::Object> NewTypedArray(const char* type, int length) {
+  v8::Local<v8::Function> ctor = v8::Local<v8::Function>::Cast(
+      v8::Context::GetCurrent()->Global()->Get(v8::String::NewSymbol(type)));
+  v8::Handle<v8::Value> argv[1] = { v8::Integer::New(length) };
+  return ctor->NewInstance(1, argv);
+}
+
+//
+// FromQByteArray()
+// Returns a Node Buffer over a copy of bytes. QByteArray is implicitly
+// shared, so the data itself is not copied; the Buffer holds a reference
+// until it is garbage collected
+//
+inline void FreeQByteArray(char* data, void* hint) {
+  delete static_cast<QByteArray*>(hint);
 }
 
-inline v8::Local<v8::String> FromQString(QString str) {
-  return v8::String::New( str.utf16() );
+inline v8::Local<v8::Object> FromQByteArray(const QByteArray& bytes) {
+  QByteArray* shared = new QByteArray(bytes);
+  node::Buffer* buffer = node::Buffer::New(
+      const_cast<char*>(shared->constData()), shared->size(),
+      FreeQByteArray, shared);
+  return v8::Local<v8::Object>::New(buffer->handle_);
 }
 
 } // namespace
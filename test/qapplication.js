@@ -0,0 +1,146 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+var assert = require('assert'),
+    qt = require('..');
+
+var app = new qt.QApplication();
+
+// exec() joins Node's event loop and returns right away; quit() detaches
+{
+  var returned = false;
+  app.exec();
+  returned = true;
+  assert.equal(returned, true);
+
+  // Qt events are delivered from Node's loop
+  var widget = new qt.QWidget();
+  var painted = false;
+  widget.paintEvent(function() {
+    painted = true;
+  });
+  widget.show();
+
+  setTimeout(function() {
+    assert.equal(painted, true);
+    widget.close();
+    app.quit(); // lets the test exit
+  }, 100);
+}
+
+// processEvents() still works for manual pumping
+{
+  app.processEvents();
+}
+
+// processEvents(maxtime, flags) - statistics
+{
+  var widget = new qt.QWidget();
+  widget.paintEvent(function() {});
+  widget.show();
+
+  var stats = app.processEvents(50, qt.ProcessEventsFlag.AllEvents);
+  assert.equal(typeof stats.delivered, 'number');
+  assert.equal(typeof stats.elapsed, 'number');
+  assert.equal(typeof stats.pending, 'boolean');
+  assert.ok(stats.delivered > 0);
+  assert.ok(stats.events[qt.EventType.Paint] > 0);
+
+  stats = app.processEvents(0, qt.ProcessEventsFlag.ExcludeUserInputEvents);
+  assert.ok(stats.elapsed >= 0);
+
+  widget.close();
+}
+
+// requestFrame() - frame clock
+{
+  assert.ok(Math.abs(app.frameInterval() - 1000/60) < 1e-6);
+  assert.throws(function() { app.setFrameInterval(0); }, RangeError);
+  app.setFrameInterval(10);
+  assert.equal(app.frameInterval(), 10);
+
+  var widget = new qt.QWidget();
+  var paints = 0, frames = 0;
+  widget.paintEvent(function() {
+    paints++;
+  });
+  widget.show();
+  app.processEvents();
+  paints = 0;
+
+  widget.requestFrame(function(timestamp) {
+    assert.equal(typeof timestamp, 'number');
+    frames++;
+
+    // Merged into the frame's single repaint
+    widget.update();
+    widget.update();
+  });
+  app.requestFrame(function() {
+    frames++;
+  });
+
+  setTimeout(function() {
+    assert.equal(frames, 2);
+    assert.equal(paints, 1);
+
+    var stats = app.frameStats();
+    assert.ok(stats.frames >= 1);
+    assert.equal(typeof stats.missed, 'number');
+    assert.equal(stats.pending, 0);
+
+    widget.close();
+  }, 100);
+}
+
+// Exceptions thrown by paint callbacks during a frame are reported
+{
+  var widget = new qt.QWidget();
+  var failing = false, caught = null;
+  widget.paintEvent(function() {
+    if (failing)
+      throw new Error('paint failed');
+  });
+  widget.show();
+  app.processEvents();
+
+  process.once('uncaughtException', function(err) {
+    caught = err;
+  });
+  failing = true;
+  widget.requestFrame(function() {
+    widget.update();
+  });
+
+  setTimeout(function() {
+    assert.ok(caught);
+    assert.equal(caught.message, 'paint failed');
+    widget.close();
+  }, 100);
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Headless mode needs its own process: only one QApplication may exist
+
+var assert = require('assert'),
+    fs = require('fs'),
+    qt = require('..');
+
+var app = new qt.QApplication({ headless: true });
+
+{
+  assert.equal(app.isHeadless(), true);
+
+  // Only client-side targets are available
+  assert.throws(function() { new qt.QWidget(); });
+  assert.throws(function() { new qt.QPixmap(10, 10); });
+  assert.throws(function() { new qt.QScrollArea(); });
+  assert.throws(function() { new qt.QScrollBar(); });
+}
+
+// Render a thumbnail from client memory
+{
+  var image = new qt.QImage(64, 64);
+  image.fill();
+
+  var painter = new qt.QPainter();
+  assert.equal(painter.begin(image), true);
+  painter.fillRect(8, 8, 48, 48, new qt.QColor(0, 0, 255, 125));
+  painter.drawText(4, 60, 'thumb');
+  painter.end();
+
+  if (fs.existsSync('__headless.png'))
+    fs.unlinkSync('__headless.png');
+  assert.equal(image.save('__headless.png'), true);
+  fs.unlinkSync('__headless.png');
+}
@@ -50,3 +50,633 @@ var app = new qt.QApplication();
   var image = new qt.QImage('BAD-FILE');
   assert.equal(image.isNull(), true);
 }
+
+// Constructor- size and format
+{
+  var image = new qt.QImage(40, 30);
+  assert.equal(image.isNull(), false);
+  assert.equal(image.width(), 40);
+  assert.equal(image.height(), 30);
+  assert.equal(image.format(), qt.ImageFormat.Format_ARGB32_Premultiplied);
+
+  image = new qt.QImage(8, 8, qt.ImageFormat.Format_RGB32);
+  assert.equal(image.format(), qt.ImageFormat.Format_RGB32);
+}
+
+// fill(), painting and save()
+{
+  var fs = require('fs');
+  var image = new qt.QImage(20, 20);
+  image.fill();
+  image.fill(qt.GlobalColor.red);
+  image.fill(new qt.QColor(0, 255, 0));
+
+  var painter = new qt.QPainter();
+  assert.equal(painter.begin(image), true);
+  painter.fillRect(0, 0, 10, 10, qt.GlobalColor.blue);
+  assert.equal(painter.end(), true);
+
+  if (fs.existsSync('__image.png'))
+    fs.unlinkSync('__image.png');
+  assert.equal(image.save('__image.png'), true);
+  assert.equal(new qt.QImage('__image.png').width(), 20);
+  fs.unlinkSync('__image.png');
+
+  assert.equal(image.save('__image.jpg', 'JPG', 80), true);
+  fs.unlinkSync('__image.jpg');
+}
+
+// fromBuffer() and bits() - zero copy
+{
+  var width = 4, height = 3, stride = width * 4;
+  var buffer = new Buffer(stride * height);
+  buffer.fill(0);
+
+  var image = qt.QImage.fromBuffer(buffer, width, height, stride,
+                                   qt.ImageFormat.Format_ARGB32);
+  assert.equal(image.width(), width);
+  assert.equal(image.height(), height);
+  assert.equal(image.bytesPerLine(), stride);
+  assert.equal(image.byteCount(), buffer.length);
+
+  // Painting on the image writes into the buffer
+  image.fill(new qt.QColor(255, 0, 0));
+  assert.equal(buffer.readUInt32LE(0), 0xffff0000);
+
+  // bits() shares the same memory
+  var bits = image.bits();
+  assert.equal(bits.length, buffer.length);
+  bits.writeUInt32LE(0xff0000ff, 0);
+  assert.equal(buffer.readUInt32LE(0), 0xff0000ff);
+
+  // Bad args
+  assert.throws(function() {
+    qt.QImage.fromBuffer('nope', 1, 1, 4, qt.ImageFormat.Format_ARGB32);
+  }, TypeError);
+  assert.throws(function() {
+    qt.QImage.fromBuffer(buffer, width, height + 1, stride,
+                         qt.ImageFormat.Format_ARGB32);
+  }, RangeError);
+  assert.throws(function() {
+    qt.QImage.fromBuffer(buffer, width, height, stride - 1,
+                         qt.ImageFormat.Format_ARGB32);
+  }, RangeError);
+}
+
+// bits() keeps the pixels alive
+{
+  var bits = new qt.QImage(16, 16).bits();
+  bits.fill(0xff);
+  assert.equal(bits.length, 16 * 16 * 4);
+
+  // Even when the image lets go of them
+  var image = new qt.QImage(16, 16, qt.ImageFormat.Format_ARGB32);
+  image.fill(new qt.QColor(255, 0, 0));
+  bits = image.bits();
+  image.convert(qt.ImageFormat.Format_ARGB32_Premultiplied, { inPlace: true });
+  image.dispose();
+  assert.equal(bits.readUInt32LE(0), 0xffff0000);
+  bits.writeUInt32LE(0, 0);
+
+}
+
+// bits() stays over the image's pixels: it sees later fills and paints,
+// and its writes show in the image
+{
+  var image = new qt.QImage(16, 16, qt.ImageFormat.Format_ARGB32);
+  image.fill(new qt.QColor(255, 0, 0));
+  var bits = image.bits();
+  image.fill(new qt.QColor(0, 0, 255));
+  assert.equal(bits.readUInt32LE(0), 0xff0000ff);
+
+  var painter = new qt.QPainter();
+  painter.begin(image);
+  painter.fillRect(0, 0, 1, 1, new qt.QColor(0, 255, 0));
+  painter.end();
+  assert.equal(bits.readUInt32LE(0), 0xff00ff00);
+
+  // Also with a pending encode, which gets its own copy
+  image.encode('PNG', function(err) {
+    assert.ifError(err);
+  });
+  image.fill(new qt.QColor(255, 0, 0));
+  assert.equal(bits.readUInt32LE(0), 0xffff0000);
+
+  bits.writeUInt32LE(0xff0000ff, 0);
+  var copy = image.convert(qt.ImageFormat.Format_ARGB32);
+  assert.equal(copy.bits().readUInt32LE(0), 0xff0000ff);
+}
+
+// convert() - vectorized conversions, odd width to cover the scalar tail
+{
+  var F = qt.ImageFormat;
+  var width = 5, height = 2, stride = width * 4;
+  var buffer = new Buffer(stride * height);
+  for (var i = 0; i < width * height; i++)
+    buffer.writeUInt32LE(0x80ff4020, i * 4); // half transparent
+
+  var image = qt.QImage.fromBuffer(buffer, width, height, stride,
+                                   F.Format_ARGB32);
+
+  var premul = image.convert(F.Format_ARGB32_Premultiplied);
+  assert.equal(premul.format(), F.Format_ARGB32_Premultiplied);
+  assert.equal(premul.bits().readUInt32LE(4 * 9), 0x80802010);
+
+  var back = premul.convert(F.Format_ARGB32);
+  assert.equal(back.format(), F.Format_ARGB32);
+  assert.equal(back.bits().readUInt32LE(4 * 9), 0x80ff4020);
+
+  var rgba = image.toRgbaBuffer();
+  assert.ok(Buffer.isBuffer(rgba));
+  assert.equal(rgba.length, width * height * 4);
+  assert.deepEqual([rgba[36], rgba[37], rgba[38], rgba[39]],
+                   [0xff, 0x40, 0x20, 0x80]);
+
+  var rgb16 = premul.convert(F.Format_RGB16);
+  assert.equal(rgb16.format(), F.Format_RGB16);
+  assert.equal(rgb16.bits().readUInt16LE(2 * 9), 0x8102);
+
+  var gray = image.convert(F.Format_Grayscale8);
+  assert.equal(gray.format(), F.Format_Indexed8);
+  assert.equal(gray.bits()[9], (0xff * 77 + 0x40 * 150 + 0x20 * 29) >> 8);
+
+  // In place: the buffer is converted, and the same object returned
+  assert.strictEqual(image.convert(F.Format_ARGB32_Premultiplied,
+                                   { inPlace: true }), image);
+  assert.equal(image.format(), F.Format_ARGB32_Premultiplied);
+  assert.equal(buffer.readUInt32LE(0), 0x80802010);
+
+  // In place on an image owning its pixels
+  var owned = new qt.QImage(width, height, F.Format_ARGB32_Premultiplied);
+  owned.fill(qt.GlobalColor.transparent);
+  owned.convert(F.Format_ARGB32, { inPlace: true });
+  owned.convert(F.Format_ARGB32_Premultiplied, { inPlace: true });
+  assert.equal(owned.format(), F.Format_ARGB32_Premultiplied);
+  assert.equal(owned.bits().readUInt32LE(0), 0);
+
+  // Other conversions go through Qt
+  assert.equal(image.convert(F.Format_RGB888).format(), F.Format_RGB888);
+
+  // Bad args
+  assert.throws(function() {
+    image.convert('RGBA');
+  }, TypeError);
+  assert.throws(function() {
+    image.convert(99);
+  }, RangeError);
+  assert.throws(function() {
+    image.convert(F.Format_RGB16, { inPlace: true });
+  }, RangeError);
+  assert.throws(function() {
+    image.convert(17); // RGBA bytes come from toRgbaBuffer()
+  }, RangeError);
+  assert.throws(function() {
+    new qt.QImage().convert(F.Format_ARGB32);
+  }, Error);
+  assert.throws(function() {
+    new qt.QImage().toRgbaBuffer();
+  }, Error);
+
+  // Not in place under an active painter
+  var painter = new qt.QPainter();
+  painter.begin(owned);
+  assert.throws(function() {
+    owned.convert(F.Format_ARGB32, { inPlace: true });
+  }, /painted/);
+  painter.end();
+  owned.convert(F.Format_ARGB32, { inPlace: true });
+}
+
+// Async work on in-place converted images sees the pixels it started with
+{
+  var F = qt.ImageFormat;
+  var pending = 2;
+  var image = new qt.QImage(4, 4, F.Format_ARGB32);
+  image.fill(new qt.QColor(0, 0, 255));
+  image.convert(F.Format_ARGB32_Premultiplied, { inPlace: true });
+
+  image.encode('PNG', function(err, png) {
+    assert.ifError(err);
+    qt.QImage.load(png, function(err, decoded) {
+      assert.ifError(err);
+      assert.equal(decoded.bits().readUInt32LE(0), 0xff0000ff);
+      pending--;
+    });
+  });
+  image.scaled(2, 2, function(err, small) {
+    assert.ifError(err);
+    assert.equal(small.convert(F.Format_ARGB32).bits().readUInt32LE(0),
+                 0xff0000ff);
+    pending--;
+  });
+
+  image.convert(F.Format_ARGB32, { inPlace: true });
+  image.fill(new qt.QColor(255, 0, 0));
+  image.dispose();
+
+  process.on('exit', function() {
+    assert.equal(pending, 0);
+  });
+}
+
+// load() - asynchronous decoding
+{
+  var fs = require('fs');
+  var pending = 4;
+  var done = function() {
+    pending--;
+  };
+
+  qt.QImage.load('resources/qimage.png', function(err, image) {
+    assert.ifError(err);
+    assert.equal(image.isNull(), false);
+    done();
+  });
+
+  qt.QImage.load(fs.readFileSync('resources/qimage.png'), {}, function(err, image) {
+    assert.ifError(err);
+    assert.equal(image.isNull(), false);
+    done();
+  });
+
+  qt.QImage.load('resources/qimage.png', {
+    scaledSize: { width: 10, height: 8 }
+  }, function(err, image) {
+    assert.ifError(err);
+    assert.equal(image.width(), 10);
+    assert.equal(image.height(), 8);
+    done();
+  });
+
+  qt.QImage.load('BAD-FILE', function(err, image) {
+    assert.ok(err instanceof Error);
+    assert.equal(image, undefined);
+    done();
+  });
+
+  assert.throws(function() {
+    qt.QImage.load('resources/qimage.png');
+  }, TypeError);
+
+  process.on('exit', function() {
+    assert.equal(pending, 0);
+  });
+}
+
+// encode() and saveAsync() - asynchronous encoding
+{
+  var fs = require('fs');
+  var pending = 3;
+  var image = new qt.QImage(32, 32);
+  image.fill(qt.GlobalColor.red);
+
+  image.encode('PNG', function(err, buffer) {
+    assert.ifError(err);
+    assert.ok(Buffer.isBuffer(buffer));
+    assert.equal(buffer.toString('ascii', 1, 4), 'PNG');
+    pending--;
+  });
+
+  image.encode('JPG', { quality: 10 }, function(err, low) {
+    assert.ifError(err);
+    image.encode('JPG', { quality: 95 }, function(err, high) {
+      assert.ifError(err);
+      assert.ok(low.length <= high.length);
+      pending--;
+    });
+  });
+
+  image.saveAsync('__image-async.png', function(err) {
+    assert.ifError(err);
+    assert.equal(new qt.QImage('__image-async.png').width(), 32);
+    fs.unlinkSync('__image-async.png');
+    pending--;
+  });
+
+  // Images over a buffer are encoded as they were when encode() was called
+  var pixels = new Buffer(4 * 4 * 4);
+  pixels.fill(0xff);
+  var view = qt.QImage.fromBuffer(pixels, 4, 4, 16,
+                                  qt.ImageFormat.Format_ARGB32);
+  pending++;
+  view.encode('PNG', function(err, png) {
+    assert.ifError(err);
+    qt.QImage.load(png, function(err, decoded) {
+      assert.ifError(err);
+      assert.equal(decoded.bits().readUInt32LE(0), 0xffffffff);
+      pending--;
+    });
+  });
+  pixels.fill(0);
+
+  assert.throws(function() {
+    image.encode('PNG');
+  }, TypeError);
+
+  process.on('exit', function() {
+    assert.equal(pending, 0);
+  });
+}
+
+// scaled() - synchronous and asynchronous resampling
+{
+  var pending = 1;
+  var image = new qt.QImage(64, 48, qt.ImageFormat.Format_RGB32);
+  image.fill(new qt.QColor(40, 80, 120));
+
+  // A flat color stays flat with every filter and any number of threads
+  for (var filter = qt.ScaleFilter.Box; filter <= qt.ScaleFilter.Lanczos3;
+       filter++) {
+    for (var threads = 1; threads <= 3; threads += 2) {
+      var small = image.scaled(16, 12, { filter: filter, threads: threads });
+      assert.equal(small.width(), 16);
+      assert.equal(small.height(), 12);
+      assert.equal(small.format(), qt.ImageFormat.Format_RGB32);
+      assert.equal(small.bits().readUInt32LE(4 * 50), 0xff285078);
+    }
+  }
+
+  // Upscaling, and non-RGB32 sources come back premultiplied
+  var big = image.convert(qt.ImageFormat.Format_ARGB32).scaled(100, 3);
+  assert.equal(big.format(), qt.ImageFormat.Format_ARGB32_Premultiplied);
+  assert.equal(big.bits().readUInt32LE(4 * 250), 0xff285078);
+
+  image.scaled(8, 6, { filter: qt.ScaleFilter.Lanczos3 }, function(err, s) {
+    assert.ifError(err);
+    assert.equal(s.width(), 8);
+    assert.equal(s.bits().readUInt32LE(0), 0xff285078);
+    pending--;
+  });
+
+  // Bad args
+  assert.throws(function() {
+    image.scaled('big', 1);
+  }, TypeError);
+  assert.throws(function() {
+    image.scaled(0, 10);
+  }, RangeError);
+  assert.throws(function() {
+    image.scaled(10, 10, { filter: 7 });
+  }, RangeError);
+
+  process.on('exit', function() {
+    assert.equal(pending, 0);
+  });
+}
+
+// qt.compareImages() - odd width to cover the scalar tail
+{
+  var F = qt.ImageFormat;
+  var width = 7, height = 3, stride = width * 4;
+  var buffer = new Buffer(stride * height);
+  for (var i = 0; i < width * height; i++)
+    buffer.writeUInt32LE(0xff204080, i * 4);
+
+  var a = qt.QImage.fromBuffer(buffer, width, height, stride, F.Format_ARGB32);
+  var b = a.convert(F.Format_RGB32);
+
+  var same = qt.compareImages(a, b, { ssim: true });
+  assert.equal(same.mismatched, 0);
+  assert.equal(same.maxDelta, 0);
+  assert.equal(same.bounds, null);
+  assert.equal(same.ssim, 1);
+
+  // One pixel off by 3 in blue, one off by 40 in alpha. In a copy of the
+  // buffer: a views it
+  var edited = new Buffer(buffer);
+  edited.writeUInt32LE(0xff204083, (1 * width + 2) * 4);
+  edited.writeUInt32LE(0xd7204080, (2 * width + 6) * 4);
+  var c = qt.QImage.fromBuffer(edited, width, height, stride, F.Format_ARGB32);
+
+  var result = qt.compareImages(a, c, { diff: true, ssim: true });
+  assert.equal(result.mismatched, 2);
+  assert.equal(result.maxDelta, 40);
+  assert.deepEqual(result.bounds, { x: 2, y: 1, width: 5, height: 2 });
+  assert.equal(result.diff.width(), width);
+  assert.equal(result.diff.bits().readUInt32LE((1 * width + 2) * 4),
+               0xffff0000);
+  assert.ok(result.ssim < 1);
+
+  result = qt.compareImages(a, c, { tolerance: 3, ignoreAlpha: true });
+  assert.equal(result.mismatched, 0);
+  assert.equal(result.maxDelta, 3);
+
+  // Bad args
+  assert.throws(function() {
+    qt.compareImages(a, {});
+  }, TypeError);
+  assert.throws(function() {
+    qt.compareImages(a, new qt.QImage(8, 3));
+  }, RangeError);
+}
+
+// TiledImageSource - tiles decoded on demand, 600x400 in 128px tiles
+{
+  var fs = require('fs');
+  var F = qt.ImageFormat;
+  var tilesPending = 0;
+
+  var image = new qt.QImage(600, 400, F.Format_ARGB32_Premultiplied);
+  var painter = new qt.QPainter();
+  painter.begin(image);
+  painter.fillRect(0, 0, 300, 400, new qt.QColor(0, 0, 255));
+  painter.fillRect(300, 0, 300, 400, new qt.QColor(0, 255, 0));
+  painter.fillRect(250, 150, 100, 100, new qt.QColor(255, 0, 0));
+  painter.end();
+  assert.equal(image.save('__tiled.png'), true);
+
+  var source = new qt.TiledImageSource('__tiled.png', { tileSize: 128 });
+  assert.equal(source.isNull(), false);
+  assert.equal(source.width(), 600);
+  assert.equal(source.height(), 400);
+  assert.equal(source.tileSize(), 128);
+  assert.equal(source.levels(), 4); // 600, 300, 150, 75 wide
+  assert.equal(source.cacheCost(), 0);
+
+  var target = new qt.QImage(600, 400, F.Format_ARGB32_Premultiplied);
+  var draw = function() {
+    var p = new qt.QPainter();
+    p.begin(target);
+    var missing = source.draw(p, 0, 0, 600, 400);
+    p.end();
+    return missing;
+  };
+
+  // Nothing cached yet: all 5x4 tiles are missing
+  assert.equal(draw(), 20);
+
+  tilesPending++;
+  source.tileReady(function() {
+    if (draw() > 0)
+      return;
+    source.tileReady(null);
+
+    assert.equal(qt.compareImages(target, image).mismatched, 0);
+    assert.ok(source.cacheCost() >= 600 * 400 * 4);
+    if (--tilesPending === 0)
+      fs.unlinkSync('__tiled.png');
+  });
+
+  // A cache just big enough for the shown tiles settles without prefetch
+  var cap = 20 * 128 * 128 * 4;
+  var tight = new qt.TiledImageSource('__tiled.png', { tileSize: 128,
+                                                       cacheSize: cap });
+  var drawTight = function() {
+    var p = new qt.QPainter();
+    p.begin(target);
+    var missing = tight.draw(p, 0, 0, 600, 400);
+    p.end();
+    return missing;
+  };
+  assert.equal(drawTight(), 20);
+
+  tilesPending++;
+  tight.tileReady(function() {
+    if (drawTight() > 0)
+      return;
+    tight.tileReady(null);
+
+    assert.ok(tight.cacheCost() <= cap);
+    if (--tilesPending === 0)
+      fs.unlinkSync('__tiled.png');
+  });
+
+  // Unreadable files give a null source
+  var bad = new qt.TiledImageSource('BAD-FILE');
+  assert.equal(bad.isNull(), true);
+  assert.equal(bad.levels(), 0);
+
+  // Bad args
+  assert.throws(function() {
+    new qt.TiledImageSource();
+  }, TypeError);
+  assert.throws(function() {
+    new qt.TiledImageSource('__tiled.png', { tileSize: 8 });
+  }, RangeError);
+  assert.throws(function() {
+    new qt.TiledImageSource('__tiled.png', { cacheSize: 0 });
+  }, RangeError);
+  assert.throws(function() {
+    new qt.TiledImageSource('__tiled.png', { tileSize: 128,
+                                             cacheSize: 128 * 128 * 4 - 1 });
+  }, RangeError);
+  assert.throws(function() {
+    source.draw({}, 0, 0, 10, 10);
+  }, TypeError);
+
+  process.on('exit', function() {
+    assert.equal(tilesPending, 0);
+  });
+}
+
+// dispose()
+{
+  var image = new qt.QImage(20, 20);
+  image.dispose();
+  image.dispose(); // no-op
+
+  assert.throws(function() {
+    image.width();
+  }, /disposed/);
+  assert.throws(function() {
+    image.bits();
+  }, /disposed/);
+
+  // Other methods see a null image
+  var painter = new qt.QPainter();
+  assert.equal(painter.begin(image), false);
+
+  // Releases the buffer of fromBuffer() images
+  var buffer = new Buffer(4 * 4 * 4);
+  var view = qt.QImage.fromBuffer(buffer, 4, 4, 16,
+                                  qt.ImageFormat.Format_RGB32);
+  view.dispose();
+  assert.throws(function() {
+    view.isNull();
+  }, /disposed/);
+
+  // Pending encodes and scales keep their own copy of the pixels
+  var pending = 2;
+  var pixels = new Buffer(4 * 4 * 4);
+  pixels.fill(0xff);
+  var source = qt.QImage.fromBuffer(pixels, 4, 4, 16,
+                                    qt.ImageFormat.Format_ARGB32);
+  source.encode('PNG', function(err, png) {
+    assert.ifError(err);
+    qt.QImage.load(png, function(err, decoded) {
+      assert.ifError(err);
+      assert.equal(decoded.bits().readUInt32LE(0), 0xffffffff);
+      pending--;
+    });
+  });
+  source.scaled(2, 2, function(err, small) {
+    assert.ifError(err);
+    assert.equal(small.bits().readUInt32LE(0), 0xffffffff);
+    pending--;
+  });
+  source.dispose();
+  pixels.fill(0);
+
+  process.on('exit', function() {
+    assert.equal(pending, 0);
+  });
+
+  // Not while a painter is active on it
+  var painted = new qt.QImage(20, 20);
+  painter.begin(painted);
+  assert.throws(function() {
+    painted.dispose();
+  }, Error);
+  painter.end();
+  painted.dispose();
+}
+
+// qt.SurfacePool - recycled images
+{
+  var F = qt.ImageFormat;
+  var pool = qt.SurfacePool;
+  var size = 64 * 32 * 4;
+  pool.clear();
+  var before = pool.stats();
+
+  var a = pool.image(64, 32);
+  assert.equal(a.width(), 64);
+  assert.equal(a.format(), F.Format_ARGB32_Premultiplied);
+  a.bits().writeUInt32LE(0x12345678, 0);
+  a.dispose();
+  assert.equal(pool.stats().surfaces, 1);
+  assert.equal(pool.stats().bytes, size);
+
+  // Same pixels come back for the same size and format
+  var b = pool.image(64, 32);
+  assert.equal(b.bits().readUInt32LE(0), 0x12345678);
+  assert.equal(pool.stats().hits, before.hits + 1);
+  assert.equal(pool.stats().misses, before.misses + 1);
+  assert.equal(pool.stats().surfaces, 0);
+
+  var c = pool.image(64, 32, F.Format_RGB32);
+  assert.equal(c.format(), F.Format_RGB32);
+  assert.equal(pool.stats().misses, before.misses + 2);
+
+  // Least recently released surfaces go first over capacity
+  var capacity = pool.capacity();
+  pool.setCapacity(size);
+  b.dispose();
+  c.dispose();
+  assert.equal(pool.stats().surfaces, 1);
+  assert.equal(pool.stats().evictions, before.evictions + 1);
+  assert.equal(pool.image(64, 32, F.Format_RGB32).format(), F.Format_RGB32);
+  assert.equal(pool.stats().hits, before.hits + 2);
+  pool.setCapacity(capacity);
+
+  // Bad args
+  assert.throws(function() {
+    pool.image(0, 10);
+  }, RangeError);
+  assert.throws(function() {
+    pool.image(10, 10, 99);
+  }, RangeError);
+  assert.throws(function() {
+    pool.setCapacity(-1);
+  }, RangeError);
+}
@@ -94,6 +94,308 @@ var width = 100, height = 100;
                  // get GC'd before painter is done (segfault!)
 }
 
+// drawPixmap() - look-alike arg is rejected, not unwrapped
+{
+  function QPixmap() {}
+  var pixmap1 = new qt.QPixmap(100, 100);
+  var painter = new qt.QPainter();
+  painter.begin(pixmap1);
+  assert.throws(function() {
+    painter.drawPixmap(0, 0, new QPixmap());
+  }, TypeError);
+  painter.end();
+}
+
+// submit() - command buffer renders like per-call painting
+{
+  var image = new qt.QImage('resources/qimage.png');
+  var pixmap1 = new qt.QPixmap(width, height);
+  var pixmap2 = new qt.QPixmap(width, height);
+  var painter = new qt.QPainter();
+
+  pixmap1.fill();
+  painter.begin(pixmap1);
+  painter.fillRect(0, 0, 30, 30, new qt.QColor(0, 255, 0));
+  painter.fillRect(15, 15, 45, 45, new qt.QColor(0, 0, 255, 125));
+  painter.drawImage(20, 20, image);
+  painter.drawText(0, 20, "hello");
+  painter.end();
+
+  var cmd = new qt.PaintCommandBuffer(4); // forces growth
+  cmd.fillRect(0, 0, 30, 30, 0xff00ff00)
+     .fillRect(15, 15, 45, 45, 0x7d0000ff)
+     .drawImage(20, 20, image)
+     .drawText(0, 20, "hello");
+  assert.deepEqual(cmd.strings, ['hello']);
+  assert.equal(cmd.images.length, 1);
+
+  pixmap2.fill();
+  painter.begin(pixmap2);
+  painter.submit(cmd);
+  painter.end();
+
+  pixmap1.save('img-test/painter-submit-percall.png');
+  pixmap2.save('img-test/painter-submit-batch.png');
+  assert.equal(fs.readFileSync('img-test/painter-submit-batch.png').toString(),
+               fs.readFileSync('img-test/painter-submit-percall.png').toString());
+
+  // Malformed input
+  painter.begin(pixmap2);
+  assert.throws(function() {
+    painter.submit(new Float64Array([999]));
+  }, RangeError);
+  assert.throws(function() {
+    painter.submit(new Float64Array([qt.PaintCommandBuffer.Op.FillRect, 0]));
+  }, RangeError);
+  assert.throws(function() {
+    painter.submit(new Float64Array([qt.PaintCommandBuffer.Op.DrawText, 0, 0, 3]), 4, []);
+  }, RangeError);
+  [ NaN, -1, 1.5, Infinity ].forEach(function(opcode) {
+    assert.throws(function() {
+      painter.submit(new Float64Array([opcode]));
+    }, /opcode/);
+  });
+  [ NaN, -1, 0x100000000 ].forEach(function(argb) {
+    assert.throws(function() {
+      painter.submit(new Float64Array([qt.PaintCommandBuffer.Op.SetBrush, argb]));
+    }, /invalid operand/);
+    assert.throws(function() {
+      painter.submit(new Float64Array([qt.PaintCommandBuffer.Op.FillRect,
+                                       0, 0, 1, 1, argb]));
+    }, /invalid operand/);
+  });
+  painter.end();
+}
+
+// Numeric overloads of fillRect(), setPen() and setFont() render like the
+// command buffer
+{
+  var F = qt.ImageFormat;
+  var batch = new qt.QImage(64, 64, F.Format_ARGB32_Premultiplied);
+  var direct = new qt.QImage(64, 64, F.Format_ARGB32_Premultiplied);
+  var painter = new qt.QPainter();
+
+  var cmd = new qt.PaintCommandBuffer();
+  cmd.fillRect(0, 0, 30, 30, 0xff00ff00)
+     .fillRect(15, 15, 45, 45, 0x7d0000ff)
+     .setPen(0xffff0000, 1)
+     .setFont('Arial', 16)
+     .drawText(5, 50, 'Hi');
+  batch.fill();
+  painter.begin(batch);
+  painter.submit(cmd);
+  painter.end();
+
+  direct.fill();
+  painter.begin(direct);
+  painter.fillRect(0, 0, 30, 30, 0xff00ff00);
+  painter.fillRect(15, 15, 45, 45, 0x7d0000ff);
+  painter.setPen(0xffff0000, 1);
+  painter.setFont('Arial', 16);
+  painter.setFont('Arial', 16); // from the cache
+  painter.drawText(5, 50, 'Hi');
+  painter.end();
+
+  assert.equal(qt.compareImages(batch, direct).mismatched, 0);
+
+  // Small numbers are still Qt::GlobalColor
+  painter.begin(direct);
+  painter.fillRect(0, 0, 1, 1, qt.GlobalColor.red);
+  painter.end();
+  assert.equal(direct.convert(F.Format_ARGB32).bits().readUInt32LE(0),
+               0xffff0000);
+}
+
+// drawText() with repeated labels draws the label passed, not a cached one
+// that looks alike
+{
+  var F = qt.ImageFormat;
+  var a = new qt.QImage(64, 32, F.Format_ARGB32_Premultiplied);
+  var b = new qt.QImage(64, 32, F.Format_ARGB32_Premultiplied);
+  var painter = new qt.QPainter();
+  var labels = ['hello', 'help!', 'hello'];
+  var images = [a, b, a];
+
+  for (var i = 0; i < labels.length; i++) {
+    images[i].fill();
+    painter.begin(images[i]);
+    painter.drawText(0, 20, labels[i]);
+    painter.end();
+  }
+
+  b.fill();
+  painter.begin(b);
+  painter.drawText(0, 20, 'hel' + 'lo'); // equal, but a different string
+  painter.end();
+  assert.equal(qt.compareImages(a, b).mismatched, 0);
+
+  b.fill();
+  painter.begin(b);
+  painter.drawText(0, 20, 'hellp');
+  painter.end();
+  assert.ok(qt.compareImages(a, b).mismatched > 0);
+}
+
+// renderTiled() - tiles painted in parallel match a single painter
+{
+  var pending = 1;
+  var image = new qt.QImage('resources/qimage.png');
+  var pixmap = new qt.QPixmap(10, 10);
+  pixmap.fill(new qt.QColor(255, 0, 255));
+
+  var cmd = new qt.PaintCommandBuffer();
+  cmd.fillRect(0, 0, 30, 30, 0xff00ff00)
+     .fillRect(15, 15, 45, 45, 0x7d0000ff)
+     .setPen(0xffff0000, 1)
+     .drawLine(0, 99, 99, 0)
+     .translate(7, 3)
+     .drawImage(20, 20, image)
+     .drawPixmap(50, 50, pixmap); // painted from a converted image
+
+  var single = new qt.QImage(100, 100);
+  var tiled = new qt.QImage(100, 100);
+  single.fill();
+  tiled.fill();
+
+  var painter = new qt.QPainter();
+  painter.begin(single);
+  painter.submit(cmd);
+  painter.end();
+
+  // Uneven grid: tiles of different sizes
+  qt.QPainter.renderTiled(tiled, cmd, { columns: 3, rows: 7, threads: 4 });
+  assert.equal(tiled.bits().toString('hex'), single.bits().toString('hex'));
+
+  var async = new qt.QImage(100, 100);
+  async.fill();
+  qt.QPainter.renderTiled(async, cmd, function(err) {
+    assert.ifError(err);
+    assert.equal(async.bits().toString('hex'), single.bits().toString('hex'));
+    pending--;
+  });
+
+  // The image can't be touched until the render is done
+  assert.throws(function() {
+    async.dispose();
+  }, /being rendered/);
+  assert.throws(function() {
+    async.convert(qt.ImageFormat.Format_ARGB32, { inPlace: true });
+  }, /being rendered/);
+  assert.throws(function() {
+    new qt.QPainter().begin(async);
+  }, /being rendered/);
+  assert.throws(function() {
+    qt.QPainter.renderTiled(async, cmd, function() {});
+  }, /being rendered/);
+  assert.equal(async.width(), 100);
+
+  // Bad args
+  assert.throws(function() {
+    qt.QPainter.renderTiled(new qt.QPixmap(10, 10), cmd);
+  }, TypeError);
+  assert.throws(function() {
+    qt.QPainter.renderTiled(tiled, cmd, { columns: 0 });
+  }, RangeError);
+  assert.throws(function() {
+    qt.QPainter.renderTiled(tiled, new Float64Array([999]));
+  }, RangeError);
+
+  process.on('exit', function() {
+    assert.equal(pending, 0);
+  });
+}
+
+// qt.renderBatch() - independent images rendered and encoded off-thread
+{
+  var pending = 1;
+  var cmd = new qt.PaintCommandBuffer();
+  cmd.fillRect(0, 0, 10, 10, 0xff0000ff);
+
+  var picture = new qt.QPicture();
+  var painter = new qt.QPainter();
+  painter.begin(picture);
+  painter.fillRect(0, 0, 8, 8, new qt.QColor(0, 255, 0));
+  painter.end();
+
+  // Replayed on the main thread: pixmaps can't be used by workers
+  var pixmap = new qt.QPixmap(4, 4);
+  pixmap.fill(new qt.QColor(255, 0, 0));
+  var pixmapPicture = new qt.QPicture();
+  painter.begin(pixmapPicture);
+  painter.drawPixmap(0, 0, pixmap);
+  painter.end();
+
+  // Likewise for pixmaps in brushes
+  var texturePicture = new qt.QPicture();
+  painter.begin(texturePicture);
+  painter.fillRect(0, 0, 4, 4, new qt.QBrush(pixmap));
+  painter.end();
+
+  var jobs = [
+    { width: 20, height: 10, commands: cmd, background: 0xffffffff },
+    { width: 8, height: 8, picture: picture, format: 'JPG', quality: 90 },
+    { width: 4, height: 4, commands: cmd, format: 'NO-SUCH-FORMAT' },
+    { width: 4, height: 4, commands: new qt.PaintCommandBuffer(),
+      background: 0x80ff0000 },
+    { width: 4, height: 4, picture: pixmapPicture },
+    { width: 4, height: 4, picture: texturePicture }
+  ];
+
+  qt.renderBatch(jobs, { threads: 2 }, function(err, buffers) {
+    assert.ok(err instanceof Error);
+    assert.ok(/job 2/.test(err.message));
+    assert.equal(buffers.length, 6);
+    assert.equal(buffers[0].toString('ascii', 1, 4), 'PNG');
+    assert.equal(buffers[1][0], 0xff); // JPEG SOI
+    assert.equal(buffers[1][1], 0xd8);
+    assert.strictEqual(buffers[2], null);
+
+    qt.QImage.load(buffers[0], function(err, image) {
+      assert.ifError(err);
+      assert.equal(image.width(), 20);
+      var pixels = image.convert(qt.ImageFormat.Format_ARGB32).bits();
+      assert.equal(pixels.readUInt32LE(0), 0xff0000ff);
+      assert.equal(pixels.readUInt32LE(15 * 4), 0xffffffff);
+      pending--;
+    });
+
+    // Translucent backgrounds are premultiplied before filling
+    pending++;
+    qt.QImage.load(buffers[3], function(err, image) {
+      assert.ifError(err);
+      var pixels = image.convert(qt.ImageFormat.Format_ARGB32).bits();
+      assert.equal(pixels.readUInt32LE(0), 0x80ff0000);
+      pending--;
+    });
+
+    [4, 5].forEach(function(i) {
+      pending++;
+      qt.QImage.load(buffers[i], function(err, image) {
+        assert.ifError(err);
+        var pixels = image.convert(qt.ImageFormat.Format_ARGB32).bits();
+        assert.equal(pixels.readUInt32LE(0), 0xffff0000);
+        pending--;
+      });
+    });
+  });
+
+  // Bad args
+  assert.throws(function() {
+    qt.renderBatch({}, function() {});
+  }, TypeError);
+  assert.throws(function() {
+    qt.renderBatch([{ width: 0, height: 5, commands: cmd }], function() {});
+  }, RangeError);
+  assert.throws(function() {
+    qt.renderBatch([{ width: 5, height: 5,
+                      commands: new Float64Array([999]) }], function() {});
+  }, RangeError);
+
+  process.on('exit', function() {
+    assert.equal(pending, 0);
+  });
+}
+
 // strokePath() - crash test
 {
   var pixmap1 = new qt.QPixmap(100, 100);
@@ -59,6 +59,21 @@ var app = new qt.QApplication();
   assert.equal(point.y(), 2);
 }
 
+// moveTo(x, y) and lineTo(x, y)
+{
+  var path = new qt.QPainterPath;
+  path.moveTo(10, 20.5);
+  assert.equal(path.currentPosition().x(), 10);
+  assert.equal(path.currentPosition().y(), 20.5);
+  path.lineTo(-3, 4);
+  assert.equal(path.currentPosition().x(), -3);
+  assert.equal(path.currentPosition().y(), 4);
+
+  assert.throws(function() {
+    path.lineTo(1);
+  }, TypeError);
+}
+
 // closeSubpath
 {
   var path = new qt.QPainterPath;
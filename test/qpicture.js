@@ -0,0 +1,101 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+var assert = require('assert'),
+    fs = require('fs'),
+    qt = require('..'),
+    test = require('./test'); // creates img-test/
+
+var app = new qt.QApplication();
+
+// Constructor
+{
+  var picture = new qt.QPicture();
+  assert.equal(picture.isNull(), true);
+  assert.equal(picture.size(), 0);
+}
+
+// Recording
+{
+  var picture = new qt.QPicture();
+  var painter = new qt.QPainter();
+  assert.equal(painter.begin(picture), true);
+  painter.fillRect(0, 0, 30, 40, qt.GlobalColor.blue);
+  painter.drawText(0, 20, "hello");
+  assert.equal(painter.end(), true);
+
+  assert.equal(picture.isNull(), false);
+  assert.ok(picture.size() > 0);
+  assert.equal(picture.width(), 30);
+  assert.equal(picture.height(), 40);
+}
+
+// Replay and serialization
+{
+  var picture = new qt.QPicture();
+  var painter = new qt.QPainter();
+  painter.begin(picture);
+  painter.fillRect(0, 0, 10, 10, qt.GlobalColor.red);
+  painter.fillRect(10, 10, 10, 10, new qt.QColor(0, 0, 255, 125));
+  painter.end();
+
+  var buffer = picture.data();
+  assert.ok(Buffer.isBuffer(buffer));
+  assert.equal(buffer.length, picture.size());
+
+  var restored = qt.QPicture.fromBuffer(buffer);
+  assert.equal(restored.size(), picture.size());
+
+  var pixmap1 = new qt.QPixmap(50, 50);
+  var pixmap2 = new qt.QPixmap(50, 50);
+  pixmap1.fill();
+  pixmap2.fill();
+
+  painter.begin(pixmap1);
+  painter.drawPicture(5, 5, picture);
+  painter.end();
+  painter.begin(pixmap2);
+  painter.drawPicture(5, 5, restored);
+  painter.end();
+
+  pixmap1.save('img-test/picture-replay.png');
+  pixmap2.save('img-test/picture-replay-restored.png');
+  assert.equal(fs.readFileSync('img-test/picture-replay.png').toString(),
+               fs.readFileSync('img-test/picture-replay-restored.png').toString());
+}
+
+// fromBuffer() - bad args
+{
+  assert.throws(function() {
+    qt.QPicture.fromBuffer('nope');
+  }, TypeError);
+  assert.throws(function() {
+    qt.QPicture.fromBuffer(new Buffer('not a picture'));
+  });
+}
@@ -66,3 +66,76 @@ var app = new qt.QApplication();
     pixmap.fill(new qt.QColor(255, 0, 0));
   });
 }
+
+// save() with format and quality, toImage()
+{
+  var pixmap = new qt.QPixmap(10, 10);
+  pixmap.fill();
+  assert.equal(pixmap.save('__pixmap.jpg', 'JPG', 50), true);
+  fs.unlinkSync('__pixmap.jpg');
+
+  var image = pixmap.toImage();
+  assert.equal(image.width(), 10);
+  assert.equal(image.height(), 10);
+}
+
+// scaled()
+{
+  var pixmap = new qt.QPixmap(40, 40);
+  pixmap.fill(new qt.QColor(255, 0, 0));
+
+  var small = pixmap.scaled(10, 5, { filter: qt.ScaleFilter.Box });
+  assert.equal(small.width(), 10);
+  assert.equal(small.height(), 5);
+  assert.equal(small.toImage().convert(qt.ImageFormat.Format_RGB32)
+                   .bits().readUInt32LE(0), 0xffff0000);
+
+  assert.throws(function() {
+    pixmap.scaled(-1, 5);
+  }, RangeError);
+}
+
+// dispose()
+{
+  var pixmap = new qt.QPixmap(20, 20);
+  pixmap.fill();
+  pixmap.dispose();
+  pixmap.dispose(); // no-op
+
+  assert.throws(function() {
+    pixmap.width();
+  }, /disposed/);
+  assert.throws(function() {
+    pixmap.toImage();
+  }, /disposed/);
+
+  // Not while a painter is active on it
+  var painted = new qt.QPixmap(20, 20);
+  var painter = new qt.QPainter();
+  painter.begin(painted);
+  assert.throws(function() {
+    painted.dispose();
+  }, Error);
+  painter.end();
+  painted.dispose();
+}
+
+// qt.SurfacePool - recycled pixmaps
+{
+  var pool = qt.SurfacePool;
+  pool.clear();
+  var hits = pool.stats().hits;
+
+  var pixmap = pool.pixmap(30, 20);
+  assert.equal(pixmap.width(), 30);
+  pixmap.dispose();
+
+  var again = pool.pixmap(30, 20);
+  assert.equal(again.height(), 20);
+  assert.equal(pool.stats().hits, hits + 1);
+
+  again.dispose();
+  assert.equal(pool.stats().surfaces, 1);
+  pool.clear();
+  assert.equal(pool.stats().bytes, 0);
+}
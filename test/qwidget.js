@@ -57,6 +57,19 @@ var app = new qt.QApplication();
   widget.close();
 }
 
+// Strings round trip through objectName(), short or long, ASCII or not
+{
+  var widget = new qt.QWidget();
+  var long = new Array(201).join('name-');
+  [ '', 'a', 'caf\u00e9', '\u65e5\u672c\u8a9e', long, long + '\u00e9',
+    'cons-' + long ]
+    .forEach(function(name) {
+      widget.setObjectName(name);
+      assert.equal(widget.objectName(), name);
+    });
+  widget.close();
+}
+
 {
   var widget = new qt.QWidget();
 
@@ -130,3 +143,166 @@ var app = new qt.QApplication();
   assert.equal(capturedEvents[4].text(), 'a'); // keypress
   assert.equal(capturedEvents[5].key(), qt.Key.Key_Left); // keypress
 }
+
+// Coalesced mouse moves
+{
+  var widget = new qt.QWidget;
+  var delivered = [];
+
+  widget.setMouseTracking(true);
+  widget.mousePressEvent(function(e) {
+    delivered.push('press');
+  });
+  widget.mouseMoveEvent(function(e) {
+    delivered.push('move');
+  });
+
+  assert.throws(function() {
+    widget.coalescedMouseMoveEvent(function() {}, 0);
+  }, RangeError);
+
+  widget.coalescedMouseMoveEvent(function(samples, count) {
+    assert.ok(samples instanceof Float64Array);
+    assert.equal(samples.length, count * 5);
+    delivered.push(count);
+
+    // Oldest first: x, y, buttons, modifiers, timestamp
+    assert.deepEqual([samples[0], samples[1], samples[2]], [10, 20, 0]);
+    assert.deepEqual([samples[5], samples[6], samples[7]],
+                     [30, 40, qt.MouseButton.LeftButton]);
+    assert.ok(samples[9] >= samples[4]);
+  }, 16);
+
+  widget.show();
+  app.processEvents();
+
+  // Moves are delivered together, before the press that follows them
+  var events = new qt.QTestEventList();
+  events.addMouseMove(10, 20);
+  events.addMouseMove(30, 40, qt.MouseButton.LeftButton);
+  events.addMouseClick(qt.MouseButton.LeftButton);
+  events.simulate(widget);
+  app.processEvents();
+  assert.deepEqual(delivered, [2, 'press']);
+
+  widget.coalescedMouseMoveEvent(null);
+  widget.close();
+}
+
+// Reusable event objects
+{
+  var widget = new qt.QWidget;
+  var received = [];
+
+  assert.equal(widget.reuseEventObjects(), false);
+  widget.setReuseEventObjects(true);
+  assert.equal(widget.reuseEventObjects(), true);
+
+  widget.mousePressEvent(function(e) {
+    received.push({ object: e, button: e.button() });
+  });
+
+  widget.show();
+  app.processEvents();
+
+  var events = new qt.QTestEventList();
+  events.addMouseClick(qt.MouseButton.LeftButton);
+  events.addMouseClick(qt.MouseButton.RightButton);
+  events.simulate(widget);
+  app.processEvents();
+
+  assert.equal(received.length, 2);
+  assert.equal(received[0].button, qt.MouseButton.LeftButton);
+  assert.equal(received[1].button, qt.MouseButton.RightButton);
+  assert.strictEqual(received[0].object, received[1].object);
+
+  // Pooled objects are invalid outside their callback
+  assert.throws(function() {
+    received[0].object.button();
+  });
+
+  widget.close();
+}
+
+// Damage regions
+{
+  var widget = new qt.QWidget;
+  var regions = [];
+
+  widget.resize(200, 200);
+  widget.paintEvent(function(region) {
+    regions.push(region);
+
+    var p = new qt.QPainter();
+    p.begin(widget);
+    p.fillRect(0, 0, 200, 200, qt.GlobalColor.red);
+    p.end();
+  });
+
+  widget.show();
+  app.processEvents();
+
+  assert.ok(regions.length > 0);
+  assert.ok(regions[0] instanceof Int32Array);
+  assert.equal(regions[0].length % 4, 0);
+
+  // Partial repaint only exposes the given rect
+  regions = [];
+  widget.repaint(10, 20, 30, 40);
+  assert.equal(regions.length, 1);
+  assert.deepEqual(Array.prototype.slice.call(regions[0]), [10, 20, 30, 40]);
+
+  regions = [];
+  widget.update(5, 5, 10, 10);
+  app.processEvents();
+  assert.equal(regions.length, 1);
+  assert.equal(regions[0][0], 5);
+  assert.equal(regions[0][1], 5);
+
+  widget.close();
+}
+
+// Render thread
+{
+  var widget = new qt.QWidget;
+  var pending = 1;
+  var paints = 0;
+
+  widget.resize(100, 100);
+  widget.paintEvent(function() {
+    paints++;
+  });
+
+  assert.equal(widget.renderThread(), 0);
+  assert.throws(function() {
+    widget.submitFrame(new qt.PaintCommandBuffer());
+  }, Error);
+
+  widget.setRenderThread(1);
+  assert.equal(widget.renderThread(), 1);
+  widget.show();
+  app.processEvents();
+  paints = 0;
+
+  var cmd = new qt.PaintCommandBuffer();
+  cmd.fillRect(0, 0, 100, 100, 0xffff0000);
+
+  assert.throws(function() {
+    widget.submitFrame(new Float64Array([999]));
+  }, RangeError);
+
+  // One frame in flight: the second is dropped until the first is presented
+  assert.equal(widget.submitFrame(cmd, function() {
+    // Presenting a frame doesn't call the paint callback
+    assert.equal(paints, 0);
+    assert.equal(widget.submitFrame(cmd), true);
+    widget.setRenderThread(0);
+    widget.close();
+    pending--;
+  }), true);
+  assert.equal(widget.submitFrame(cmd), false);
+
+  process.on('exit', function() {
+    assert.equal(pending, 0);
+  });
+}
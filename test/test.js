@@ -1,5 +1,6 @@
 var fs = require('fs'),
-    path = require('path');
+    path = require('path'),
+    qt = require('..');
 
 var testDir = __dirname+'/img-test/',
     refDir = __dirname+'/img-ref/';
@@ -20,9 +21,19 @@ exports.regression = function(name, pixmap, callback) {
     return;
   }
   
-  var testBuf = fs.readFileSync(testDir+name+'.png');
-  var refBuf = fs.readFileSync(refDir+name+'.png');
-  if (testBuf.toString() !== refBuf.toString()) {
-    console.log('!!! image regression in test:', name);
+  // Compare decoded pixels: PNG bytes differ across zlib and Qt versions
+  var ref = new qt.QImage(refDir+name+'.png');
+  var image = pixmap.toImage ? pixmap.toImage() : pixmap;
+  if (ref.width() !== image.width() || ref.height() !== image.height()) {
+    console.log('!!! image regression in test:', name, '(size differs)');
+    return;
+  }
+
+  var result = qt.compareImages(image, ref, { tolerance: 1 });
+  if (result.mismatched) {
+    var b = result.bounds;
+    console.log('!!! image regression in test:', name, '('+result.mismatched+
+                ' pixels, max delta '+result.maxDelta+', in '+b.width+'x'+
+                b.height+' at '+b.x+','+b.y+')');
   }
 }